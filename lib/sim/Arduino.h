@@ -0,0 +1,105 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Arduino core stand-in for the host simulation (env:native)
+ *
+ * Time comes from the virtual clock of sim.h, pins from its pin model,
+ * Serial goes to stdout. Flash and RAM are the same on the host, so the
+ * PROGMEM helpers map to the plain C functions. String and Print follow
+ * the ESP cores, String allocating through realloc() with an 11 byte
+ * small string buffer, so the allocation profile (heapguard.h) sees the
+ * same allocations it would on the device.
+ */
+
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARDUINO_SIM 1
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT        0x0
+#define OUTPUT       0x1
+#define INPUT_PULLUP 0x2
+
+#define CHANGE  1
+#define FALLING 2
+#define RISING  3
+
+// Flash is RAM on the host
+#define PROGMEM
+#define PGM_P const char *
+#define PSTR(s) (s)
+#define F(s) (reinterpret_cast<const __FlashStringHelper *>(s))
+#define FPSTR(p) (reinterpret_cast<const __FlashStringHelper *>(p))
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t *)(addr))
+#define pgm_read_ptr(addr) (*(void *const *)(addr))
+#define strcpy_P strcpy
+#define strncpy_P strncpy
+#define strlen_P strlen
+#define strcmp_P strcmp
+#define memcpy_P memcpy
+#define snprintf_P snprintf
+#define sprintf_P sprintf
+
+// I2C lines of the simulated board
+static const uint8_t SDA = 21;
+static const uint8_t SCL = 22;
+
+#define DEC 10
+#define HEX 16
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+class __FlashStringHelper;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t level);
+void attachInterrupt(uint8_t interrupt, void (*isr)(), int mode);
+void detachInterrupt(uint8_t interrupt);
+inline uint8_t digitalPinToInterrupt(uint8_t pin) { return pin; }
+
+inline uint16_t word(uint8_t high, uint8_t low) { return (uint16_t)high << 8 | low; }
+#define highByte(w) ((uint8_t)((w) >> 8))
+#define lowByte(w) ((uint8_t)((w) & 0xFF))
+
+void setup();
+void loop();
+
+#include "WString.h"
+#include "Print.h"
+#include "HardwareSerial.h"
+
+#endif // ARDUINO_H
@@ -0,0 +1,52 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Serial port stand-in (env:native)
+ *
+ * Output is kept for the test (simSerialOutput()) and echoed to stdout;
+ * input is whatever the test queued with simSerialInput().
+ */
+
+#ifndef HARDWARESERIAL_H
+#define HARDWARESERIAL_H
+
+#include "Print.h"
+
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+};
+
+class HardwareSerial : public Stream {
+public:
+  void begin(unsigned long baud) { (void)baud; }
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t *buf, size_t size) override;
+  using Print::write;
+  int available() override;
+  int read() override;
+  int peek() override;
+  operator bool() const { return true; }
+};
+
+extern HardwareSerial Serial;
+
+#endif // HARDWARESERIAL_H
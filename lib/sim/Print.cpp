@@ -0,0 +1,46 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <Arduino.h>
+
+size_t Print::write(const uint8_t *buf, size_t size) {
+  size_t n = 0;
+  while (size--) n += write(*buf++);
+  return n;
+}
+
+size_t Print::write(const char *str) {
+  return str ? write((const uint8_t *)str, strlen(str)) : 0;
+}
+
+size_t Print::print(const __FlashStringHelper *str) {
+  return write((const char *)str);
+}
+
+size_t Print::print(long value, int base) {
+  if (base == DEC_BASE && value < 0) {
+    return print('-') + printNumber(-(unsigned long)value, base);
+  }
+  return printNumber(value, base);
+}
+
+size_t Print::printNumber(unsigned long value, int base) {
+  char buf[24];
+  int len = snprintf(buf, sizeof(buf), base == 16 ? "%lX" : "%lu", value);
+  return write(buf, len);
+}
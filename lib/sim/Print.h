@@ -0,0 +1,71 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Arduino Print and Printable stand-ins (env:native)
+ */
+
+#ifndef PRINT_H
+#define PRINT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "WString.h"
+
+class Print;
+
+class Printable {
+public:
+  virtual ~Printable() {}
+  virtual size_t printTo(Print &p) const = 0;
+};
+
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buf, size_t size);
+  size_t write(const char *buf, size_t size) { return write((const uint8_t *)buf, size); }
+  size_t write(const char *str);
+
+  size_t print(const __FlashStringHelper *str);
+  size_t print(const String &str) { return write(str.c_str(), str.length()); }
+  size_t print(const char *str) { return write(str); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(unsigned char value, int base = DEC_BASE) { return printNumber(value, base); }
+  size_t print(int value, int base = DEC_BASE) { return print((long)value, base); }
+  size_t print(unsigned int value, int base = DEC_BASE) { return printNumber(value, base); }
+  size_t print(long value, int base = DEC_BASE);
+  size_t print(unsigned long value, int base = DEC_BASE) { return printNumber(value, base); }
+  size_t print(const Printable &value) { return value.printTo(*this); }
+
+  size_t println() { return write("\r\n"); }
+  template <typename T>
+  size_t println(const T &value) { size_t n = print(value); return n + println(); }
+  template <typename T>
+  size_t println(T value, int base) { size_t n = print(value, base); return n + println(); }
+
+  virtual void flush() {}
+
+private:
+  static const int DEC_BASE = 10;
+  size_t printNumber(unsigned long value, int base);
+};
+
+#endif // PRINT_H
@@ -0,0 +1,40 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Ticker stand-in (env:native)
+ *
+ * The callback runs whenever the virtual clock passes its period, even
+ * in the middle of a loop pass, like the ESP32 timer task does.
+ */
+
+#ifndef TICKER_H
+#define TICKER_H
+
+#include <Arduino.h>
+
+#include "sim.h"
+
+class Ticker {
+public:
+  ~Ticker() { detach(); }
+  void attach_ms(uint32_t ms, void (*callback)()) { simAttachTicker(this, ms * 1000, callback); }
+  void detach() { simDetachTicker(this); }
+};
+
+#endif // TICKER_H
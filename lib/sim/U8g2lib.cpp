@@ -0,0 +1,137 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <Arduino.h>
+#include <U8g2lib.h>
+
+#include "sim.h"
+
+const uint8_t u8g2_font_5x7_tr[] = {5, 7, 6};
+const uint8_t u8g2_font_6x10_tr[] = {6, 10, 7};
+const uint8_t u8g2_font_6x10_tf[] = {6, 10, 7};
+const uint8_t u8g2_font_7x13B_tr[] = {7, 13, 10};
+const uint8_t u8g2_font_10x20_tn[] = {10, 20, 15};
+
+static const u8g2_cb_t u8g2Rotation0 = {0};
+static const u8g2_cb_t u8g2Rotation2 = {2};
+const u8g2_cb_t *const U8G2_R0 = &u8g2Rotation0;
+const u8g2_cb_t *const U8G2_R2 = &u8g2Rotation2;
+
+U8G2::U8G2(const u8g2_cb_t *rotation) : rotation(rotation) {
+  clearBuffer();
+}
+
+void U8G2::clearBuffer() {
+  memset(buffer, 0, sizeof(buffer));
+  text.clear();
+}
+
+/**
+ * @brief Send the whole frame: 504 bytes at 4 MHz
+ */
+void U8G2::sendBuffer() {
+  size_t bytes = WIDTH * TILE_HEIGHT;
+  simAdvance(bytes * SIM_SPI_BYTE_NS / 1000);
+  simDisplayFrame(bytes, true, text);
+}
+
+/**
+ * @brief Send a rectangle of tiles
+ */
+void U8G2::updateDisplayArea(uint8_t tx, uint8_t ty, uint8_t tw, uint8_t th) {
+  (void)tx;
+  (void)ty;
+  size_t bytes = (size_t)tw * 8 * th;
+  simAdvance(bytes * SIM_SPI_BYTE_NS / 1000);
+  simDisplayFrame(bytes, false, text);
+}
+
+/**
+ * @brief Set or clear a pixel, in rotated screen coordinates
+ */
+void U8G2::drawPixel(int x, int y) {
+  if (x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT) return;
+  if (rotation->rotation == 2) {
+    x = WIDTH - 1 - x;
+    y = HEIGHT - 1 - y;
+  }
+  uint8_t &b = buffer[(y / 8) * TILE_WIDTH * 8 + x];
+  uint8_t mask = 1 << (y % 8);
+  if (drawColor) b |= mask;
+  else b &= ~mask;
+}
+
+void U8G2::drawHLine(int x, int y, int w) {
+  for (int i = 0; i < w; i++) drawPixel(x + i, y);
+}
+
+void U8G2::drawVLine(int x, int y, int h) {
+  for (int i = 0; i < h; i++) drawPixel(x, y + i);
+}
+
+void U8G2::drawBox(int x, int y, int w, int h) {
+  for (int i = 0; i < h; i++) drawHLine(x, y + i, w);
+}
+
+/**
+ * @brief Draw one glyph with its baseline at y
+ *
+ * @return Advance width
+ */
+int U8G2::drawGlyph(int x, int y, char c) {
+  uint8_t width = font[0];
+  uint8_t ascent = font[2];
+  if (c != ' ') {
+    for (int col = 0; col < width - 1; col++) {
+      for (int row = 0; row < ascent; row++) {
+        if ((c + col * 3 + row) % 4 != 0) drawPixel(x + col, y - ascent + row);
+      }
+    }
+  }
+  return width;
+}
+
+void U8G2::setCursor(int x, int y) {
+  simHostEnter();
+  if (!text.empty()) text += '|';
+  simHostLeave();
+  tx = x;
+  ty = y;
+}
+
+int U8G2::drawStr(int x, int y, const char *str) {
+  simHostEnter();
+  if (!text.empty()) text += '|';
+  text += str;
+  simHostLeave();
+  int start = x;
+  for (; *str; str++) x += drawGlyph(x, y, *str);
+  return x - start;
+}
+
+int U8G2::getStrWidth(const char *str) const {
+  return strlen(str) * font[0];
+}
+
+size_t U8G2::write(uint8_t c) {
+  simHostEnter();
+  text += (char)c;
+  simHostLeave();
+  tx += drawGlyph(tx, ty, c);
+  return 1;
+}
@@ -0,0 +1,105 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * U8g2 stand-in for the Nokia 5110 (env:native)
+ *
+ * A full frame buffer laid out as U8g2 lays it out for the PCD8544 (11
+ * tiles of 8 columns by 6 pages, one byte per column and page), drawn
+ * with the U8G2_R2 rotation. Glyphs are blocks of the font cell with a
+ * pattern that depends on the character, so cached glyphs differ from
+ * one another like real ones. The text drawn since clearBuffer() is
+ * kept and handed to the simulation with each frame sent, and sending
+ * takes the time 4 MHz SPI would.
+ */
+
+#ifndef U8G2LIB_H
+#define U8G2LIB_H
+
+#include <Arduino.h>
+#include <string>
+
+// Font: cell width, cell height, ascent
+extern const uint8_t u8g2_font_5x7_tr[];
+extern const uint8_t u8g2_font_6x10_tr[];
+extern const uint8_t u8g2_font_6x10_tf[];
+extern const uint8_t u8g2_font_7x13B_tr[];
+extern const uint8_t u8g2_font_10x20_tn[];
+
+struct u8g2_cb_t {
+  uint8_t rotation;
+};
+extern const u8g2_cb_t *const U8G2_R0;
+extern const u8g2_cb_t *const U8G2_R2;
+
+class U8G2 : public Print {
+public:
+  U8G2(const u8g2_cb_t *rotation);
+
+  void begin() {}
+  void enableUTF8Print() {}
+  void setFont(const uint8_t *font) { this->font = font; }
+  void setDrawColor(uint8_t color) { drawColor = color; }
+  void setCursor(int x, int y);
+
+  void clearBuffer();
+  void sendBuffer();
+  void updateDisplayArea(uint8_t tx, uint8_t ty, uint8_t tw, uint8_t th);
+
+  uint8_t *getBufferPtr() { return buffer; }
+  uint8_t getBufferTileWidth() const { return TILE_WIDTH; }
+  uint8_t getBufferTileHeight() const { return TILE_HEIGHT; }
+  uint8_t getDisplayWidth() const { return WIDTH; }
+  uint8_t getDisplayHeight() const { return HEIGHT; }
+
+  void drawPixel(int x, int y);
+  void drawHLine(int x, int y, int w);
+  void drawVLine(int x, int y, int h);
+  void drawBox(int x, int y, int w, int h);
+  int drawStr(int x, int y, const char *str);
+  int getStrWidth(const char *str) const;
+
+  size_t write(uint8_t c) override;
+  using Print::write;
+
+  int tx = 0;             // Cursor, as U8g2 exposes it
+  int ty = 0;
+
+private:
+  static const uint8_t WIDTH = 84;
+  static const uint8_t HEIGHT = 48;
+  static const uint8_t TILE_WIDTH = 11;
+  static const uint8_t TILE_HEIGHT = 6;
+
+  int drawGlyph(int x, int y, char c);
+
+  const u8g2_cb_t *rotation;
+  const uint8_t *font = u8g2_font_6x10_tr;
+  uint8_t drawColor = 1;
+  uint8_t buffer[TILE_WIDTH * 8 * TILE_HEIGHT];
+  std::string text;       // Drawn since clearBuffer()
+};
+
+// Display type of the board descriptors
+class U8G2_PCD8544_84X48_F_4W_HW_SPI : public U8G2 {
+public:
+  U8G2_PCD8544_84X48_F_4W_HW_SPI(const u8g2_cb_t *rotation, uint8_t cs, uint8_t dc, uint8_t reset)
+    : U8G2(rotation) { (void)cs; (void)dc; (void)reset; }
+};
+
+#endif // U8G2LIB_H
@@ -0,0 +1,102 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <Arduino.h>
+
+#include "sim.h"
+
+String::String(const char *str) : heap(NULL), len(0), capacity(SSO_SIZE - 1) {
+  sso[0] = '\0';
+  *this += str;
+}
+
+String::String(const __FlashStringHelper *str) : String((const char *)str) {
+}
+
+String::String(const String &str) : String(str.c_str()) {
+}
+
+String::~String() {
+  free(heap);
+}
+
+String &String::operator=(const String &str) {
+  if (this == &str) return *this;
+  return *this = str.c_str();
+}
+
+String &String::operator=(const char *str) {
+  len = 0;
+  buffer()[0] = '\0';
+  *this += str;
+  return *this;
+}
+
+/**
+ * @brief Make room for size characters, keeping the contents
+ *
+ * Grows the heap buffer with realloc(), the one allocation a String
+ * ever makes; a reserved String is not reallocated while it fits.
+ */
+bool String::reserve(size_t size) {
+  if (size <= capacity) return true;
+  char *buf = (char *)realloc(heap, size + 1);
+  if (!buf) return false;
+  simNoteAlloc();
+  if (!heap) memcpy(buf, sso, len + 1);
+  heap = buf;
+  capacity = size;
+  return true;
+}
+
+long String::toInt() const {
+  return strtol(buffer(), NULL, 10);
+}
+
+bool String::concat(const char *str, size_t n) {
+  if (!reserve(len + n)) return false;
+  memcpy(buffer() + len, str, n);
+  len += n;
+  buffer()[len] = '\0';
+  return true;
+}
+
+String &String::operator+=(const char *str) {
+  if (str) concat(str, strlen(str));
+  return *this;
+}
+
+String &String::operator+=(const __FlashStringHelper *str) {
+  return *this += (const char *)str;
+}
+
+String &String::appendSigned(long value) {
+  char buf[24];
+  concat(buf, snprintf(buf, sizeof(buf), "%ld", value));
+  return *this;
+}
+
+String &String::appendUnsigned(unsigned long value) {
+  char buf[24];
+  concat(buf, snprintf(buf, sizeof(buf), "%lu", value));
+  return *this;
+}
+
+bool String::operator==(const char *str) const {
+  return strcmp(buffer(), str ? str : "") == 0;
+}
@@ -0,0 +1,78 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Arduino String stand-in (env:native)
+ *
+ * Up to SSO_SIZE - 1 characters live inside the object; longer strings
+ * are on the heap and grow through realloc(), as on the ESP cores.
+ */
+
+#ifndef WSTRING_H
+#define WSTRING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+class __FlashStringHelper;
+
+class String {
+public:
+  String(const char *str = "");
+  String(const __FlashStringHelper *str);
+  String(const String &str);
+  ~String();
+
+  String &operator=(const String &str);
+  String &operator=(const char *str);
+
+  bool reserve(size_t size);
+  size_t length() const { return len; }
+  const char *c_str() const { return buffer(); }
+  long toInt() const;
+
+  bool concat(const char *str, size_t n);
+  String &operator+=(const String &str) { concat(str.c_str(), str.length()); return *this; }
+  String &operator+=(const char *str);
+  String &operator+=(const __FlashStringHelper *str);
+  String &operator+=(char c) { concat(&c, 1); return *this; }
+  String &operator+=(unsigned char value) { return appendUnsigned(value); }
+  String &operator+=(int value) { return appendSigned(value); }
+  String &operator+=(unsigned int value) { return appendUnsigned(value); }
+  String &operator+=(long value) { return appendSigned(value); }
+  String &operator+=(unsigned long value) { return appendUnsigned(value); }
+
+  bool operator==(const char *str) const;
+  bool operator==(const String &str) const { return *this == str.c_str(); }
+  bool operator!=(const char *str) const { return !(*this == str); }
+
+private:
+  static const size_t SSO_SIZE = 12;
+
+  char *buffer() { return heap ? heap : sso; }
+  const char *buffer() const { return heap ? heap : sso; }
+  String &appendSigned(long value);
+  String &appendUnsigned(unsigned long value);
+
+  char sso[SSO_SIZE];
+  char *heap;
+  size_t len;
+  size_t capacity;        // Characters that fit, terminator excluded
+};
+
+#endif // WSTRING_H
@@ -0,0 +1,151 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <Arduino.h>
+#include <WebServer.h>
+
+// Bytes of a response header
+const size_t SIM_HTTP_HEADER = 128;
+
+void WebServer::on(const char *path, Handler handler) {
+  if (routeCount < MAX_ROUTES) routes[routeCount++] = {path, handler};
+}
+
+/**
+ * @brief Split a request into its path and arguments
+ */
+void WebServer::parse(const char *request) {
+  const char *query = strchr(request, '?');
+  uri = "";
+  uri.concat(request, query ? query - request : strlen(request));
+  argCount = 0;
+  while (query && argCount < MAX_ARGS) {
+    const char *start = query + 1;
+    query = strchr(start, '&');
+    size_t length = query ? query - start : strlen(start);
+    const char *eq = (const char *)memchr(start, '=', length);
+    size_t name = eq ? eq - start : length;
+    argNames[argCount] = "";
+    argNames[argCount].concat(start, name);
+    argValues[argCount] = "";
+    if (eq) argValues[argCount].concat(eq + 1, length - name - 1);
+    argCount++;
+  }
+}
+
+/**
+ * @brief Serve the next scripted request, if there is one
+ */
+void WebServer::handleClient() {
+  std::string request;
+  if (!simTakeRequest(request)) return;
+  simAdvance(SIM_HTTP_REQUEST_US);
+
+  simHostEnter();
+  response = SimResponse();
+  simHostLeave();
+  response.code = 0;
+  simLibraryEnter();
+  parse(request.c_str());
+  const Route *route = NULL;
+  for (uint8_t i = 0; i < routeCount; i++) {
+    if (uri == routes[i].uri) route = &routes[i];
+  }
+  simLibraryLeave();
+
+  if (route) route->handler();
+  else send(404, "text/plain", "Not found");
+  simResponseSent(response);
+}
+
+bool WebServer::hasArg(const String &name) const {
+  for (uint8_t i = 0; i < argCount; i++) {
+    if (argNames[i] == name) return true;
+  }
+  return false;
+}
+
+/**
+ * @brief Get an argument, by value like the real library
+ *
+ * The copy is made in the caller's scope, so a handler pays for it.
+ */
+String WebServer::arg(const String &name) const {
+  for (uint8_t i = 0; i < argCount; i++) {
+    if (argNames[i] == name) return argValues[i];
+  }
+  return String();
+}
+
+void WebServer::sendHeader(const String &name, const String &value, bool first) {
+  (void)first;
+  simHostEnter();
+  if (name == "Location") response.location = value.c_str();
+  simHostLeave();
+}
+
+/**
+ * @brief Send the status line and headers, then the content
+ *
+ * The header is built in a String, as the real library does.
+ */
+void WebServer::send(int code, const char *type, const String &content) {
+  simLibraryEnter();
+  String header;
+  header.reserve(SIM_HTTP_HEADER);
+  header += "HTTP/1.1 ";
+  header += code;
+  simLibraryLeave();
+  response.code = code;
+  simHostEnter();
+  response.type = type ? type : "";
+  simHostLeave();
+  simAdvance(SIM_HTTP_HEADER * SIM_HTTP_BYTE_NS / 1000);
+  body(content.c_str(), content.length());
+}
+
+void WebServer::send(int code, const char *type, const char *content) {
+  send(code, type, String());
+  body(content, strlen(content));
+}
+
+void WebServer::sendContent(const String &content) {
+  body(content.c_str(), content.length());
+}
+
+void WebServer::sendContent(const char *content, size_t length) {
+  body(content, length);
+}
+
+void WebServer::sendContent_P(PGM_P content) {
+  body(content, strlen(content));
+}
+
+void WebServer::sendContent_P(PGM_P content, size_t length) {
+  body(content, length);
+}
+
+/**
+ * @brief Add to the response body, at network speed
+ */
+void WebServer::body(const char *content, size_t length) {
+  simHostEnter();
+  response.body.append(content, length);
+  simHostLeave();
+  simAdvance(length * SIM_HTTP_BYTE_NS / 1000);
+}
@@ -0,0 +1,85 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * WebServer stand-in (env:native)
+ *
+ * The API of the ESP32 WebServer, with its String parameters, so handler
+ * code makes the same temporaries it makes on the device. Requests come
+ * from simRequest(), one per handleClient(); the response is handed back
+ * to the simulation once the handler returns.
+ *
+ * Like the real library it allocates on its own: the URI and arguments
+ * of each request and the response header are Strings. Those
+ * allocations are counted apart (simLibraryAllocs()), so a test can
+ * tell them from the handlers' own. arg() copies the value in the
+ * caller's scope, where the handler pays for it as on the device.
+ */
+
+#ifndef WEBSERVER_H
+#define WEBSERVER_H
+
+#include <Arduino.h>
+
+#include "sim.h"
+
+#define CONTENT_LENGTH_UNKNOWN ((size_t)-1)
+
+class WebServer {
+public:
+  typedef void (*Handler)();
+
+  WebServer(int port) { (void)port; }
+  void begin() {}
+  void on(const char *uri, Handler handler);
+  void handleClient();
+
+  bool hasArg(const String &name) const;
+  String arg(const String &name) const;
+
+  void setContentLength(size_t length) { (void)length; }
+  void sendHeader(const String &name, const String &value, bool first = false);
+  void send(int code, const char *type = NULL, const String &content = String(""));
+  void send(int code, const char *type, const char *content);
+  void sendContent(const String &content);
+  void sendContent(const char *content, size_t length);
+  void sendContent_P(PGM_P content);
+  void sendContent_P(PGM_P content, size_t length);
+
+private:
+  static const uint8_t MAX_ROUTES = 24;
+  static const uint8_t MAX_ARGS = 8;
+
+  struct Route {
+    const char *uri;
+    Handler handler;
+  };
+
+  void body(const char *content, size_t length);
+  void parse(const char *request);
+
+  Route routes[MAX_ROUTES];
+  uint8_t routeCount = 0;
+  String uri;
+  String argNames[MAX_ARGS];
+  String argValues[MAX_ARGS];
+  uint8_t argCount = 0;
+  SimResponse response;
+};
+
+#endif // WEBSERVER_H
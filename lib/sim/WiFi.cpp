@@ -0,0 +1,53 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+WiFiClass WiFi;
+
+size_t IPAddress::printTo(Print &p) const {
+  size_t n = 0;
+  for (uint8_t i = 0; i < 4; i++) {
+    if (i) n += p.print('.');
+    n += p.print(octets[i]);
+  }
+  return n;
+}
+
+bool WiFiClass::softAP(const char *ssid, const char *password) {
+  (void)ssid;
+  (void)password;
+  return true;
+}
+
+void WiFiClass::begin(const char *ssid, const char *password) {
+  (void)ssid;
+  (void)password;
+  connecting = true;
+  beganAt = millis();
+}
+
+wl_status_t WiFiClass::status() {
+  if (connecting && millis() - beganAt >= SIM_WIFI_CONNECT_MS) return WL_CONNECTED;
+  return WL_DISCONNECTED;
+}
+
+IPAddress WiFiClass::localIP() {
+  return status() == WL_CONNECTED ? IPAddress(192, 168, 1, 50) : IPAddress();
+}
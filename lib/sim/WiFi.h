@@ -0,0 +1,63 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * WiFi stand-in (env:native)
+ *
+ * The access point is up at once; a station connection succeeds
+ * SIM_WIFI_CONNECT_MS after WiFi.begin().
+ */
+
+#ifndef WIFI_H
+#define WIFI_H
+
+#include <Arduino.h>
+
+const unsigned long SIM_WIFI_CONNECT_MS = 1500;
+
+enum wl_status_t {
+  WL_IDLE_STATUS = 0,
+  WL_CONNECTED = 3,
+  WL_DISCONNECTED = 6
+};
+
+class IPAddress : public Printable {
+public:
+  IPAddress(uint8_t a = 0, uint8_t b = 0, uint8_t c = 0, uint8_t d = 0) : octets{a, b, c, d} {}
+  size_t printTo(Print &p) const override;
+
+private:
+  uint8_t octets[4];
+};
+
+class WiFiClass {
+public:
+  bool softAP(const char *ssid, const char *password = NULL);
+  IPAddress softAPIP() { return IPAddress(192, 168, 4, 1); }
+  void begin(const char *ssid, const char *password);
+  wl_status_t status();
+  IPAddress localIP();
+
+private:
+  bool connecting = false;
+  unsigned long beganAt = 0;
+};
+
+extern WiFiClass WiFi;
+
+#endif // WIFI_H
@@ -0,0 +1,77 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#include "sim.h"
+#include "simtuner.h"
+
+TwoWire Wire;
+
+// Wire.endTransmission() status of a chip that does not answer
+const uint8_t WIRE_NACK_ADDRESS = 2;
+
+void TwoWire::begin() {
+  simWireBegin();
+}
+
+void TwoWire::end() {
+}
+
+void TwoWire::beginTransmission(uint8_t address) {
+  txAddress = address;
+  txLength = 0;
+}
+
+size_t TwoWire::write(uint8_t c) {
+  if (txLength >= BUFFER_SIZE) return 0;
+  txBuffer[txLength++] = c;
+  return 1;
+}
+
+/**
+ * @brief Send the queued bytes to the addressed chip
+ *
+ * @return 0 on success, 2 if the address was not acknowledged, 5 if the
+ *         bus was held
+ */
+uint8_t TwoWire::endTransmission(bool stop) {
+  (void)stop;
+  simAdvance(SIM_I2C_START_STOP_US + (1 + txLength) * SIM_I2C_BYTE_US);
+  uint8_t error = simI2cTransfer();
+  if (error) return error;
+  if (!simTunerWrite(txAddress, txBuffer, txLength)) return WIRE_NACK_ADDRESS;
+  return 0;
+}
+
+/**
+ * @brief Read from the addressed chip
+ *
+ * @return Bytes read, 0 if the transfer failed
+ */
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, bool stop) {
+  (void)stop;
+  if (quantity > BUFFER_SIZE) quantity = BUFFER_SIZE;
+  rxIndex = 0;
+  rxLength = 0;
+  simAdvance(SIM_I2C_START_STOP_US + (1 + quantity) * SIM_I2C_BYTE_US);
+  if (simI2cTransfer() || !simTunerRead(address, rxBuffer, quantity)) return 0;
+  rxLength = quantity;
+  return quantity;
+}
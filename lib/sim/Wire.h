@@ -0,0 +1,67 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Wire stand-in (env:native)
+ *
+ * Transfers go to the RDA5807 model of simtuner.h and take the time
+ * they would at 100 kHz. simI2cNack() makes the next transfers fail with
+ * a NACK on the address (error 2), simI2cHoldSda() makes a slave hold
+ * SDA low, failing transfers with a timeout (error 5) until enough SCL
+ * pulses have been clocked by hand (see tunerbus.cpp).
+ */
+
+#ifndef WIRE_H
+#define WIRE_H
+
+#include "Arduino.h"
+
+// Like the AVR core: setWireTimeout() exists, a timeout is error 5
+#define WIRE_HAS_TIMEOUT
+
+class TwoWire : public Stream {
+public:
+  void begin();
+  void end();
+  void setClock(uint32_t frequency) { (void)frequency; }
+  void setWireTimeout(uint32_t timeout, bool reset) { (void)timeout; (void)reset; }
+
+  void beginTransmission(uint8_t address);
+  uint8_t endTransmission(bool stop = true);
+  uint8_t requestFrom(uint8_t address, uint8_t quantity, bool stop = true);
+  uint8_t requestFrom(int address, int quantity) { return requestFrom((uint8_t)address, (uint8_t)quantity); }
+
+  size_t write(uint8_t c) override;
+  using Print::write;
+  int available() override { return rxLength - rxIndex; }
+  int read() override { return rxIndex < rxLength ? rxBuffer[rxIndex++] : -1; }
+  int peek() override { return rxIndex < rxLength ? rxBuffer[rxIndex] : -1; }
+
+private:
+  static const uint8_t BUFFER_SIZE = 32;
+  uint8_t txAddress = 0;
+  uint8_t txBuffer[BUFFER_SIZE];
+  uint8_t txLength = 0;
+  uint8_t rxBuffer[BUFFER_SIZE];
+  uint8_t rxLength = 0;
+  uint8_t rxIndex = 0;
+};
+
+extern TwoWire Wire;
+
+#endif // WIRE_H
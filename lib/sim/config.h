@@ -0,0 +1,31 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Configuration of the host simulation (env:native), used when there is
+// no src/config.h; features are enabled by the build flags of the
+// native environments in platformio.ini
+
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#define WIFI_SSID "sim-ssid"
+#define WIFI_PASSWORD "sim-password"
+
+#define AP_SSID "FM_Radio_AP"
+
+#endif
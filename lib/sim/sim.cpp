@@ -0,0 +1,528 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <Arduino.h>
+
+#include <deque>
+
+#include "sim.h"
+
+const uint8_t SIM_PINS = 64;
+// Time between two edges of a scripted encoder turn, us
+const uint32_t SIM_ENCODER_EDGE_US = 500;
+
+/**
+ * @brief One simulated pin
+ */
+struct SimPin {
+  uint8_t mode;
+  uint8_t output;         // Level driven as an output
+  uint8_t external;       // Level outside, pull-up high unless driven
+  SimIsr isr;
+  int isrMode;
+};
+
+/**
+ * @brief A periodic timer callback
+ */
+struct SimTicker {
+  void *owner;
+  uint32_t period;
+  uint64_t next;
+  void (*callback)();
+};
+
+/**
+ * @brief A request waiting for the web server
+ */
+struct SimPendingRequest {
+  std::string uri;
+  size_t latency;         // Index in simLatencyLog
+};
+
+uint64_t simNow = 0;
+bool simInTicker = false;
+std::vector<SimTicker> simTickers;
+SimPin simPins[SIM_PINS];
+std::vector<uint8_t> simSerialOut;
+std::deque<uint8_t> simSerialIn;
+bool simEcho = true;
+std::deque<SimPendingRequest> simRequests;
+size_t simServing = (size_t)-1;     // Latency index of the request being served
+SimResponse simResponse;
+unsigned long simLibraryDepth = 0;
+unsigned long simLibraryCount = 0;
+unsigned long simHostDepth = 0;
+bool simLooping = false;
+unsigned long simFrameCount = 0;
+unsigned long simAreaCount = 0;
+std::string simText;
+uint8_t simNackPending = 0;
+uint8_t simSdaHold = 0;              // SCL pulses until the slave lets go
+SimI2cStats simI2c;
+std::vector<SimLatency> simLatencyLog;
+
+HardwareSerial Serial;
+
+/**
+ * @brief Pins at power on: inputs, pulled up
+ */
+static struct SimPowerOn {
+  SimPowerOn() {
+    for (uint8_t i = 0; i < SIM_PINS; i++) {
+      simPins[i] = {INPUT, HIGH, HIGH, NULL, 0};
+    }
+  }
+} simPowerOn;
+
+// Clock
+
+uint64_t simMicros() {
+  return simNow;
+}
+
+/**
+ * @brief Move the clock on, running the tickers that fall due meanwhile
+ */
+void simAdvance(uint64_t us) {
+  uint64_t target = simNow + us;
+  while (!simInTicker) {
+    SimTicker *due = NULL;
+    for (SimTicker &t : simTickers) {
+      if (t.next <= target && (!due || t.next < due->next)) due = &t;
+    }
+    if (!due) break;
+    simNow = due->next;
+    due->next += due->period;
+    simInTicker = true;
+    due->callback();
+    simInTicker = false;
+  }
+  simNow = target;
+}
+
+/**
+ * @brief Run loop() until ms milliseconds have passed
+ */
+void simRun(unsigned long ms) {
+  uint64_t end = simNow + (uint64_t)ms * 1000;
+  while (simNow < end) {
+    uint64_t before = simNow;
+    simLooping = true;
+    loop();
+    simLooping = false;
+    if (simNow == before) simAdvance(1);
+  }
+}
+
+void simAttachTicker(void *owner, uint32_t periodUs, void (*callback)()) {
+  simDetachTicker(owner);
+  simTickers.push_back({owner, periodUs, simNow + periodUs, callback});
+}
+
+void simDetachTicker(void *owner) {
+  for (size_t i = 0; i < simTickers.size(); i++) {
+    if (simTickers[i].owner == owner) {
+      simTickers.erase(simTickers.begin() + i);
+      return;
+    }
+  }
+}
+
+unsigned long millis() {
+  return (uint32_t)(simNow / 1000);
+}
+
+unsigned long micros() {
+  return (uint32_t)simNow;
+}
+
+void delay(unsigned long ms) {
+  simAdvance((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+  simAdvance(us);
+}
+
+void yield() {
+}
+
+// Pins
+
+/**
+ * @brief Level on a pin: driven low as an output, else what is outside;
+ * SDA also reads low while a slave holds it
+ */
+static uint8_t simLevel(uint8_t pin) {
+  if (pin >= SIM_PINS) return LOW;
+  if (pin == SDA && simSdaHold) return LOW;
+  if (simPins[pin].mode == OUTPUT) return simPins[pin].output;
+  return simPins[pin].external;
+}
+
+/**
+ * @brief Follow the I2C lines driven by hand: SCL pulses clock the
+ * stuck slave, SDA rising while SCL is high is a STOP
+ */
+static void simLineChanged(uint8_t pin, uint8_t before) {
+  uint8_t after = simLevel(pin);
+  if (before == after || after == LOW) return;
+  if (pin == SCL) {
+    simI2c.sclPulses++;
+    if (simSdaHold) simSdaHold--;
+  } else if (pin == SDA && simLevel(SCL) == HIGH) {
+    simI2c.stops++;
+  }
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin >= SIM_PINS) return;
+  uint8_t before = simLevel(pin);
+  simPins[pin].mode = mode;
+  simLineChanged(pin, before);
+}
+
+int digitalRead(uint8_t pin) {
+  return simLevel(pin);
+}
+
+void digitalWrite(uint8_t pin, uint8_t level) {
+  if (pin >= SIM_PINS) return;
+  uint8_t before = simLevel(pin);
+  simPins[pin].output = level ? HIGH : LOW;
+  simLineChanged(pin, before);
+}
+
+void attachInterrupt(uint8_t interrupt, void (*isr)(), int mode) {
+  simAttachInterrupt(interrupt, isr, mode);
+}
+
+void detachInterrupt(uint8_t interrupt) {
+  simAttachInterrupt(interrupt, NULL, 0);
+}
+
+void simAttachInterrupt(uint8_t pin, SimIsr isr, int mode) {
+  if (pin >= SIM_PINS) return;
+  simPins[pin].isr = isr;
+  simPins[pin].isrMode = mode;
+}
+
+/**
+ * @brief Drive a pin from outside, running its interrupt handler on a
+ * matching edge
+ */
+void simSetPin(uint8_t pin, bool level) {
+  if (pin >= SIM_PINS) return;
+  uint8_t before = simLevel(pin);
+  simPins[pin].external = level ? HIGH : LOW;
+  uint8_t after = simLevel(pin);
+  SimPin &p = simPins[pin];
+  if (before == after || !p.isr) return;
+  if (p.isrMode == CHANGE || (p.isrMode == RISING && after) || (p.isrMode == FALLING && !after)) {
+    p.isr();
+  }
+}
+
+/**
+ * @brief Record a scripted input, for the latency report
+ */
+void simInput(const char *label) {
+  simLatencyLog.push_back({label, simNow, -1, -1});
+}
+
+/**
+ * @brief Press an active low button (drive its pin low)
+ *
+ * @param label Input name in the latency report, NULL to leave it out
+ */
+void simPress(uint8_t pin, const char *label) {
+  if (label) simInput(label);
+  simSetPin(pin, LOW);
+}
+
+/**
+ * @brief Release an active low button
+ */
+void simRelease(uint8_t pin, const char *label) {
+  if (label) simInput(label);
+  simSetPin(pin, HIGH);
+}
+
+/**
+ * @brief Turn the encoder by whole detents, each one four phase edges
+ * SIM_ENCODER_EDGE_US apart
+ *
+ * The phases rest high. Clockwise (positive) is A falling first.
+ */
+void simEncoder(uint8_t pinA, uint8_t pinB, int detents, const char *label) {
+  static const uint8_t cw[4] = {0x01, 0x00, 0x02, 0x03};   // AB after each edge
+  static const uint8_t ccw[4] = {0x02, 0x00, 0x01, 0x03};
+  if (label) simInput(label);
+  const uint8_t *seq = detents >= 0 ? cw : ccw;
+  int count = detents >= 0 ? detents : -detents;
+  for (int i = 0; i < count; i++) {
+    for (uint8_t e = 0; e < 4; e++) {
+      simSetPin(pinA, seq[e] & 0x02);
+      simSetPin(pinB, seq[e] & 0x01);
+      simAdvance(SIM_ENCODER_EDGE_US);
+    }
+  }
+}
+
+// Serial
+
+size_t HardwareSerial::write(uint8_t c) {
+  simHostEnter();
+  simSerialOut.push_back(c);
+  simHostLeave();
+  if (simEcho) {
+    fputc(c, stdout);
+    if (c == '\n') fflush(stdout);
+  }
+  return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t *buf, size_t size) {
+  for (size_t i = 0; i < size; i++) write(buf[i]);
+  return size;
+}
+
+int HardwareSerial::available() {
+  return simSerialIn.size();
+}
+
+int HardwareSerial::read() {
+  if (simSerialIn.empty()) return -1;
+  uint8_t c = simSerialIn.front();
+  simSerialIn.pop_front();
+  return c;
+}
+
+int HardwareSerial::peek() {
+  return simSerialIn.empty() ? -1 : simSerialIn.front();
+}
+
+void simSerialInput(const char *text) {
+  while (*text) simSerialIn.push_back(*text++);
+}
+
+const std::vector<uint8_t> &simSerialOutput() {
+  return simSerialOut;
+}
+
+void simSerialClear() {
+  simSerialOut.clear();
+}
+
+void simSerialEcho(bool echo) {
+  simEcho = echo;
+}
+
+// HTTP
+
+/**
+ * @brief Queue a request for the web server, e.g. "/preview?dwell=3"
+ */
+void simRequest(const char *uri) {
+  simInput(uri);
+  simRequests.push_back({uri, simLatencyLog.size() - 1});
+}
+
+bool simRequestPending() {
+  return !simRequests.empty();
+}
+
+bool simTakeRequest(std::string &request) {
+  if (simRequests.empty()) return false;
+  simHostEnter();
+  request = simRequests.front().uri;
+  simServing = simRequests.front().latency;
+  simRequests.pop_front();
+  simHostLeave();
+  return true;
+}
+
+void simResponseSent(const SimResponse &response) {
+  simHostEnter();
+  simResponse = response;
+  simHostLeave();
+  if (simServing < simLatencyLog.size()) simLatencyLog[simServing].response = simNow;
+  simServing = (size_t)-1;
+}
+
+const SimResponse &simLastResponse() {
+  return simResponse;
+}
+
+void simLibraryEnter() {
+  simLibraryDepth++;
+}
+
+void simLibraryLeave() {
+  simLibraryDepth--;
+}
+
+/**
+ * @brief Count a heap allocation made by the simulated libraries
+ */
+void simNoteAlloc() {
+  if (simLibraryDepth && !simHostDepth) simLibraryCount++;
+}
+
+/**
+ * @brief Enter the bookkeeping of the simulation itself, which has no
+ * counterpart on the device: its allocations are not the firmware's
+ */
+void simHostEnter() {
+  simHostDepth++;
+}
+
+void simHostLeave() {
+  simHostDepth--;
+}
+
+/**
+ * @brief Check whether the firmware's loop is running its own code, for
+ * the allocation counter of src/heapguard.cpp
+ */
+bool simInFirmware() {
+  return simLooping && !simHostDepth;
+}
+
+/**
+ * @brief Get the heap allocations made by the simulated libraries
+ */
+unsigned long simLibraryAllocs() {
+  return simLibraryCount;
+}
+
+// Display
+
+/**
+ * @brief A frame or an area went out to the display
+ *
+ * A full frame closes the display latency of the inputs before it.
+ */
+void simDisplayFrame(size_t bytes, bool full, const std::string &text) {
+  (void)bytes;
+  if (!full) {
+    simAreaCount++;
+    return;
+  }
+  simFrameCount++;
+  simHostEnter();
+  simText = text;
+  simHostLeave();
+  for (SimLatency &l : simLatencyLog) {
+    if (l.display < 0) l.display = simNow;
+  }
+}
+
+unsigned long simFrames() {
+  return simFrameCount;
+}
+
+unsigned long simAreaUpdates() {
+  return simAreaCount;
+}
+
+/**
+ * @brief Text drawn in the last full frame, one "|" between strings
+ */
+const std::string &simFrameText() {
+  return simText;
+}
+
+// I2C bus
+
+/**
+ * @brief Fail the next transfers with a NACK
+ */
+void simI2cNack(uint8_t transfers) {
+  simNackPending = transfers;
+}
+
+/**
+ * @brief Make a slave hold SDA low until it sees this many SCL pulses
+ */
+void simI2cHoldSda(uint8_t clocks) {
+  simSdaHold = clocks;
+}
+
+const SimI2cStats &simI2cStats() {
+  return simI2c;
+}
+
+void simWireBegin() {
+  simI2c.begins++;
+}
+
+bool simSdaHeld() {
+  return simSdaHold > 0;
+}
+
+/**
+ * @brief Account for one transfer and decide its fate
+ *
+ * @return 0 if it goes through, 5 (timeout) while SDA is held, 2 (NACK)
+ *         while simI2cNack() is in effect
+ */
+uint8_t simI2cTransfer() {
+  simI2c.transfers++;
+  if (simSdaHold) {
+    simI2c.stuck++;
+    return 5;
+  }
+  if (simNackPending) {
+    simNackPending--;
+    simI2c.nacks++;
+    return 2;
+  }
+  return 0;
+}
+
+// Latency
+
+const std::vector<SimLatency> &simLatencies() {
+  return simLatencyLog;
+}
+
+/**
+ * @brief Print the scripted inputs with their latencies, in ms
+ */
+void simReport(FILE *out) {
+  fprintf(out, "%-28s %10s %10s %10s\n", "input", "at", "display", "response");
+  for (const SimLatency &l : simLatencyLog) {
+    fprintf(out, "%-28s %10.3f", l.label.c_str(), l.at / 1000.0);
+    if (l.display >= 0) fprintf(out, " %10.3f", (l.display - (int64_t)l.at) / 1000.0);
+    else fprintf(out, " %10s", "-");
+    if (l.response >= 0) fprintf(out, " %10.3f\n", (l.response - (int64_t)l.at) / 1000.0);
+    else fprintf(out, " %10s\n", "-");
+  }
+}
+
+/**
+ * @brief Run the firmware on the virtual clock, as fast as the host can
+ *
+ * Tests bring their own main().
+ */
+__attribute__((weak)) int main() {
+  setup();
+  for (;;) loop();
+}
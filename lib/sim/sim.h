@@ -0,0 +1,144 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Host simulation (env:native)
+ *
+ * The firmware runs on the host against the stand-ins of this library:
+ * the Arduino core (Arduino.h), Wire, U8g2, WiFi, WebServer and Ticker.
+ * The RDA5807 on the I2C bus is a model of the chip's registers
+ * (simtuner.h), driven either by the driver stand-in of lib/sim_tuner
+ * (env:native) or by the real PU2CLR library (env:native_rds).
+ *
+ * Time is virtual. It only moves in delay() and delayMicroseconds() and
+ * through the modelled cost of I/O: I2C bytes at 100 kHz, display bytes
+ * at 4 MHz, HTTP bytes at 1 MB/s. Code runs in zero time, so a run gives
+ * the same timings on every host, every time. Tickers fire whenever the
+ * clock passes their period, as a hardware timer would.
+ *
+ * A test drives the firmware with scripted inputs (buttons, encoder,
+ * HTTP requests) and simRun(), which calls loop() until the clock has
+ * moved on by the given time. Each input is recorded with the time of
+ * the next full display frame and, for a request, the time its response
+ * went out; simReport() prints these latencies.
+ */
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+// I/O cost model
+const uint32_t SIM_I2C_BYTE_US = 90;        // 9 clocks at 100 kHz
+const uint32_t SIM_I2C_START_STOP_US = 10;
+const uint32_t SIM_SPI_BYTE_NS = 2000;      // 8 clocks at 4 MHz
+const uint32_t SIM_HTTP_REQUEST_US = 500;   // Accept and parse a request
+const uint32_t SIM_HTTP_BYTE_NS = 1000;     // Response bytes, 1 MB/s
+
+/**
+ * @brief One scripted input and what it led to
+ */
+struct SimLatency {
+  std::string label;
+  uint64_t at;            // us, when the input happened
+  int64_t display;        // us, next full display frame, -1 if none yet
+  int64_t response;       // us, response sent (requests only), -1 if none
+};
+
+/**
+ * @brief HTTP response as sent by the firmware
+ */
+struct SimResponse {
+  int code;
+  std::string type;
+  std::string location;   // Location header, if any
+  std::string body;
+};
+
+/**
+ * @brief Simulated I2C bus counters
+ */
+struct SimI2cStats {
+  unsigned long transfers;    // Transfers addressed
+  unsigned long nacks;        // Transfers failed by simI2cNack()
+  unsigned long stuck;        // Transfers failed while SDA was held
+  unsigned long sclPulses;    // SCL rising edges driven by hand
+  unsigned long stops;        // STOP conditions driven by hand
+  unsigned long begins;       // Wire.begin() calls
+};
+
+// Clock
+uint64_t simMicros();
+void simAdvance(uint64_t us);
+void simRun(unsigned long ms);
+
+// Pins and inputs
+void simSetPin(uint8_t pin, bool level);
+void simPress(uint8_t pin, const char *label);
+void simRelease(uint8_t pin, const char *label);
+void simEncoder(uint8_t pinA, uint8_t pinB, int detents, const char *label);
+void simInput(const char *label);
+
+// Serial
+void simSerialInput(const char *text);
+const std::vector<uint8_t> &simSerialOutput();
+void simSerialClear();
+void simSerialEcho(bool echo);
+
+// HTTP
+void simRequest(const char *uri);
+bool simRequestPending();
+const SimResponse &simLastResponse();
+unsigned long simLibraryAllocs();
+
+// Display
+unsigned long simFrames();
+unsigned long simAreaUpdates();
+const std::string &simFrameText();
+
+// I2C bus faults
+void simI2cNack(uint8_t transfers);
+void simI2cHoldSda(uint8_t clocks);
+const SimI2cStats &simI2cStats();
+
+// Latency
+const std::vector<SimLatency> &simLatencies();
+void simReport(FILE *out);
+
+// Hooks for the stand-ins
+typedef void (*SimIsr)();
+void simAttachInterrupt(uint8_t pin, SimIsr isr, int mode);
+void simAttachTicker(void *owner, uint32_t periodUs, void (*callback)());
+void simDetachTicker(void *owner);
+void simDisplayFrame(size_t bytes, bool full, const std::string &text);
+bool simTakeRequest(std::string &request);
+void simResponseSent(const SimResponse &response);
+void simLibraryEnter();
+void simLibraryLeave();
+void simNoteAlloc();
+void simHostEnter();
+void simHostLeave();
+bool simInFirmware();
+void simWireBegin();
+uint8_t simI2cTransfer();
+bool simSdaHeld();
+
+#endif // SIM_H
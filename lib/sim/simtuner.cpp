@@ -0,0 +1,187 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "simtuner.h"
+
+// Bus addresses: sequential access, random register access
+const uint8_t SIM_RDA_SEQUENTIAL = 0x10;
+const uint8_t SIM_RDA_RANDOM = 0x11;
+
+// Default band: a few stations spread over 87.5-108 MHz
+const SimStation simDefaultStations[] = {
+  {8930, 52, true},
+  {9450, 38, false},
+  {10110, 61, true},
+  {10580, 33, true},
+};
+const uint8_t SIM_MAX_STATIONS = 32;
+
+uint16_t simRegs[16];
+uint8_t simPointer = 0;             // Next register of a random access read
+SimStation simStations[SIM_MAX_STATIONS];
+uint8_t simStationCount = 0;
+
+/**
+ * @brief Registers at power on, default band
+ */
+void simTunerReset() {
+  memset(simRegs, 0, sizeof(simRegs));
+  simRegs[0x00] = 0x5804;           // Chip ID
+  simPointer = 0;
+  simTunerStations(simDefaultStations, sizeof(simDefaultStations) / sizeof(simDefaultStations[0]));
+}
+
+/**
+ * @brief Replace the stations of the band
+ */
+void simTunerStations(const SimStation *stations, uint8_t count) {
+  if (count > SIM_MAX_STATIONS) count = SIM_MAX_STATIONS;
+  memcpy(simStations, stations, count * sizeof(SimStation));
+  simStationCount = count;
+}
+
+/**
+ * @brief Find the station on a frequency, NULL if there is none
+ */
+static const SimStation *simStationAt(uint16_t frequency) {
+  for (uint8_t i = 0; i < simStationCount; i++) {
+    if (simStations[i].frequency == frequency) return &simStations[i];
+  }
+  return NULL;
+}
+
+/**
+ * @brief RSSI on a frequency: the station, an image 20 dB below next to
+ * one, or the noise floor
+ */
+uint8_t simTunerRssi(uint16_t frequency) {
+  const SimStation *station = simStationAt(frequency);
+  if (station) return station->rssi;
+  for (uint8_t i = 0; i < simStationCount; i++) {
+    int distance = (int)simStations[i].frequency - frequency;
+    if ((distance == 10 || distance == -10) && simStations[i].rssi > 30) {
+      return simStations[i].rssi - 20;
+    }
+  }
+  return 8 + (frequency / 10) % 7;
+}
+
+/**
+ * @brief Frequency of the tuned channel, 10 kHz units
+ */
+uint16_t simTunerFrequency() {
+  static const uint8_t spacing[4] = {10, 20, 5, 5};
+  static const uint16_t bottom[4] = {8700, 7600, 7600, 6500};
+  uint16_t reg = simRegs[0x03];
+  return bottom[(reg >> 2) & 3] + (simRegs[0x0A] & 0x03FF) * spacing[reg & 3];
+}
+
+bool simTunerMuted() {
+  return !(simRegs[0x02] & SIM_RDA_02_DMUTE);
+}
+
+uint8_t simTunerVolume() {
+  return simRegs[0x05] & 0x0F;
+}
+
+uint16_t simTunerRegister(uint8_t reg) {
+  return simRegs[reg & 0x0F];
+}
+
+/**
+ * @brief Present an RDS group in the block registers, with its error
+ * levels; the decoder is in sync from the first group
+ */
+void simTunerRdsGroup(const uint16_t *blocks, uint8_t blerA, uint8_t blerB) {
+  memcpy(&simRegs[0x0C], blocks, 4 * sizeof(uint16_t));
+  simRegs[0x0A] |= SIM_RDA_0A_RDSR | SIM_RDA_0A_RDSS;
+  simRegs[0x0B] = (simRegs[0x0B] & ~0x000F) | (blerA & 3) << 2 | (blerB & 3);
+}
+
+/**
+ * @brief Apply a register write
+ */
+static void simTunerApply(uint8_t reg) {
+  if (reg == 0x02 && (simRegs[0x02] & SIM_RDA_02_SOFT_RESET)) {
+    simRegs[0x02] &= ~SIM_RDA_02_SOFT_RESET;
+    return;
+  }
+  if (reg != 0x03 || !(simRegs[0x03] & SIM_RDA_03_TUNE)) return;
+
+  // Tune at once: READCHAN follows CHAN, RDS starts over
+  simRegs[0x03] &= ~SIM_RDA_03_TUNE;
+  simRegs[0x0A] = SIM_RDA_0A_STC | (simRegs[0x03] >> 6);
+  uint16_t frequency = simTunerFrequency();
+  const SimStation *station = simStationAt(frequency);
+  simRegs[0x0B] = (uint16_t)simTunerRssi(frequency) << 9;
+  if (station) {
+    simRegs[0x0B] |= SIM_RDA_0B_FM_TRUE | SIM_RDA_0B_FM_READY;
+    if (station->stereo && !(simRegs[0x02] & SIM_RDA_02_MONO)) simRegs[0x0A] |= SIM_RDA_0A_ST;
+  }
+  memset(&simRegs[0x0C], 0, 4 * sizeof(uint16_t));
+}
+
+/**
+ * @brief Write to the chip
+ *
+ * @return false if the address is not the chip's
+ */
+bool simTunerWrite(uint8_t address, const uint8_t *data, uint8_t length) {
+  uint8_t reg;
+  if (address == SIM_RDA_SEQUENTIAL) {
+    reg = 0x02;
+  } else if (address == SIM_RDA_RANDOM) {
+    if (length == 0) return true;
+    reg = simPointer = data[0] & 0x0F;
+    data++;
+    length--;
+  } else {
+    return false;
+  }
+  for (uint8_t i = 0; i + 1 < length; i += 2, reg = (reg + 1) & 0x0F) {
+    simRegs[reg] = (uint16_t)data[i] << 8 | data[i + 1];
+    simTunerApply(reg);
+  }
+  return true;
+}
+
+/**
+ * @brief Read from the chip
+ *
+ * @return false if the address is not the chip's
+ */
+bool simTunerRead(uint8_t address, uint8_t *data, uint8_t length) {
+  uint8_t reg;
+  if (address == SIM_RDA_SEQUENTIAL) reg = 0x0A;
+  else if (address == SIM_RDA_RANDOM) reg = simPointer;
+  else return false;
+  for (uint8_t i = 0; i < length; i += 2, reg = (reg + 1) & 0x0F) {
+    data[i] = simRegs[reg] >> 8;
+    if (i + 1 < length) data[i + 1] = simRegs[reg] & 0xFF;
+  }
+  return true;
+}
+
+/**
+ * @brief Power the chip on before setup() runs
+ */
+static struct SimTunerPowerOn {
+  SimTunerPowerOn() { simTunerReset(); }
+} simTunerPowerOn;
@@ -0,0 +1,71 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * RDA5807M register model (env:native)
+ *
+ * Answers on the simulated I2C bus as the chip does: at 0x10 writes go
+ * to registers 0x02 onwards and reads start at 0x0A, at 0x11 the first
+ * byte written selects the register. Setting TUNE in register 0x03 tunes
+ * the channel at once, with STC set and the RDS state cleared.
+ *
+ * The band is a list of stations; a station channel has its RSSI,
+ * FM-true and FM-ready, the channels next to it a weaker image without
+ * them, the rest a low noise floor. RDS groups are handed in by the test
+ * with simTunerRdsGroup() and show up in registers 0x0A to 0x0F.
+ */
+
+#ifndef SIMTUNER_H
+#define SIMTUNER_H
+
+#include <stdint.h>
+
+// Register bits
+const uint16_t SIM_RDA_02_DMUTE = 0x4000;     // 0: muted
+const uint16_t SIM_RDA_02_MONO = 0x2000;
+const uint16_t SIM_RDA_02_RDS_EN = 0x0008;
+const uint16_t SIM_RDA_02_SOFT_RESET = 0x0002;
+const uint16_t SIM_RDA_03_TUNE = 0x0010;
+const uint16_t SIM_RDA_0A_RDSR = 0x8000;
+const uint16_t SIM_RDA_0A_STC = 0x4000;
+const uint16_t SIM_RDA_0A_RDSS = 0x1000;
+const uint16_t SIM_RDA_0A_ST = 0x0400;
+const uint16_t SIM_RDA_0B_FM_TRUE = 0x0100;
+const uint16_t SIM_RDA_0B_FM_READY = 0x0080;
+
+/**
+ * @brief A station of the simulated band
+ */
+struct SimStation {
+  uint16_t frequency;     // 10 kHz units
+  uint8_t rssi;           // dBuV
+  bool stereo;
+};
+
+void simTunerReset();
+void simTunerStations(const SimStation *stations, uint8_t count);
+uint8_t simTunerRssi(uint16_t frequency);
+uint16_t simTunerFrequency();
+bool simTunerMuted();
+uint8_t simTunerVolume();
+uint16_t simTunerRegister(uint8_t reg);
+void simTunerRdsGroup(const uint16_t *blocks, uint8_t blerA, uint8_t blerB);
+bool simTunerWrite(uint8_t address, const uint8_t *data, uint8_t length);
+bool simTunerRead(uint8_t address, uint8_t *data, uint8_t length);
+
+#endif // SIMTUNER_H
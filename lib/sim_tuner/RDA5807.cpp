@@ -0,0 +1,211 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#include "RDA5807.h"
+
+const uint8_t RDA_SEQUENTIAL = 0x10;
+const uint8_t RDA_RANDOM = 0x11;
+
+// Register bits
+const uint16_t RDA_02_DHIZ = 0x8000;
+const uint16_t RDA_02_DMUTE = 0x4000;
+const uint16_t RDA_02_RDS_EN = 0x0008;
+const uint16_t RDA_02_NEW_METHOD = 0x0004;
+const uint16_t RDA_02_SOFT_RESET = 0x0002;
+const uint16_t RDA_02_ENABLE = 0x0001;
+const uint16_t RDA_03_TUNE = 0x0010;
+const uint16_t RDA_05_DEFAULT = 0x8880;     // INT_MODE, seek threshold 8
+const uint16_t RDA_0A_RDSR = 0x8000;
+const uint16_t RDA_0A_RDSS = 0x1000;
+const uint16_t RDA_0A_ST = 0x0400;
+const uint16_t RDA_0B_FM_TRUE = 0x0100;
+const uint16_t RDA_0B_FM_READY = 0x0080;
+
+const uint16_t RDA_BAND_BOTTOM = 8700;      // US/Europe band, 100 kHz spacing
+const uint16_t RDA_SPACING = 10;
+
+/**
+ * @brief Reset and enable the chip, unmuted, RDS on
+ */
+void RDA5807::setup() {
+  Wire.begin();
+  reg02 = RDA_02_DHIZ | RDA_02_DMUTE | RDA_02_SOFT_RESET | RDA_02_ENABLE;
+  writeRegister(0x02, reg02);
+  reg02 = RDA_02_DHIZ | RDA_02_DMUTE | RDA_02_RDS_EN | RDA_02_NEW_METHOD | RDA_02_ENABLE;
+  writeRegister(0x02, reg02);
+  reg05 = RDA_05_DEFAULT;
+  writeRegister(0x05, reg05);
+  clearRdsBuffer();
+}
+
+void RDA5807::setFrequency(uint16_t frequency) {
+  uint16_t channel = (frequency - RDA_BAND_BOTTOM) / RDA_SPACING;
+  writeRegister(0x03, channel << 6 | RDA_03_TUNE);
+}
+
+void RDA5807::setMute(bool mute) {
+  if (mute) reg02 &= ~RDA_02_DMUTE;
+  else reg02 |= RDA_02_DMUTE;
+  writeRegister(0x02, reg02);
+}
+
+void RDA5807::setVolume(uint8_t volume) {
+  reg05 = (reg05 & ~0x000F) | (volume & 0x0F);
+  writeRegister(0x05, reg05);
+}
+
+int RDA5807::getRssi() {
+  readStatus(2);
+  return status[1] >> 9;
+}
+
+bool RDA5807::isStereo() {
+  readStatus(1);
+  return status[0] & RDA_0A_ST;
+}
+
+bool RDA5807::isFmTrue() {
+  readStatus(2);
+  return status[1] & RDA_0B_FM_TRUE;
+}
+
+bool RDA5807::isFmReady() {
+  readStatus(2);
+  return status[1] & RDA_0B_FM_READY;
+}
+
+bool RDA5807::getRdsSync() {
+  readStatus(1);
+  return status[0] & RDA_0A_RDSS;
+}
+
+/**
+ * @brief Read the status and RDS registers and decode a new group
+ *
+ * @return true if a group was ready
+ */
+bool RDA5807::getRDSready() {
+  readStatus(6);
+  if (!(status[0] & RDA_0A_RDSR)) return false;
+
+  uint16_t b = status[3];
+  uint16_t c = status[4];
+  uint16_t d = status[5];
+  uint8_t type = b >> 12;
+  bool versionB = b & 0x0800;
+  pi = status[2];
+  tp = b & 0x0400;
+  pty = (b >> 5) & 0x1F;
+  if (type == 0) {
+    uint8_t seg = b & 0x03;
+    ta = b & 0x0010;
+    ps[seg * 2] = d >> 8;
+    ps[seg * 2 + 1] = d & 0xFF;
+    psSegments |= 1 << seg;
+  } else if (type == 2) {
+    uint8_t seg = b & 0x0F;
+    char chars[4] = {(char)(c >> 8), (char)(c & 0xFF), (char)(d >> 8), (char)(d & 0xFF)};
+    uint8_t pos = versionB ? seg * 2 : seg * 4;
+    const char *src = versionB ? chars + 2 : chars;
+    for (uint8_t i = 0; i < (versionB ? 2 : 4) && pos + i < 64; i++) {
+      rt[pos + i] = src[i];
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Copy the PS name, empty until all four segments are in
+ */
+void RDA5807::getRDS_PS(char *out) {
+  if (psSegments == 0x0F) memcpy(out, ps, 9);
+  else out[0] = '\0';
+}
+
+/**
+ * @brief Copy the radio text received so far, up to a gap or its end
+ * marker (0x0D)
+ */
+void RDA5807::getRDS_RT(char *out) {
+  uint8_t n = 0;
+  while (n < 64 && rt[n] && rt[n] != '\r') {
+    out[n] = rt[n];
+    n++;
+  }
+  out[n] = '\0';
+}
+
+uint8_t RDA5807::getRDS_PTY() {
+  return pty;
+}
+
+bool RDA5807::getRDS_TP() {
+  return tp;
+}
+
+bool RDA5807::getRDS_TA() {
+  return ta;
+}
+
+uint16_t RDA5807::getRDS_PI() {
+  return pi;
+}
+
+/**
+ * @brief Write one register through the random access address
+ */
+void RDA5807::writeRegister(uint8_t reg, uint16_t value) {
+  Wire.beginTransmission(RDA_RANDOM);
+  Wire.write(reg);
+  Wire.write(value >> 8);
+  Wire.write(value & 0xFF);
+  Wire.endTransmission();
+}
+
+/**
+ * @brief Read registers 0x0A onwards into status
+ */
+void RDA5807::readStatus(uint8_t words) {
+  if (Wire.requestFrom(RDA_SEQUENTIAL, (uint8_t)(2 * words)) != 2 * words) {
+    memset(status, 0, sizeof(status));
+    return;
+  }
+  for (uint8_t i = 0; i < words; i++) {
+    uint16_t hi = Wire.read();
+    status[i] = hi << 8 | (uint8_t)Wire.read();
+  }
+}
+
+/**
+ * @brief Forget the RDS data decoded so far
+ *
+ * As in the library, tuning keeps it: the data of the previous channel
+ * stays until this is called.
+ */
+void RDA5807::clearRdsBuffer() {
+  memset(ps, 0, sizeof(ps));
+  memset(rt, 0, sizeof(rt));
+  psSegments = 0;
+  pi = 0;
+  pty = 0;
+  tp = false;
+  ta = false;
+}
@@ -0,0 +1,73 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * RDA5807 driver stand-in (env:native)
+ *
+ * The calls the firmware makes, done the way the chip expects them over
+ * Wire, so every one of them reaches the register model of lib/sim with
+ * its bus traffic and bus time. RDS groups are decoded here: the PS
+ * name once its four segments are in, the radio text up to its end
+ * marker or its 64th character. Like the library, tuning does not clear
+ * the decoded data; clearRdsBuffer() does.
+ */
+
+#ifndef RDA5807_H
+#define RDA5807_H
+
+#include <Arduino.h>
+
+class RDA5807 {
+public:
+  void setup();
+  void setFrequency(uint16_t frequency);
+  void setMute(bool mute);
+  void setVolume(uint8_t volume);
+
+  int getRssi();
+  bool isStereo();
+  bool isFmTrue();
+  bool isFmReady();
+
+  bool getRdsSync();
+  bool getRDSready();
+  void getRDS_PS(char *ps);
+  void getRDS_RT(char *rt);
+  uint8_t getRDS_PTY();
+  bool getRDS_TP();
+  bool getRDS_TA();
+  uint16_t getRDS_PI();
+  void clearRdsBuffer();
+
+private:
+  void writeRegister(uint8_t reg, uint16_t value);
+  void readStatus(uint8_t words);
+
+  uint16_t reg02 = 0;
+  uint16_t reg05 = 0;
+  uint16_t status[6];     // Registers 0x0A to 0x0F, as last read
+  char ps[9];
+  char rt[65];
+  uint8_t psSegments = 0; // One bit per PS segment received
+  uint16_t pi = 0;
+  uint8_t pty = 0;
+  bool tp = false;
+  bool ta = false;
+};
+
+#endif // RDA5807_H
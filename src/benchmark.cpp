@@ -0,0 +1,155 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <Arduino.h>
+
+#include "board.h"
+
+#if BOARD_HAS_WIFI
+  #include "config.h"
+#endif
+
+#if defined(ENABLE_BENCHMARK)
+
+#include "benchmark.h"
+
+// Section boundaries, defined by the linker scripts
+#if defined(__AVR__)
+extern char _etext;
+extern char __data_start, __data_end;
+extern char __bss_start, __bss_end;
+#elif defined(ESP8266)
+extern char _irom0_text_start, _irom0_text_end;
+extern char _text_start, _text_end;
+extern char _rodata_start, _rodata_end;
+extern char _data_start, _data_end;
+extern char _bss_start, _bss_end;
+#elif defined(ESP32)
+extern char _text_start, _text_end;
+extern char _iram_text_start, _iram_text_end;
+extern char _rodata_start, _rodata_end;
+extern char _data_start, _data_end;
+extern char _bss_start, _bss_end;
+#endif
+
+/**
+ * @brief Print the start of a result line
+ */
+void benchmarkLine() {
+  Serial.print(F("BENCH {\"env\":\""));
+  Serial.print(F(BENCH_ENV));
+  Serial.print('"');
+}
+
+/**
+ * @brief Print one "name":value member
+ */
+void benchmarkField(const __FlashStringHelper *name, unsigned long value) {
+  Serial.print(F(",\""));
+  Serial.print(name);
+  Serial.print(F("\":"));
+  Serial.print(value);
+}
+
+/**
+ * @brief Size of the section between two linker symbols
+ */
+unsigned long benchmarkSize(const char &start, const char &end) {
+  return (unsigned long)(&end - &start);
+}
+
+/**
+ * @brief Read a cycle counter, if the core has one
+ */
+uint32_t benchmarkCycles() {
+#if defined(__AVR__)
+  return 0;
+#else
+  return ESP.getCycleCount();
+#endif
+}
+
+/**
+ * @brief Print the firmware section sizes
+ */
+void benchmarkSections() {
+  benchmarkLine();
+  benchmarkField(F("f_cpu"), F_CPU);
+#if defined(__AVR__)
+  // .text starts at 0 with the vector table
+  benchmarkField(F("text"), (unsigned long)(uintptr_t)&_etext);
+  benchmarkField(F("data"), benchmarkSize(__data_start, __data_end));
+  benchmarkField(F("bss"), benchmarkSize(__bss_start, __bss_end));
+#elif defined(ESP8266)
+  benchmarkField(F("text"), benchmarkSize(_irom0_text_start, _irom0_text_end));
+  benchmarkField(F("iram"), benchmarkSize(_text_start, _text_end));
+  benchmarkField(F("rodata"), benchmarkSize(_rodata_start, _rodata_end));
+  benchmarkField(F("data"), benchmarkSize(_data_start, _data_end));
+  benchmarkField(F("bss"), benchmarkSize(_bss_start, _bss_end));
+#elif defined(ESP32)
+  benchmarkField(F("text"), benchmarkSize(_text_start, _text_end));
+  benchmarkField(F("iram"), benchmarkSize(_iram_text_start, _iram_text_end));
+  benchmarkField(F("rodata"), benchmarkSize(_rodata_start, _rodata_end));
+  benchmarkField(F("data"), benchmarkSize(_data_start, _data_end));
+  benchmarkField(F("bss"), benchmarkSize(_bss_start, _bss_end));
+#endif
+  Serial.println('}');
+}
+
+/**
+ * @brief Run an operation a number of times and print what it cost
+ *
+ * @param name Operation name
+ * @param count Number of runs
+ * @param op Operation, given the run index
+ */
+void benchmarkRun(const __FlashStringHelper *name, uint16_t count, void (*op)(uint16_t i)) {
+  Serial.flush();
+  uint32_t startCycles = benchmarkCycles();
+  unsigned long start = micros();
+  for (uint16_t i = 0; i < count; i++) {
+    op(i);
+  }
+  unsigned long elapsed = micros() - start;
+#if defined(__AVR__)
+  uint32_t cycles = elapsed * (F_CPU / 1000000UL);
+  (void)startCycles;
+#else
+  uint32_t cycles = benchmarkCycles() - startCycles;
+#endif
+
+  benchmarkLine();
+  Serial.print(F(",\"op\":\""));
+  Serial.print(name);
+  Serial.print('"');
+  benchmarkField(F("n"), count);
+  benchmarkField(F("us"), elapsed);
+  benchmarkField(F("usPerOp"), elapsed / count);
+  benchmarkField(F("cyclesPerOp"), cycles / count);
+  Serial.println('}');
+}
+
+/**
+ * @brief Mark the end of the suite
+ */
+void benchmarkDone() {
+  benchmarkLine();
+  Serial.println(F(",\"done\":true}"));
+}
+
+#endif // ENABLE_BENCHMARK
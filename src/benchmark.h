@@ -0,0 +1,58 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Footprint and hot-path benchmark (ENABLE_BENCHMARK)
+ *
+ * The *_bench environments in platformio.ini build the firmware with
+ * ENABLE_BENCHMARK; at the end of setup() it runs a fixed suite and
+ * prints one line per result on the serial port, "BENCH " followed by a
+ * JSON object, so the logs of all boards can be collected with grep:
+ *
+ *   BENCH {"env":"uno_bench","f_cpu":16000000,"text":..,"data":..,"bss":..}
+ *   BENCH {"env":"uno_bench","op":"render","n":50,"us":..,"usPerOp":..,"cyclesPerOp":..}
+ *   BENCH {"env":"uno_bench","done":true}
+ *
+ * Section sizes come from the linker script symbols of each core:
+ * "text" is the code run from flash, "iram" the code in instruction RAM
+ * (ESP), "rodata" the constants kept in a section of their own (ESP),
+ * "data" and "bss" the initialized and zeroed static RAM.
+ *
+ * ESP boards read the CPU cycle counter; AVR has none, there cycles are
+ * derived from micros() (4 us resolution) and F_CPU.
+ */
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <Arduino.h>
+
+#if defined(ENABLE_BENCHMARK)
+
+// Environment name, set by the *_bench environments
+#if !defined(BENCH_ENV)
+#define BENCH_ENV "unknown"
+#endif
+
+void benchmarkSections();
+void benchmarkRun(const __FlashStringHelper *name, uint16_t count, void (*op)(uint16_t i));
+void benchmarkDone();
+
+#endif // ENABLE_BENCHMARK
+
+#endif // BENCHMARK_H
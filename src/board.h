@@ -0,0 +1,334 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Compile-time board descriptors
+ *
+ * Every supported board is described once, here: display pins, button
+ * pins, the display and web server types and the feature flags
+ * (BOARD_HAS_WIFI, BOARD_HAS_FS, BOARD_BUTTON_ON_RX). The descriptor matching the PlatformIO
+ * environment is selected at the end of this file and exported as `Board`.
+ *
+ * Button pins are described by `FastPin` types whose pressed() reads the
+ * GPIO input register directly (for example `PIND & _BV(2)` on AVR), so a
+ * button poll compiles to a couple of instructions instead of a call to
+ * digitalRead() with its pin-to-port table lookups.
+ *
+ * The optional rotary encoder (ENABLE_ENCODER) is described the same way:
+ * EncA/EncB/EncSw pins plus attachEncoder(), which routes pin changes on
+ * both phases to the decoder ISR using whatever interrupt source the
+ * board has free (external interrupts or pin change interrupts).
+ *
+ * Adding a board means adding one descriptor struct and one line to the
+ * selection chain below.
+ */
+
+#ifndef BOARD_H
+#define BOARD_H
+
+#include <Arduino.h>
+#include <U8g2lib.h>
+
+#if defined(ESP8266)
+#include <ESP8266WiFi.h>
+#include <ESP8266WebServer.h>
+#include <LittleFS.h>
+#elif defined(ESP32)
+#include <WiFi.h>
+#include <WebServer.h>
+#include <LittleFS.h>
+#elif defined(ARDUINO_SIM)
+#include <WiFi.h>
+#include <WebServer.h>
+#endif
+
+/**
+ * @brief Active-low button on a fixed GPIO, read straight from the port
+ *
+ * @tparam Pin   Arduino pin number, used only for pinMode()
+ * @tparam Reg   Address of the input register (memory mapped)
+ * @tparam Mask  Bit mask of the pin inside the input register
+ */
+#if defined(__AVR__)
+template <uint8_t Pin, uint16_t Reg, uint8_t Mask>
+struct FastPin {
+  static const uint8_t pin = Pin;
+  static inline void begin() { pinMode(Pin, INPUT_PULLUP); }
+  static inline uint8_t read() { return (_SFR_MEM8(Reg) & Mask) ? 1 : 0; }
+  static inline bool pressed() { return !(_SFR_MEM8(Reg) & Mask); }
+};
+#elif defined(ESP8266)
+template <uint8_t Pin>
+struct FastPin {
+  static const uint8_t pin = Pin;
+  static inline void begin() { pinMode(Pin, INPUT_PULLUP); }
+  static inline uint8_t read() { return (GPI >> Pin) & 1; }
+  static inline bool pressed() { return !(GPI & (1UL << Pin)); }
+};
+#elif defined(ESP32)
+template <uint8_t Pin>
+struct FastPin {
+  static_assert(Pin < 32, "FastPin only covers the first GPIO bank");
+  static const uint8_t pin = Pin;
+  static inline void begin() { pinMode(Pin, INPUT_PULLUP); }
+  static inline uint8_t read() { return (REG_READ(GPIO_IN_REG) >> Pin) & 1; }
+  static inline bool pressed() { return !(REG_READ(GPIO_IN_REG) & (1UL << Pin)); }
+};
+#elif defined(ARDUINO_SIM)
+template <uint8_t Pin>
+struct FastPin {
+  static const uint8_t pin = Pin;
+  static inline void begin() { pinMode(Pin, INPUT_PULLUP); }
+  static inline uint8_t read() { return digitalRead(Pin); }
+  static inline bool pressed() { return !digitalRead(Pin); }
+};
+#endif
+
+// Interrupt handlers only need placing in IRAM on the ESP platforms
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+
+#if defined(__AVR__)
+// Input registers as memory addresses, the same on ATmega328P and ATmega32U4
+#define AVR_PINB_ADDR 0x23
+#define AVR_PINC_ADDR 0x26
+#define AVR_PIND_ADDR 0x29
+#endif
+
+#if defined(ARDUINO_AVR_MICRO)
+/**
+ * @brief Arduino Micro (ATmega32U4)
+ *
+ * D2 is PD1, D3 is PD0 and D4 is PD4 on the 32U4.
+ * The encoder uses D0/D1 (PD2/PD3, INT2/INT3), which are free because
+ * Serial is the native USB port, and D8 (PB4) for the switch.
+ */
+struct BoardMicro {
+  static const uint8_t LCD_CS = 7;
+  static const uint8_t LCD_DC = 6;
+  static const uint8_t LCD_RST = 5;
+  typedef FastPin<2, AVR_PIND_ADDR, _BV(1)> BtnUp;
+  typedef FastPin<3, AVR_PIND_ADDR, _BV(0)> BtnDown;
+  typedef FastPin<4, AVR_PIND_ADDR, _BV(4)> BtnOk;
+  typedef FastPin<0, AVR_PIND_ADDR, _BV(2)> EncA;
+  typedef FastPin<1, AVR_PIND_ADDR, _BV(3)> EncB;
+  typedef FastPin<8, AVR_PINB_ADDR, _BV(4)> EncSw;
+  typedef U8G2_PCD8544_84X48_F_4W_HW_SPI Display;
+  static void attachEncoder(void (*isr)()) {
+    attachInterrupt(digitalPinToInterrupt(EncA::pin), isr, CHANGE);
+    attachInterrupt(digitalPinToInterrupt(EncB::pin), isr, CHANGE);
+  }
+};
+#define BOARD_DESCRIPTOR BoardMicro
+
+#elif defined(__AVR__)
+/**
+ * @brief Arduino Uno / Nano (ATmega328P)
+ *
+ * D2..D4 map to PD2..PD4. The buttons are polled, but they occupy the
+ * INT0/INT1 pins (D2/D3), so the encoder sits on A0/A1 (PC0/PC1) and
+ * uses the PCINT1 pin change interrupt; the switch is on A2 (PC2).
+ */
+struct BoardAtmega328 {
+  static const uint8_t LCD_CS = 7;
+  static const uint8_t LCD_DC = 6;
+  static const uint8_t LCD_RST = 5;
+  typedef FastPin<2, AVR_PIND_ADDR, _BV(2)> BtnUp;
+  typedef FastPin<3, AVR_PIND_ADDR, _BV(3)> BtnDown;
+  typedef FastPin<4, AVR_PIND_ADDR, _BV(4)> BtnOk;
+  typedef FastPin<A0, AVR_PINC_ADDR, _BV(0)> EncA;
+  typedef FastPin<A1, AVR_PINC_ADDR, _BV(1)> EncB;
+  typedef FastPin<A2, AVR_PINC_ADDR, _BV(2)> EncSw;
+  typedef U8G2_PCD8544_84X48_F_4W_HW_SPI Display;
+  // The ISR itself is bound to BOARD_ENCODER_PCINT_VECT in main.cpp
+  static void attachEncoder(void (*)()) {
+    PCMSK1 |= _BV(PCINT8) | _BV(PCINT9);
+    PCIFR = _BV(PCIF1);
+    PCICR |= _BV(PCIE1);
+  }
+};
+#define BOARD_DESCRIPTOR BoardAtmega328
+#define BOARD_ENCODER_PCINT_VECT PCINT1_vect
+
+#elif defined(ESP8266)
+/**
+ * @brief ESP8266 NodeMCU v2
+ *
+ * CLK: GPIO-14 (D5)
+ * MISO: GPIO-12 (D6)
+ * MOSI: GPIO-13 (D7)
+ * CS: GPIO-16 (D0)
+ * D/C: GPIO-15 (D8)
+ * RST: GPIO-0 (D3)
+ * SDA: GPIO-4 (D2)
+ * SCL: GPIO-5 (D1)
+ * LED: GPIO-2 (D4)
+ * Encoder A: GPIO-12 (D6, unused MISO)
+ * Encoder B: GPIO-2 (D4)
+ * Encoder switch: GPIO-3 (RX, in parallel with the OK button)
+ *
+ * Every other interrupt-capable pin carries the display, the I2C bus or
+ * a button. With the encoder, the polled OK button moves to RX, which
+ * the USB-UART bridge also drives: host traffic only shows up as pulses
+ * shorter than the debounce time, where on an encoder phase it would be
+ * decoded as detents. Serial is then started transmit-only, and D4 goes
+ * to encoder B; it is a boot strapping pin, so the encoder must leave it
+ * high at rest (both contacts open at a detent, as most encoders do).
+ * The switch is read as OK anyway, so it shares the OK pin.
+ */
+struct BoardEsp8266 {
+  static const uint8_t LCD_CS = D0;
+  static const uint8_t LCD_DC = D8;
+  static const uint8_t LCD_RST = D3;
+  typedef FastPin<D2> BtnUp;
+  typedef FastPin<D3> BtnDown;
+#if defined(ENABLE_ENCODER)
+  typedef FastPin<3> BtnOk;
+#else
+  typedef FastPin<D4> BtnOk;
+#endif
+  typedef FastPin<D6> EncA;
+  typedef FastPin<D4> EncB;
+  typedef BtnOk EncSw;
+  typedef U8G2_PCD8544_84X48_F_4W_HW_SPI Display;
+  typedef ESP8266WebServer Server;
+  static bool beginFs() { return LittleFS.begin(); }
+  static void attachEncoder(void (*isr)()) {
+    attachInterrupt(digitalPinToInterrupt(EncA::pin), isr, CHANGE);
+    attachInterrupt(digitalPinToInterrupt(EncB::pin), isr, CHANGE);
+  }
+};
+#define BOARD_DESCRIPTOR BoardEsp8266
+#if defined(ENABLE_ENCODER)
+#define BOARD_BUTTON_ON_RX 1
+#endif
+#define BOARD_HAS_WIFI 1
+#define BOARD_HAS_FS 1
+
+#elif defined(ESP32) && defined(CONFIG_IDF_TARGET_ESP32C3)
+/**
+ * @brief ESP32-C3 DevKitM-1
+ *
+ * The C3 only has GPIO0..GPIO21 and uses GPIO4..GPIO7 for SPI and
+ * GPIO8/GPIO9 for I2C, so the ESP32 pin mapping cannot be reused.
+ * The encoder keeps off the native USB pins (GPIO18/19): A is on GPIO5
+ * (the unused SPI MISO) and B takes GPIO2 from the OK button, which is
+ * polled and moves to GPIO20 (U0RXD, driven by the USB-UART bridge,
+ * whose traffic the debounce filters out; Serial is then started
+ * transmit-only). GPIO2 is a strapping pin, so the encoder must leave it
+ * high at rest. The switch shares the OK pin, as it is read as OK anyway.
+ */
+struct BoardEsp32c3 {
+  static const uint8_t LCD_CS = 7;
+  static const uint8_t LCD_DC = 10;
+  static const uint8_t LCD_RST = 3;
+  typedef FastPin<0> BtnUp;
+  typedef FastPin<1> BtnDown;
+#if defined(ENABLE_ENCODER)
+  typedef FastPin<20> BtnOk;
+#else
+  typedef FastPin<2> BtnOk;
+#endif
+  typedef FastPin<5> EncA;
+  typedef FastPin<2> EncB;
+  typedef BtnOk EncSw;
+  typedef U8G2_PCD8544_84X48_F_4W_HW_SPI Display;
+  typedef WebServer Server;
+  static bool beginFs() { return LittleFS.begin(true); }  // Format on first use
+  static void attachEncoder(void (*isr)()) {
+    attachInterrupt(digitalPinToInterrupt(EncA::pin), isr, CHANGE);
+    attachInterrupt(digitalPinToInterrupt(EncB::pin), isr, CHANGE);
+  }
+};
+#define BOARD_DESCRIPTOR BoardEsp32c3
+#if defined(ENABLE_ENCODER)
+#define BOARD_BUTTON_ON_RX 1
+#endif
+#define BOARD_HAS_WIFI 1
+#define BOARD_HAS_FS 1
+
+#elif defined(ESP32)
+/**
+ * @brief ESP32 DevKit
+ */
+struct BoardEsp32 {
+  static const uint8_t LCD_CS = 15;
+  static const uint8_t LCD_DC = 4;
+  static const uint8_t LCD_RST = 5;
+  typedef FastPin<12> BtnUp;
+  typedef FastPin<14> BtnDown;
+  typedef FastPin<27> BtnOk;
+  typedef FastPin<16> EncA;
+  typedef FastPin<17> EncB;
+  typedef FastPin<13> EncSw;
+  typedef U8G2_PCD8544_84X48_F_4W_HW_SPI Display;
+  typedef WebServer Server;
+  static bool beginFs() { return LittleFS.begin(true); }  // Format on first use
+  static void attachEncoder(void (*isr)()) {
+    attachInterrupt(digitalPinToInterrupt(EncA::pin), isr, CHANGE);
+    attachInterrupt(digitalPinToInterrupt(EncB::pin), isr, CHANGE);
+  }
+};
+#define BOARD_DESCRIPTOR BoardEsp32
+#define BOARD_HAS_WIFI 1
+#define BOARD_HAS_FS 1
+
+#elif defined(ARDUINO_SIM)
+/**
+ * @brief Host simulation (env:native, see lib/sim/sim.h)
+ *
+ * The ESP32 DevKit pins, on simulated GPIO; no filesystem.
+ */
+struct BoardSim {
+  static const uint8_t LCD_CS = 15;
+  static const uint8_t LCD_DC = 4;
+  static const uint8_t LCD_RST = 5;
+  typedef FastPin<12> BtnUp;
+  typedef FastPin<14> BtnDown;
+  typedef FastPin<27> BtnOk;
+  typedef FastPin<16> EncA;
+  typedef FastPin<17> EncB;
+  typedef FastPin<13> EncSw;
+  typedef U8G2_PCD8544_84X48_F_4W_HW_SPI Display;
+  typedef WebServer Server;
+  static void attachEncoder(void (*isr)()) {
+    attachInterrupt(digitalPinToInterrupt(EncA::pin), isr, CHANGE);
+    attachInterrupt(digitalPinToInterrupt(EncB::pin), isr, CHANGE);
+  }
+};
+#define BOARD_DESCRIPTOR BoardSim
+#define BOARD_HAS_WIFI 1
+
+#else
+#error "Unsupported board: add a descriptor to board.h"
+#endif
+
+#ifndef BOARD_HAS_WIFI
+#define BOARD_HAS_WIFI 0
+#endif
+#ifndef BOARD_HAS_FS
+#define BOARD_HAS_FS 0
+#endif
+#ifndef BOARD_BUTTON_ON_RX
+#define BOARD_BUTTON_ON_RX 0
+#endif
+
+typedef BOARD_DESCRIPTOR Board;
+
+#endif // BOARD_H
@@ -0,0 +1,132 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Stackless coroutines
+ *
+ * Protothread style macros for flows that wait (seek, band scan, WiFi
+ * connection), so they can be written as straight code and still run a
+ * small step per loop pass instead of blocking it:
+ *
+ *   Coroutine blinkTask;
+ *
+ *   void serviceBlink() {
+ *     CO_BEGIN(blinkTask);
+ *     for (blinkCount = 0; blinkCount < 3; blinkCount++) {
+ *       digitalWrite(LED_BUILTIN, HIGH);
+ *       CO_AWAIT_MS(blinkTask, 200);
+ *       digitalWrite(LED_BUILTIN, LOW);
+ *       CO_AWAIT_MS(blinkTask, 200);
+ *     }
+ *     CO_END(blinkTask);
+ *   }
+ *
+ * coStart(blinkTask) starts (or restarts) it, the loop calls
+ * serviceBlink() on every pass, coStop() abandons it.
+ *
+ * The body is a switch on the line of the last wait, so:
+ * - local variables do not survive a wait, keep state in globals;
+ * - a wait cannot sit inside a switch statement of the body;
+ * - only one wait per source line.
+ *
+ * No heap, no stack of its own: a Coroutine takes at most 8 bytes.
+ */
+
+#ifndef COROUTINE_H
+#define COROUTINE_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Coroutine state
+ */
+struct Coroutine {
+  uint16_t line;          // Line of the wait to resume at, 0 at the start
+  bool running;
+  unsigned long since;    // millis() when CO_AWAIT_MS() started
+};
+
+/**
+ * @brief Start a coroutine from the beginning
+ */
+inline void coStart(Coroutine &co) {
+  co.line = 0;
+  co.running = true;
+}
+
+/**
+ * @brief Abandon a coroutine where it is
+ */
+inline void coStop(Coroutine &co) {
+  co.running = false;
+}
+
+/**
+ * @brief Check whether a coroutine has been started and not finished
+ */
+inline bool coRunning(const Coroutine &co) {
+  return co.running;
+}
+
+// The case labels the macros place after a statement fall through on
+// purpose
+#if defined(__GNUC__) && __GNUC__ >= 7
+#define CO_FALLTHROUGH __attribute__((fallthrough))
+#else
+#define CO_FALLTHROUGH
+#endif
+
+// Start of the body: returns at once if not running, else resumes at the
+// last wait
+#define CO_BEGIN(co) \
+  if (!(co).running) return; \
+  switch ((co).line) { case 0:
+
+// Return now and resume here once cond is true (checked at every pass)
+#define CO_AWAIT_UNTIL(co, cond) \
+  do { \
+    (co).line = __LINE__; CO_FALLTHROUGH; case __LINE__: \
+    if (!(cond)) return; \
+  } while (0)
+
+// Return now and resume here after ms milliseconds
+#define CO_AWAIT_MS(co, ms) \
+  do { \
+    (co).since = millis(); \
+    CO_AWAIT_UNTIL(co, millis() - (co).since >= (unsigned long)(ms)); \
+  } while (0)
+
+// Return now and resume here on the next pass
+#define CO_YIELD(co) \
+  do { \
+    (co).line = __LINE__; return; case __LINE__:; \
+  } while (0)
+
+// Finish early
+#define CO_EXIT(co) \
+  do { \
+    (co).running = false; \
+    return; \
+  } while (0)
+
+// End of the body
+#define CO_END(co) \
+  } \
+  (co).running = false
+
+#endif // COROUTINE_H
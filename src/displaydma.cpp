@@ -0,0 +1,243 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <Arduino.h>
+
+#include "board.h"
+
+#if BOARD_HAS_WIFI
+  #include "config.h"
+#endif
+
+#if defined(ESP32) && defined(ENABLE_DISPLAY_DMA)
+
+#include <SPI.h>
+#include <driver/spi_master.h>
+
+#include "displaydma.h"
+
+// PCD8544 geometry and the commands that set the RAM address
+const uint8_t DMA_WIDTH = 84;
+static_assert(DMA_WIDTH % 4 == 0, "Rows must stay word aligned");
+const uint8_t DMA_PAGES = 6;
+const uint8_t PCD8544_BASIC = 0x20;      // Powered, horizontal, basic set
+const uint8_t PCD8544_SET_Y = 0x40;
+const uint8_t PCD8544_SET_X = 0x80;
+
+// Same bus as U8g2 uses through SPIClass, at the PCD8544 clock
+#if defined(CONFIG_IDF_TARGET_ESP32C3)
+const spi_host_device_t DMA_HOST = SPI2_HOST;
+#else
+const spi_host_device_t DMA_HOST = SPI3_HOST;
+#endif
+const int DMA_CLOCK_HZ = 4000000;
+
+// Two transactions per page row, address (command) and pixels (data),
+// and room for two whole frames
+const uint8_t DMA_QUEUE = 2 * 2 * DMA_PAGES;
+const uint8_t DMA_BUFFERS = 2;
+
+// Transaction user field: data/command flag and transfer buffer index
+const uintptr_t DMA_USER_DATA = 0x01;
+const uintptr_t DMA_USER_LAST = 0x02;   // Last transaction of a frame
+const uint8_t DMA_USER_BUFFER_SHIFT = 2;
+
+spi_device_handle_t dmaDevice = NULL;
+uint8_t dmaDcPin = 0;
+// Packed frames, 84 bytes per page, in DMA capable internal RAM
+WORD_ALIGNED_ATTR uint8_t dmaFrames[DMA_BUFFERS][DMA_PAGES * DMA_WIDTH];
+uint8_t dmaInFlight[DMA_BUFFERS];         // Queued transactions per buffer
+uint8_t dmaNext = 0;                      // Buffer the next frame goes to
+// Transaction pool, used in order; the driver returns transactions in
+// order too, so with fewer than DMA_QUEUE not yet collected the next
+// slot is free
+spi_transaction_t dmaTrans[DMA_QUEUE];
+uint8_t dmaTransHead = 0;
+uint8_t dmaQueued = 0;
+unsigned long dmaQueuedAt = 0;
+volatile unsigned long dmaDoneAt = 0;     // Set by dmaPostTransfer()
+DisplayDmaStats dmaStats;
+
+/**
+ * @brief Set the D/C line before each transaction (SPI driver callback)
+ */
+void IRAM_ATTR dmaPreTransfer(spi_transaction_t *t) {
+  gpio_set_level((gpio_num_t)dmaDcPin, (uintptr_t)t->user & DMA_USER_DATA);
+}
+
+/**
+ * @brief Stamp the end of a frame (SPI driver callback)
+ */
+void IRAM_ATTR dmaPostTransfer(spi_transaction_t *t) {
+  if ((uintptr_t)t->user & DMA_USER_LAST) dmaDoneAt = micros();
+}
+
+/**
+ * @brief Take back one finished transaction from the driver
+ *
+ * @param wait Block until one finishes
+ * @return false if none was finished (and wait was not set)
+ */
+bool dmaCollect(bool wait) {
+  if (!dmaQueued) return false;
+  spi_transaction_t *t;
+  if (spi_device_get_trans_result(dmaDevice, &t, wait ? portMAX_DELAY : 0) != ESP_OK) return false;
+  uintptr_t user = (uintptr_t)t->user;
+  dmaInFlight[user >> DMA_USER_BUFFER_SHIFT]--;
+  dmaQueued--;
+  if (user & DMA_USER_LAST) {
+    dmaStats.transferMicros = dmaDoneAt - dmaQueuedAt;
+    dmaStats.sent++;
+    dmaStats.sentAt = dmaDoneAt;
+  }
+  return true;
+}
+
+/**
+ * @brief Queue one transaction
+ */
+void dmaQueue(const uint8_t *data, uint8_t len, uintptr_t user) {
+  while (dmaQueued >= DMA_QUEUE) dmaCollect(true);
+  spi_transaction_t &t = dmaTrans[dmaTransHead];
+  dmaTransHead = (dmaTransHead + 1) % DMA_QUEUE;
+  memset(&t, 0, sizeof(t));
+  t.length = len * 8;
+  t.user = (void *)user;
+  if (user & DMA_USER_DATA) {
+    t.tx_buffer = data;
+  } else {
+    t.flags = SPI_TRANS_USE_TXDATA;
+    memcpy(t.tx_data, data, len);
+  }
+  if (spi_device_queue_trans(dmaDevice, &t, portMAX_DELAY) == ESP_OK) {
+    dmaInFlight[user >> DMA_USER_BUFFER_SHIFT]++;
+    dmaQueued++;
+  }
+}
+
+/**
+ * @brief Take the display SPI bus over from U8g2
+ *
+ * Call after u8g2.begin(), which has initialized the controller.
+ *
+ * @param csPin Display chip select
+ * @param dcPin Display data/command select
+ * @return false if the SPI driver could not be set up; U8g2 then keeps
+ *         the bus
+ */
+bool displayDmaBegin(uint8_t csPin, uint8_t dcPin) {
+  SPI.end();
+  dmaDcPin = dcPin;
+  pinMode(dcPin, OUTPUT);
+
+  spi_bus_config_t bus;
+  memset(&bus, 0, sizeof(bus));
+  bus.mosi_io_num = MOSI;
+  bus.miso_io_num = -1;
+  bus.sclk_io_num = SCK;
+  bus.quadwp_io_num = -1;
+  bus.quadhd_io_num = -1;
+  bus.max_transfer_sz = sizeof(dmaFrames[0]);
+  if (spi_bus_initialize(DMA_HOST, &bus, SPI_DMA_CH_AUTO) != ESP_OK) {
+    SPI.begin();
+    return false;
+  }
+
+  spi_device_interface_config_t dev;
+  memset(&dev, 0, sizeof(dev));
+  dev.clock_speed_hz = DMA_CLOCK_HZ;
+  dev.mode = 0;
+  dev.spics_io_num = csPin;
+  dev.queue_size = DMA_QUEUE;
+  dev.pre_cb = dmaPreTransfer;
+  dev.post_cb = dmaPostTransfer;
+  if (spi_bus_add_device(DMA_HOST, &dev, &dmaDevice) != ESP_OK) {
+    spi_bus_free(DMA_HOST);
+    SPI.begin();
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Send an area of the frame buffer to the display, in the
+ * background
+ *
+ * Packs the whole frame into the next transfer buffer (waiting for it
+ * if a previous frame is still going out of it), then queues the
+ * address and pixels of each page row of the area. The columns are
+ * widened to multiples of four, so each row starts word aligned in the
+ * buffer and the driver sends it in place instead of copying it to a
+ * bounce buffer; the extra columns come from the same frame.
+ *
+ * @param frame U8g2 frame buffer
+ * @param stride Bytes per page row in the frame buffer
+ * @param x First column, in controller coordinates
+ * @param w Columns
+ * @param page First page (8 pixel row)
+ * @param pages Pages
+ */
+void displayDmaSend(const uint8_t *frame, uint8_t stride, uint8_t x, uint8_t w,
+                    uint8_t page, uint8_t pages) {
+  uint8_t buf = dmaNext;
+  dmaNext = (dmaNext + 1) % DMA_BUFFERS;
+  if (dmaInFlight[buf]) {
+    unsigned long start = micros();
+    while (dmaInFlight[buf]) dmaCollect(true);
+    dmaStats.waits++;
+    dmaStats.waitMicros += micros() - start;
+  }
+
+  uint8_t *packed = dmaFrames[buf];
+  for (uint8_t p = 0; p < DMA_PAGES; p++) {
+    memcpy(packed + p * DMA_WIDTH, frame + p * stride, DMA_WIDTH);
+  }
+
+  if (x >= DMA_WIDTH || page >= DMA_PAGES) return;
+  if (x + w > DMA_WIDTH) w = DMA_WIDTH - x;
+  w = (x + w - (x & ~3) + 3) & ~3;
+  x &= ~3;
+  if (page + pages > DMA_PAGES) pages = DMA_PAGES - page;
+  uintptr_t user = (uintptr_t)buf << DMA_USER_BUFFER_SHIFT;
+  dmaQueuedAt = micros();
+  for (uint8_t p = page; p < page + pages; p++) {
+    uint8_t cmd[3] = {PCD8544_BASIC, (uint8_t)(PCD8544_SET_Y | p), (uint8_t)(PCD8544_SET_X | x)};
+    dmaQueue(cmd, sizeof(cmd), user);
+    uintptr_t last = p + 1 == page + pages ? DMA_USER_LAST : 0;
+    dmaQueue(packed + p * DMA_WIDTH + x, w, user | DMA_USER_DATA | last);
+  }
+  dmaStats.frames++;
+}
+
+/**
+ * @brief Take back the transactions the driver has finished
+ *
+ * Call from the loop; never blocks.
+ */
+void displayDmaService() {
+  while (dmaCollect(false)) {}
+}
+
+/**
+ * @brief Get the transfer counters
+ */
+const DisplayDmaStats &displayDmaStats() {
+  return dmaStats;
+}
+
+#endif // ESP32 && ENABLE_DISPLAY_DMA
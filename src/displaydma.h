@@ -0,0 +1,67 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Display transfer by SPI DMA (ENABLE_DISPLAY_DMA, ESP32 only)
+ *
+ * U8g2 sends the frame buffer synchronously: updateDisplay() waits for
+ * the 504 bytes to go out at 4 MHz. With this backend the frame is
+ * packed into one of two transfer buffers and queued to the ESP-IDF SPI
+ * master driver, which sends it by DMA while the loop goes on; the next
+ * frame is rendered into the U8g2 buffer meanwhile and goes out of the
+ * other transfer buffer.
+ *
+ * A transfer buffer is never written while the DMA reads it: packing a
+ * frame first waits for the transfers still reading that buffer (counted
+ * in waits), so a frame is always sent whole, never torn. The driver
+ * reports finished transfers through its result queue, which
+ * displayDmaService() drains in the display section of the loop.
+ *
+ * The backend takes the SPI bus over from U8g2 once the display is
+ * initialized (u8g2.begin()); from then on all frame and area updates
+ * must go through it.
+ */
+
+#ifndef DISPLAYDMA_H
+#define DISPLAYDMA_H
+
+#include <Arduino.h>
+
+#if defined(ESP32) && defined(ENABLE_DISPLAY_DMA)
+
+/**
+ * @brief Display transfer counters
+ */
+struct DisplayDmaStats {
+  unsigned long frames;           // Frames and areas queued
+  unsigned long waits;            // Times a transfer buffer was still busy
+  unsigned long waitMicros;       // Time spent waiting for one
+  unsigned long transferMicros;   // Queueing to completion, last frame
+  unsigned long sent;             // Frames and areas sent
+  unsigned long sentAt;           // micros() at the end of the last one
+};
+
+bool displayDmaBegin(uint8_t csPin, uint8_t dcPin);
+void displayDmaSend(const uint8_t *frame, uint8_t stride, uint8_t x, uint8_t w,
+                    uint8_t page, uint8_t pages);
+void displayDmaService();
+const DisplayDmaStats &displayDmaStats();
+
+#endif // ESP32 && ENABLE_DISPLAY_DMA
+
+#endif // DISPLAYDMA_H
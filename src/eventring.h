@@ -0,0 +1,126 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Interrupt to loop event ring
+ *
+ * Single producer (one interrupt handler), single consumer (the loop)
+ * ring, with no lock and no interrupt masking on the fast path:
+ *
+ * - head is written only by push(), tail only by pop(); both are single
+ *   bytes, so every read and write of them is atomic, even on AVR.
+ * - push() stores the event before publishing the new head, pop() reads
+ *   the head before the event and releases the slot only after reading
+ *   it. EVENT_BARRIER() keeps that order: a compiler barrier on AVR
+ *   (one core, in-order), a full memory barrier on ESP.
+ * - A full ring drops the new event and counts it in overflows().
+ *   The counter is 16 bit, so on AVR it is read with interrupts masked.
+ *
+ * push() is IRAM_ATTR, so it can be called from ESP interrupt handlers.
+ * Size must be a power of two; the ring holds Size - 1 events.
+ */
+
+#ifndef EVENTRING_H
+#define EVENTRING_H
+
+#include <Arduino.h>
+
+#include "board.h"
+
+#if defined(__AVR__)
+  #include <util/atomic.h>
+  #define EVENT_BARRIER() __asm__ __volatile__("" ::: "memory")
+#else
+  #define EVENT_BARRIER() __sync_synchronize()
+#endif
+
+/**
+ * @brief Event handed from an interrupt handler to the loop
+ */
+struct InputEvent {
+  uint8_t type;           // InputEventType
+  int8_t value;           // Type specific
+};
+
+// Event types
+enum InputEventType : uint8_t {
+  EVENT_ENCODER,          // Encoder detent, value +1 or -1
+};
+
+template <typename T, uint8_t Size>
+class EventRing {
+  static_assert(Size >= 2 && (Size & (Size - 1)) == 0, "EventRing size must be a power of two");
+  static const uint8_t MASK = Size - 1;
+
+public:
+  /**
+   * @brief Queue an event; producer side, interrupt context
+   *
+   * @return False if the ring was full and the event dropped
+   */
+  bool IRAM_ATTR push(const T &event) {
+    uint8_t h = head;
+    uint8_t next = (h + 1) & MASK;
+    if (next == tail) {
+      overflowCount++;
+      return false;
+    }
+    events[h] = event;
+    EVENT_BARRIER();
+    head = next;
+    return true;
+  }
+
+  /**
+   * @brief Take the oldest event; consumer side, loop context
+   *
+   * @return False if the ring was empty
+   */
+  bool pop(T &event) {
+    uint8_t t = tail;
+    if (t == head) return false;
+    EVENT_BARRIER();
+    event = events[t];
+    EVENT_BARRIER();
+    tail = (t + 1) & MASK;
+    return true;
+  }
+
+  /**
+   * @brief Get the number of events dropped because the ring was full
+   */
+  uint16_t overflows() const {
+#if defined(__AVR__)
+    uint16_t count;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+      count = overflowCount;
+    }
+    return count;
+#else
+    return overflowCount;
+#endif
+  }
+
+private:
+  T events[Size];
+  volatile uint8_t head = 0;
+  volatile uint8_t tail = 0;
+  volatile uint16_t overflowCount = 0;
+};
+
+#endif // EVENTRING_H
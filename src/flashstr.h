@@ -0,0 +1,48 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Constant strings kept in flash
+ *
+ * On AVR every string literal is copied to SRAM at boot, and on ESP8266
+ * it lives in DRAM; only strings declared PROGMEM stay in flash. The
+ * firmware writes its literals in place as F("...") for print() and
+ * String, or PSTR("...") for the *_P functions (snprintf_P,
+ * sendContent_P). Tables of names (trace events, loop sections) are
+ * PROGMEM arrays handed out as FPSTR() of an entry.
+ *
+ * A const __FlashStringHelper * is consumed directly, with no RAM copy,
+ * by Serial and the display (both Print), and by String, which the web
+ * pages are built in. Only code that needs a plain char * (snprintf
+ * "%s", U8g2 width measurement) copies it to the stack with strcpy_P().
+ *
+ * On ESP32 flash is mapped into the data address space, so there all of
+ * this compiles to plain pointers.
+ */
+
+#ifndef FLASHSTR_H
+#define FLASHSTR_H
+
+#include <Arduino.h>
+
+// ESP cores have it, AVR does not
+#if !defined(FPSTR)
+#define FPSTR(p) (reinterpret_cast<const __FlashStringHelper *>(p))
+#endif
+
+#endif // FLASHSTR_H
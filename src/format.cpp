@@ -0,0 +1,85 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <Arduino.h>
+
+#include "format.h"
+
+/**
+ * @brief Write an unsigned number in decimal
+ *
+ * @param buf At least FORMAT_UNSIGNED_SIZE bytes
+ * @return Length of the text
+ */
+uint8_t formatUnsigned(char *buf, unsigned long value) {
+  // Digits come out last first, fill from the end of a scratch buffer
+  char digits[FORMAT_UNSIGNED_SIZE];
+  uint8_t pos = sizeof(digits);
+  do {
+    digits[--pos] = '0' + value % 10;
+    value /= 10;
+  } while (value);
+  uint8_t len = sizeof(digits) - pos;
+  memcpy(buf, digits + pos, len);
+  buf[len] = '\0';
+  return len;
+}
+
+/**
+ * @brief Write a frequency in MHz with one decimal
+ *
+ * @param buf At least FORMAT_FREQUENCY_SIZE bytes
+ * @param frequency Frequency in 10 kHz units
+ * @return Length of the text
+ */
+uint8_t formatFrequency(char *buf, uint16_t frequency) {
+  uint8_t len = formatUnsigned(buf, frequency / 100);
+  buf[len++] = '.';
+  buf[len++] = '0' + (frequency % 100) / 10;
+  buf[len] = '\0';
+  return len;
+}
+
+/**
+ * @brief Write a 16 bit value as four uppercase hex digits
+ *
+ * @param buf At least FORMAT_HEX4_SIZE bytes
+ * @return Length of the text, always 4
+ */
+uint8_t formatHex4(char *buf, uint16_t value) {
+  for (int8_t i = 3; i >= 0; i--) {
+    uint8_t nibble = value & 0x0F;
+    buf[i] = nibble < 10 ? '0' + nibble : 'A' + nibble - 10;
+    value >>= 4;
+  }
+  buf[4] = '\0';
+  return 4;
+}
+
+/**
+ * @brief Print a frequency in MHz with one decimal
+ *
+ * @param out Serial, the display or any other Print
+ * @param frequency Frequency in 10 kHz units
+ * @return Number of characters printed
+ */
+size_t printFrequency(Print &out, uint16_t frequency) {
+  char buf[FORMAT_FREQUENCY_SIZE];
+  uint8_t len = formatFrequency(buf, frequency);
+  return out.write(buf, len);
+}
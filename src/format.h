@@ -0,0 +1,47 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Integer number formatting
+ *
+ * Writes frequencies, counters and hex codes into caller buffers, with
+ * integer arithmetic only: no float (dtostrf(), String(float),
+ * print(double) bring in the float library, several KB on AVR), no
+ * printf, no heap. Each function NUL terminates the buffer and returns
+ * the length of the text.
+ *
+ * Frequencies are in 10 kHz units, as the tuner uses them, and are
+ * written in MHz with one decimal ("87.5", "108.0").
+ */
+
+#ifndef FORMAT_H
+#define FORMAT_H
+
+#include <Arduino.h>
+
+// Buffer sizes, terminator included
+const uint8_t FORMAT_FREQUENCY_SIZE = 6;      // "108.0"
+const uint8_t FORMAT_UNSIGNED_SIZE = 11;      // "4294967295"
+const uint8_t FORMAT_HEX4_SIZE = 5;           // "C201"
+
+uint8_t formatUnsigned(char *buf, unsigned long value);
+uint8_t formatFrequency(char *buf, uint16_t frequency);
+uint8_t formatHex4(char *buf, uint16_t value);
+size_t printFrequency(Print &out, uint16_t frequency);
+
+#endif // FORMAT_H
@@ -0,0 +1,163 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <Arduino.h>
+
+#include "board.h"
+
+#if BOARD_HAS_WIFI
+  #include "config.h"
+#endif
+
+#if defined(ENABLE_STATIC_ALLOC)
+
+#include "heapguard.h"
+
+#if defined(ESP8266)
+  #include <coredecls.h>
+#elif defined(ARDUINO_SIM)
+  #include "sim.h"
+#endif
+
+HeapGuardStats heapGuard;
+bool heapGuardArmed = false;
+bool heapGuardBusy = false;         // Loop inside an allocator, do not count again
+#if defined(ESP32)
+TaskHandle_t heapGuardLoopTask = NULL;
+#endif
+
+/**
+ * @brief Check whether the caller is the loop
+ */
+static bool heapguardInLoop() {
+#if defined(ESP32)
+  return xTaskGetCurrentTaskHandle() == heapGuardLoopTask;
+#elif defined(ESP8266)
+  // Only the loop (cont) context can yield, the SYS context cannot
+  return can_yield();
+#elif defined(ARDUINO_SIM)
+  // Not the test script between loop passes, nor the simulation's own
+  // bookkeeping
+  return simInFirmware();
+#else
+  // Interrupt handlers do not allocate
+  return true;
+#endif
+}
+
+#if defined(STATIC_ALLOC_TRAP)
+/**
+ * @brief Stop the firmware on an unexpected allocation
+ */
+static void heapguardTrap() {
+#if defined(__AVR__)
+  // Interrupts stay on: the watchdog timer records the stall, then resets
+  for (;;) {}
+#else
+  // Crash reset, blamed on the section by watchdogBegin()
+  abort();
+#endif
+}
+#endif
+
+/**
+ * @brief Count an allocation of the loop
+ *
+ * Nested calls (calloc and realloc may call malloc) are counted once.
+ *
+ * @return True if counted; the caller then clears heapGuardBusy
+ */
+static bool heapguardNote(size_t size) {
+  if (!heapGuardArmed || heapGuardBusy || !heapguardInLoop()) return false;
+  heapGuardBusy = true;
+  uint8_t section = watchdogSection();
+  if (section >= WD_SECTIONS) return true;
+  heapGuard.total++;
+  heapGuard.sections[section]++;
+  heapGuard.lastSection = section;
+  heapGuard.lastSize = size;
+#if defined(STATIC_ALLOC_TRAP)
+  if (!heapguardExpected(section)) {
+    Serial.print(F("HEAP: "));
+    Serial.print((unsigned long)size);
+    Serial.print(F(" bytes allocated in "));
+    Serial.println(watchdogSectionName(section));
+    Serial.flush();
+    heapguardTrap();
+  }
+#endif
+  return true;
+}
+
+// Linked in place of the allocator with -Wl,--wrap=malloc,... (see the
+// static build flags in platformio.ini)
+extern "C" {
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size) {
+  bool counted = heapguardNote(size);
+  void *ptr = __real_malloc(size);
+  if (counted) heapGuardBusy = false;
+  return ptr;
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+  bool counted = heapguardNote(count * size);
+  void *ptr = __real_calloc(count, size);
+  if (counted) heapGuardBusy = false;
+  return ptr;
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+  bool counted = heapguardNote(size);
+  ptr = __real_realloc(ptr, size);
+  if (counted) heapGuardBusy = false;
+  return ptr;
+}
+}
+
+/**
+ * @brief Start counting the allocations of the loop
+ *
+ * Call at the end of setup(), from the loop task.
+ */
+void heapguardArm() {
+  memset(&heapGuard, 0, sizeof(heapGuard));
+#if defined(ESP32)
+  heapGuardLoopTask = xTaskGetCurrentTaskHandle();
+#endif
+  heapGuardArmed = true;
+}
+
+/**
+ * @brief Check whether a section runs library code that allocates
+ */
+bool heapguardExpected(uint8_t section) {
+  return section == WD_WEB || section == WD_WIFI || section == WD_HISTORY;
+}
+
+/**
+ * @brief Get the allocation counters
+ */
+const HeapGuardStats &heapguardStats() {
+  return heapGuard;
+}
+
+#endif // ENABLE_STATIC_ALLOC
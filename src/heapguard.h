@@ -0,0 +1,73 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Heap allocation guard (ENABLE_STATIC_ALLOC)
+ *
+ * The *_static environments in platformio.ini build the static
+ * allocation profile: runtime buffers (the HTTP response, RDS text,
+ * station and survey tables, trace and history rings) are allocated
+ * statically or reserved in setup(), and the linker routes malloc(),
+ * calloc() and realloc() through this module (-Wl,--wrap).
+ *
+ * Once heapguardArm() is called at the end of setup(), every allocation
+ * made by the loop is counted against the loop section running (see
+ * watchdog.h). Allocations from other contexts (the WiFi stack, other
+ * tasks) are not the loop's and are ignored.
+ *
+ * The profile does not make a web request allocation-free: the web
+ * server library allocates on its own for every request (the URI and
+ * arguments when parsing it, the response header), and so do the WiFi
+ * stack and LittleFS. The web, wifi and history sections are therefore
+ * counted but expected to allocate. The firmware's own handlers do not
+ * (they send from the response buffer or from char arrays, and read
+ * arguments short enough for the inline buffer of a String); the
+ * native_static environment checks that all the web allocations are
+ * the library's. Any other section must stay at zero: with
+ * STATIC_ALLOC_TRAP defined, an allocation there is logged and the
+ * firmware stops, so the watchdog pins the section (a stall record and
+ * then a watchdog reset on AVR, a crash reset blamed on the section on
+ * ESP).
+ */
+
+#ifndef HEAPGUARD_H
+#define HEAPGUARD_H
+
+#include <Arduino.h>
+
+#include "watchdog.h"
+
+#if defined(ENABLE_STATIC_ALLOC)
+
+/**
+ * @brief Allocations made by the loop since heapguardArm()
+ */
+struct HeapGuardStats {
+  unsigned long total;                      // All sections
+  unsigned long sections[WD_SECTIONS];      // Per WatchdogSection
+  uint8_t lastSection;                      // Section of the last one
+  size_t lastSize;                          // Size of the last one
+};
+
+void heapguardArm();
+bool heapguardExpected(uint8_t section);
+const HeapGuardStats &heapguardStats();
+
+#endif // ENABLE_STATIC_ALLOC
+
+#endif // HEAPGUARD_H
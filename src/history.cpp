@@ -0,0 +1,597 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <Arduino.h>
+
+#include "board.h"
+
+#if BOARD_HAS_WIFI
+  #include "config.h"
+#endif
+
+#if defined(ENABLE_HISTORY)
+
+#if !BOARD_HAS_FS
+#error "ENABLE_HISTORY needs a board with a filesystem"
+#endif
+
+#include "history.h"
+
+// Storage layout
+const uint8_t HIST_VERSION = 1;
+const uint8_t HIST_COMPACTED = 0x80;        // Version byte flag
+const size_t HIST_HEADER_SIZE = 10;
+const uint32_t HIST_SEGMENT_MAX = 16384;    // Bytes per segment (soft limit)
+const uint32_t HIST_SEGMENTS_MAX = 16;      // Segments kept, oldest deleted first
+const uint32_t HIST_RAW_SEGMENTS = 2;       // Newest segments never compacted
+// Largest encoded record: type, time and 206 two-byte RSSI deltas
+const size_t HIST_RECORD_MAX = 1 + 5 + 2 * HIST_SCAN_CHANNELS;
+
+// Batching
+const size_t HIST_BATCH_SIZE = 512;
+const unsigned long HIST_FLUSH_INTERVAL = 30000; // ms before a partial batch is written
+
+// Compaction
+const uint32_t HIST_ROLLUP_WINDOW = 60;     // s of samples merged into one rollup
+const uint32_t HIST_SCAN_KEEP = 3600;       // s between band scans kept
+const uint8_t HIST_COMPACT_RECORDS = 8;     // Records processed per loop pass
+
+const char HIST_DIR[] = "/hist";
+const char HIST_STATE_PATH[] = "/hist/state";
+const char HIST_TMP_PATH[] = "/hist/compact.tmp";
+
+// Persistent logger state, kept in HIST_STATE_PATH
+struct HistoryState {
+  uint16_t boot;        // Boot counter
+  uint32_t first;       // Oldest segment
+  uint32_t end;         // One past the newest segment on flash
+  uint32_t compacted;   // Segments below this one are compacted
+};
+
+// Delta coding context: previous time and frequency in a segment
+struct HistoryCodec {
+  uint32_t time;
+  uint16_t frequency;
+};
+
+// RAM batch of encoded bytes, all belonging to one segment
+struct HistoryBatch {
+  uint8_t data[HIST_BATCH_SIZE];
+  uint16_t len;
+  uint32_t seq;
+  bool sealed;          // Full (or old enough), waiting to be written
+};
+
+HistoryState histState;
+HistoryStats histStats;
+HistoryBatch histBatches[2];
+uint8_t histActive = 0;                 // Batch receiving records
+bool histSegmentOpen = false;           // A segment is being written this boot
+uint32_t histWriteSeq = 0;              // Next segment number to start
+uint32_t histSegmentBytes = 0;          // Size of the segment being written
+HistoryCodec histWriter;
+unsigned long histLastSeal = 0;
+
+// Band scan being collected
+uint8_t histScan[HIST_SCAN_CHANNELS];
+
+// Background compaction
+bool histCompacting = false;
+uint32_t histCompactSeq = 0;
+HistoryReader histCompactIn;
+File histCompactOut;
+HistoryCodec histCompactCodec;
+HistoryRecord histCompactRec;
+HistoryRecord histRollup;               // Rollup being accumulated
+uint32_t histRollupSum = 0;
+uint32_t histLastScanKept = 0;
+bool histScanKept = false;
+
+/**
+ * @brief Append an unsigned LEB128 varint
+ */
+static uint8_t *putVarint(uint8_t *p, uint32_t v) {
+  while (v >= 0x80) {
+    *p++ = (v & 0x7F) | 0x80;
+    v >>= 7;
+  }
+  *p++ = v;
+  return p;
+}
+
+/**
+ * @brief Read an unsigned LEB128 varint from a file
+ *
+ * @return false on end of file
+ */
+static bool getVarint(File &f, uint32_t &v) {
+  v = 0;
+  for (uint8_t shift = 0; shift < 35; shift += 7) {
+    int c = f.read();
+    if (c < 0) return false;
+    v |= (uint32_t)(c & 0x7F) << shift;
+    if (!(c & 0x80)) return true;
+  }
+  return false;
+}
+
+static uint32_t zigzag(int32_t v) {
+  return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static int32_t unzigzag(uint32_t v) {
+  return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+/**
+ * @brief Encode a record against a delta coding context
+ *
+ * The context is not updated; call commitRecord() once the bytes are kept.
+ *
+ * @return Encoded length, at most HIST_RECORD_MAX
+ */
+static size_t encodeRecord(uint8_t *buf, const HistoryCodec &codec, const HistoryRecord &rec) {
+  uint8_t *p = buf;
+  *p++ = rec.type;
+  p = putVarint(p, rec.time - codec.time);
+  if (rec.type == HIST_REC_SCAN) {
+    uint8_t prev = 0;
+    for (uint8_t ch = 0; ch < HIST_SCAN_CHANNELS; ch++) {
+      p = putVarint(p, zigzag((int32_t)rec.scan[ch] - prev));
+      prev = rec.scan[ch];
+    }
+  } else {
+    p = putVarint(p, zigzag((int32_t)rec.frequency - codec.frequency));
+    if (rec.type == HIST_REC_ROLLUP) {
+      p = putVarint(p, rec.count);
+      *p++ = rec.rssiMin;
+      *p++ = rec.rssiMax;
+      *p++ = rec.rssi;
+    } else {
+      *p++ = rec.rssi;
+      *p++ = rec.flags;
+    }
+  }
+  return p - buf;
+}
+
+static void commitRecord(HistoryCodec &codec, const HistoryRecord &rec) {
+  codec.time = rec.time;
+  if (rec.type != HIST_REC_SCAN) codec.frequency = rec.frequency;
+}
+
+/**
+ * @brief Build a segment header
+ */
+static void encodeHeader(uint8_t *buf, uint8_t version, uint16_t boot, uint32_t base) {
+  buf[0] = 'F';
+  buf[1] = 'M';
+  buf[2] = 'H';
+  buf[3] = version;
+  buf[4] = boot & 0xFF;
+  buf[5] = boot >> 8;
+  for (uint8_t i = 0; i < 4; i++) buf[6 + i] = (base >> (8 * i)) & 0xFF;
+}
+
+static void segmentPath(char *path, size_t len, uint32_t seq) {
+  snprintf(path, len, "%s/%08lu.seg", HIST_DIR, (unsigned long)seq);
+}
+
+static void saveState() {
+  File f = LittleFS.open(HIST_STATE_PATH, "w");
+  if (!f) return;
+  f.write((const uint8_t *)&histState, sizeof(histState));
+  f.close();
+}
+
+/**
+ * @brief Mount the filesystem and load the logger state
+ *
+ * Every boot gets a new boot number and starts a new segment.
+ *
+ * @return false if the filesystem could not be mounted
+ */
+bool historyBegin() {
+  if (!Board::beginFs()) return false;
+  LittleFS.mkdir(HIST_DIR);
+
+  memset(&histState, 0, sizeof(histState));
+  File f = LittleFS.open(HIST_STATE_PATH, "r");
+  if (f) {
+    if (f.read((uint8_t *)&histState, sizeof(histState)) != sizeof(histState)) {
+      memset(&histState, 0, sizeof(histState));
+    }
+    f.close();
+  }
+  histState.boot++;
+  saveState();
+
+  // A compaction interrupted by a reset leaves its output behind
+  LittleFS.remove(HIST_TMP_PATH);
+
+  histWriteSeq = histState.end;
+  histSegmentOpen = false;
+  return true;
+}
+
+/**
+ * @brief Seal the active batch and switch to the other one
+ *
+ * @return false if the other batch is still waiting to be written
+ */
+static bool sealBatch() {
+  HistoryBatch &current = histBatches[histActive];
+  HistoryBatch &other = histBatches[histActive ^ 1];
+  if (other.sealed) return false;
+  current.sealed = true;
+  other.len = 0;
+  other.seq = current.seq;  // Same segment until startSegment() says otherwise
+  histActive ^= 1;
+  histLastSeal = millis();
+  return true;
+}
+
+/**
+ * @brief Start a new segment, its header going into a fresh batch
+ *
+ * @return false if the active batch could not be sealed
+ */
+static bool startSegment(uint32_t base) {
+  if (histBatches[histActive].len > 0 && !sealBatch()) return false;
+  HistoryBatch &b = histBatches[histActive];
+  b.seq = histWriteSeq++;
+  encodeHeader(b.data, HIST_VERSION, histState.boot, base);
+  b.len = HIST_HEADER_SIZE;
+  histSegmentBytes = HIST_HEADER_SIZE;
+  histWriter.time = base;
+  histWriter.frequency = 0;
+  histSegmentOpen = true;
+  return true;
+}
+
+/**
+ * @brief Encode a record into the active batch
+ *
+ * Records that do not fit because both batches are full are dropped and
+ * counted; the delta coding context only advances for kept records.
+ */
+static void appendRecord(const HistoryRecord &rec) {
+  if (!histSegmentOpen || histSegmentBytes >= HIST_SEGMENT_MAX) {
+    if (!startSegment(rec.time) && !histSegmentOpen) {
+      histStats.dropped++;
+      return;
+    }
+  }
+
+  uint8_t buf[HIST_RECORD_MAX];
+  size_t n = encodeRecord(buf, histWriter, rec);
+  if (histBatches[histActive].len + n > HIST_BATCH_SIZE && !sealBatch()) {
+    histStats.dropped++;
+    return;
+  }
+
+  HistoryBatch &b = histBatches[histActive];
+  memcpy(b.data + b.len, buf, n);
+  b.len += n;
+  histSegmentBytes += n;
+  commitRecord(histWriter, rec);
+  histStats.records++;
+}
+
+/**
+ * @brief Log an RSSI sample of the tuned station
+ */
+void historyLogSample(uint16_t frequency, uint8_t rssi, uint8_t flags) {
+  static HistoryRecord sample;
+  sample.type = HIST_REC_SAMPLE;
+  sample.time = millis() / 1000;
+  sample.frequency = frequency;
+  sample.rssi = rssi;
+  sample.flags = flags;
+  appendRecord(sample);
+}
+
+/**
+ * @brief Collect one channel of a band scan
+ */
+void historyScanChannel(uint8_t channel, uint8_t rssi) {
+  if (channel < HIST_SCAN_CHANNELS) histScan[channel] = rssi;
+}
+
+/**
+ * @brief Log the band scan collected by historyScanChannel()
+ */
+void historyScanDone() {
+  static HistoryRecord scan;
+  scan.type = HIST_REC_SCAN;
+  scan.time = millis() / 1000;
+  memcpy(scan.scan, histScan, sizeof(histScan));
+  appendRecord(scan);
+}
+
+/**
+ * @brief Write one sealed batch to its segment file
+ *
+ * Creating a new segment updates the state file and deletes the oldest
+ * segments beyond HIST_SEGMENTS_MAX.
+ */
+static void flushBatch(HistoryBatch &b) {
+  char path[32];
+  segmentPath(path, sizeof(path), b.seq);
+  File f = LittleFS.open(path, "a");
+  if (f) {
+    f.write(b.data, b.len);
+    f.close();
+    histStats.bytesWritten += b.len;
+  }
+
+  if (b.seq >= histState.end) {
+    histState.end = b.seq + 1;
+    while (histState.end - histState.first > HIST_SEGMENTS_MAX) {
+      segmentPath(path, sizeof(path), histState.first);
+      LittleFS.remove(path);
+      histState.first++;
+    }
+    if (histState.compacted < histState.first) histState.compacted = histState.first;
+    saveState();
+  }
+
+  b.len = 0;
+  b.sealed = false;
+}
+
+/**
+ * @brief Write a record to the compaction output
+ */
+static void compactWrite(const HistoryRecord &rec) {
+  uint8_t buf[HIST_RECORD_MAX];
+  size_t n = encodeRecord(buf, histCompactCodec, rec);
+  histCompactOut.write(buf, n);
+  commitRecord(histCompactCodec, rec);
+}
+
+static void compactFlushRollup() {
+  if (histRollup.count == 0) return;
+  histRollup.rssi = histRollupSum / histRollup.count;
+  compactWrite(histRollup);
+  histRollup.count = 0;
+}
+
+/**
+ * @brief Start compacting the oldest uncompacted segment, if any
+ *
+ * @return false if there is nothing to compact
+ */
+static bool compactStart() {
+  if (histState.compacted < histState.first) histState.compacted = histState.first;
+  if (histState.compacted + HIST_RAW_SEGMENTS >= histState.end) return false;
+
+  histCompactSeq = histState.compacted;
+  if (!histCompactIn.open(histCompactSeq)) {
+    // Missing or damaged segment, skip it
+    histState.compacted++;
+    saveState();
+    return false;
+  }
+  histCompactOut = LittleFS.open(HIST_TMP_PATH, "w");
+  if (!histCompactOut) {
+    histCompactIn.close();
+    return false;
+  }
+
+  histCompacting = true;
+  histRollup.count = 0;
+  histScanKept = false;
+  return true;
+}
+
+/**
+ * @brief Process a few records of the segment being compacted
+ *
+ * Runs of samples on one frequency within HIST_ROLLUP_WINDOW become a
+ * single ROLLUP record, band scans closer than HIST_SCAN_KEEP to the last
+ * one kept are dropped. At the end the compacted file replaces the
+ * original segment.
+ */
+static void compactStep() {
+  for (uint8_t i = 0; i < HIST_COMPACT_RECORDS; i++) {
+    if (!histCompactIn.next(histCompactRec)) {
+      compactFlushRollup();
+      histCompactIn.close();
+      histCompactOut.close();
+      histCompacting = false;
+
+      char path[32];
+      segmentPath(path, sizeof(path), histCompactSeq);
+      if (histCompactSeq >= histState.first) {
+        LittleFS.remove(path);
+        LittleFS.rename(HIST_TMP_PATH, path);
+      } else {
+        // Rotated away while being compacted
+        LittleFS.remove(HIST_TMP_PATH);
+      }
+      histState.compacted = histCompactSeq + 1;
+      saveState();
+      histStats.compactions++;
+      return;
+    }
+
+    HistoryRecord &rec = histCompactRec;
+    if (histCompactOut.position() == 0) {
+      // First record: write the header, compacted, with the same boot
+      uint8_t header[HIST_HEADER_SIZE];
+      encodeHeader(header, HIST_VERSION | HIST_COMPACTED, rec.boot, rec.time);
+      histCompactOut.write(header, sizeof(header));
+      histCompactCodec.time = rec.time;
+      histCompactCodec.frequency = 0;
+    }
+
+    if (rec.type == HIST_REC_SAMPLE) {
+      if (histRollup.count > 0 &&
+          (rec.frequency != histRollup.frequency ||
+           rec.time - histRollup.time >= HIST_ROLLUP_WINDOW)) {
+        compactFlushRollup();
+      }
+      if (histRollup.count == 0) {
+        histRollup.type = HIST_REC_ROLLUP;
+        histRollup.time = rec.time;
+        histRollup.frequency = rec.frequency;
+        histRollup.rssiMin = rec.rssi;
+        histRollup.rssiMax = rec.rssi;
+        histRollupSum = 0;
+      }
+      if (rec.rssi < histRollup.rssiMin) histRollup.rssiMin = rec.rssi;
+      if (rec.rssi > histRollup.rssiMax) histRollup.rssiMax = rec.rssi;
+      histRollupSum += rec.rssi;
+      histRollup.count++;
+    } else if (rec.type == HIST_REC_SCAN) {
+      if (!histScanKept || rec.time - histLastScanKept >= HIST_SCAN_KEEP) {
+        compactFlushRollup();
+        compactWrite(rec);
+        histLastScanKept = rec.time;
+        histScanKept = true;
+      }
+    } else {
+      compactFlushRollup();
+      compactWrite(rec);
+    }
+  }
+}
+
+/**
+ * @brief Background work of the logger, called once per loop pass
+ *
+ * Does at most one of: writing a sealed batch, sealing a batch older than
+ * HIST_FLUSH_INTERVAL, or a compaction step. Flash is only touched in
+ * idle passes.
+ *
+ * @param idle The loop pass did no other work
+ */
+void historyService(bool idle) {
+  if (!idle) return;
+
+  HistoryBatch &pending = histBatches[histActive ^ 1];
+  if (pending.sealed) {
+    flushBatch(pending);
+    return;
+  }
+
+  HistoryBatch &active = histBatches[histActive];
+  if (active.len > 0 && millis() - histLastSeal >= HIST_FLUSH_INTERVAL) {
+    sealBatch();
+    return;
+  }
+
+  if (histCompacting) {
+    compactStep();
+  } else {
+    compactStart();
+  }
+}
+
+const HistoryStats &historyStats() {
+  return histStats;
+}
+
+uint32_t historyFirstSegment() {
+  return histState.first;
+}
+
+uint32_t historyEndSegment() {
+  return histState.end;
+}
+
+/**
+ * @brief Open a segment file for reading (header included)
+ */
+File historyOpenSegment(uint32_t seq) {
+  char path[32];
+  segmentPath(path, sizeof(path), seq);
+  return LittleFS.open(path, "r");
+}
+
+/**
+ * @brief Open a segment and read its header
+ *
+ * @return false if the segment is missing or not a history segment
+ */
+bool HistoryReader::open(uint32_t seq) {
+  file = historyOpenSegment(seq);
+  if (!file) return false;
+  uint8_t header[HIST_HEADER_SIZE];
+  if (file.read(header, sizeof(header)) != sizeof(header) ||
+      header[0] != 'F' || header[1] != 'M' || header[2] != 'H' ||
+      (header[3] & ~HIST_COMPACTED) != HIST_VERSION) {
+    file.close();
+    return false;
+  }
+  boot = header[4] | (header[5] << 8);
+  time = 0;
+  for (uint8_t i = 0; i < 4; i++) time |= (uint32_t)header[6 + i] << (8 * i);
+  frequency = 0;
+  return true;
+}
+
+/**
+ * @brief Decode the next record
+ *
+ * @return false at the end of the segment (or on a truncated record)
+ */
+bool HistoryReader::next(HistoryRecord &rec) {
+  int type = file.read();
+  uint32_t v;
+  if (type < 0 || !getVarint(file, v)) return false;
+  rec.type = type;
+  rec.boot = boot;
+  time += v;
+  rec.time = time;
+
+  if (type == HIST_REC_SCAN) {
+    uint8_t prev = 0;
+    for (uint8_t ch = 0; ch < HIST_SCAN_CHANNELS; ch++) {
+      if (!getVarint(file, v)) return false;
+      prev += unzigzag(v);
+      rec.scan[ch] = prev;
+    }
+    return true;
+  }
+
+  if (!getVarint(file, v)) return false;
+  frequency += unzigzag(v);
+  rec.frequency = frequency;
+  if (type == HIST_REC_ROLLUP) {
+    uint8_t tail[3];
+    if (!getVarint(file, v) || file.read(tail, 3) != 3) return false;
+    rec.count = v;
+    rec.rssiMin = tail[0];
+    rec.rssiMax = tail[1];
+    rec.rssi = tail[2];
+  } else {
+    uint8_t tail[2];
+    if (file.read(tail, 2) != 2) return false;
+    rec.rssi = tail[0];
+    rec.flags = tail[1];
+  }
+  return true;
+}
+
+void HistoryReader::close() {
+  file.close();
+}
+
+#endif // ENABLE_HISTORY
@@ -0,0 +1,125 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * RSSI and band scan history on LittleFS (ENABLE_HISTORY, ESP only)
+ *
+ * The log is a sequence of segment files, /hist/<seq>.seg, numbered in
+ * the order they were written. Each segment starts with a fixed 10 byte
+ * header:
+ *
+ *   'F' 'M' 'H'  magic
+ *   u8           format version, bit 7 set once the segment is compacted
+ *   u16 LE       boot number
+ *   u32 LE       base time, seconds since boot
+ *
+ * followed by records. Every record starts with a type byte and the time
+ * since the previous record (or the base time) as a varint:
+ *
+ *   SAMPLE  zigzag varint frequency delta, u8 RSSI, u8 flags
+ *   SCAN    206 zigzag varint RSSI deltas, channel to channel
+ *   ROLLUP  zigzag varint frequency delta, varint count, u8 min, u8 max,
+ *           u8 mean
+ *
+ * Frequency deltas are relative to the previous record carrying a
+ * frequency in the same segment, so a station sample is usually 5 bytes.
+ *
+ * The varint coding is an adaptation of plain fixed-size records: a
+ * station sample takes about 5 bytes instead of the 9 of fixed fields
+ * (type, u32 time, u16 frequency, RSSI, flags), which nearly doubles the
+ * history a segment holds. The price is that records cannot be indexed:
+ * a reader decodes a segment from its header on, so the log is read and
+ * served one whole segment at a time.
+ *
+ * Records are collected in two RAM batches and written to flash by
+ * historyService(), one batch per idle loop pass, so logging never
+ * blocks the loop. Old segments are compacted in the background: runs of
+ * samples on one frequency become one ROLLUP per minute and only one band
+ * scan per hour is kept. The oldest segments are deleted once the log
+ * holds HIST_SEGMENTS_MAX of them.
+ */
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <Arduino.h>
+#include "board.h"
+
+// Record types
+const uint8_t HIST_REC_SAMPLE = 1;
+const uint8_t HIST_REC_SCAN = 2;
+const uint8_t HIST_REC_ROLLUP = 3;
+
+// Channels in a band scan snapshot (87.5 to 108.0 MHz in 100 kHz steps)
+const uint8_t HIST_SCAN_CHANNELS = 206;
+
+/**
+ * @brief One decoded history record
+ */
+struct HistoryRecord {
+  uint8_t type;
+  uint16_t boot;          // Boot number the record was logged in
+  uint32_t time;          // Seconds since boot
+  uint16_t frequency;     // SAMPLE/ROLLUP, 10 kHz units
+  uint8_t rssi;           // SAMPLE RSSI, ROLLUP mean
+  uint8_t flags;          // SAMPLE signal flags
+  uint8_t rssiMin;        // ROLLUP
+  uint8_t rssiMax;        // ROLLUP
+  uint16_t count;         // ROLLUP, samples merged
+  uint8_t scan[HIST_SCAN_CHANNELS]; // SCAN, RSSI per channel
+};
+
+/**
+ * @brief History logger counters
+ */
+struct HistoryStats {
+  unsigned long records;      // Records accepted
+  unsigned long dropped;      // Records lost because both batches were full
+  unsigned long bytesWritten; // Bytes written to flash
+  unsigned long compactions;  // Segments compacted
+};
+
+bool historyBegin();
+void historyLogSample(uint16_t frequency, uint8_t rssi, uint8_t flags);
+void historyScanChannel(uint8_t channel, uint8_t rssi);
+void historyScanDone();
+void historyService(bool idle);
+const HistoryStats &historyStats();
+
+// Reading back: segments are numbered [historyFirstSegment(), historyEndSegment())
+uint32_t historyFirstSegment();
+uint32_t historyEndSegment();
+File historyOpenSegment(uint32_t seq);
+
+/**
+ * @brief Sequential decoder for one segment file
+ */
+class HistoryReader {
+public:
+  bool open(uint32_t seq);
+  bool next(HistoryRecord &rec);
+  void close();
+
+private:
+  File file;
+  uint16_t boot;
+  uint32_t time;
+  uint16_t frequency;
+};
+
+#endif // HISTORY_H
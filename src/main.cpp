@@ -21,96 +21,442 @@
 #include <RDA5807.h>
 #include <U8g2lib.h>
 
-#if defined(ESP8266)
-#include <ESP8266WiFi.h>
-#include <ESP8266WebServer.h>
-#elif defined(ESP32)
-#include <WiFi.h>
-#include <WebServer.h>
-#endif
+#include "board.h"
+#include "memstats.h"
+#include "watchdog.h"
+#include "tunerbus.h"
+#include "trace.h"
+#include "benchmark.h"
+#include "flashstr.h"
+#include "format.h"
+#include "heapguard.h"
+#include "eventring.h"
+#include "coroutine.h"
+#include "displaydma.h"
+#include "rdscapture.h"
 
 // Include user configuration or use defaults
-#if defined(ESP8266) || defined(ESP32)
+#if BOARD_HAS_WIFI
   #include "config.h"
 #endif
 
+#if defined(ENABLE_HISTORY)
+  #include "history.h"
+#endif
+
+#if defined(FONT_SUBSETS)
+  #include "fontsubset.h"
+#endif
+
+#if defined(ENABLE_SURVEY) && !BOARD_HAS_WIFI
+  #error "ENABLE_SURVEY needs a board with WiFi (results are served at /api/survey)"
+#endif
+
 // Forward declarations
 void updateDisplay();
+void serviceDisplay();
+void markDirty(uint16_t fields);
+void nextDisplayPage();
+void drawSpectrumPage();
+void drawSignalGraph();
+void serviceSignal(unsigned long currentMillis);
+void resetSignalHistory();
+void togglePower();
+void noteInput();
+#if defined(DISPLAY_DMA)
+void serviceInputFrame();
+#endif
+void tunerSetFrequency(uint16_t frequency);
+void tunerSetMute(bool mute);
+void tunerSetVolume(uint8_t level);
+void startScan();
+void stopScan();
+void serviceScan(unsigned long currentMillis);
+bool tunerBusy();
+void startPreview();
+void stopPreview();
+void servicePreview(unsigned long currentMillis);
+#if defined(ENABLE_SURVEY)
+void surveyReset();
+void surveyScanChannel(uint8_t channel, uint8_t rssi, uint8_t quality);
+void surveyScanDone();
+void surveyAbortProbe();
+void serviceSurvey(unsigned long currentMillis);
+#endif
 void seekUp();
 void seekDown();
+uint8_t channelQuality(uint8_t ch);
+void setChannelQuality(uint8_t ch, uint8_t quality);
+uint8_t measureQuality(uint8_t rssi, long rdsSyncMs);
+void cacheQuality(uint8_t ch, uint8_t quality);
+void startSeek(int8_t dir);
+void stopSeek();
+void serviceSeek();
+void tuneStep(int delta);
+void serviceTuning();
+void handleButtons(unsigned long currentMillis);
+#if defined(ENABLE_ENCODER)
+void encoderISR();
+void handleEncoder(unsigned long currentMillis);
+#endif
 #if defined(ENABLE_RDS)
 void checkRDSData();
 #endif
+#if defined(ENABLE_BENCHMARK)
+void runBenchmark();
+#endif
 
-#if defined(ESP8266) || defined(ESP32)
+#if BOARD_HAS_WIFI
+void serviceWiFi();
 void handleRoot();
+void rootPage(String &html);
 void handleUp();
 void handleDown();
 void handleToggle();
 void handleSeekUp();
 void handleSeekDown();
+void handleApiStatus();
+void statusJson(String &json);
+void handleScan();
+void handlePreview();
+void handleMetrics();
+void handleApiDiag();
+#if defined(ENABLE_TRACE)
+void handleApiTrace();
+#endif
+#if defined(ENABLE_HISTORY)
+void handleApiHistory();
+#endif
+#if defined(ENABLE_SURVEY)
+void handleApiSurvey();
+#endif
+#if defined(ENABLE_RDS_CAPTURE)
+void handleApiRdsCapture();
+#endif
+void signalSparkline(String &points);
+long webArgNumber(const char *name);
+bool webArgIs(const char *name, const char *value);
 #endif
 
-// Display setup (Nokia 5110)
-#if defined(ESP8266)
-// ESP8266 pin mapping
-// CLK: GPIO-14 (D5)
-// MISO: GPIO-12 (D6)
-// MOSI: GPIO-13 (D7)
-// CS: GPIO-16 (D0)
-// D/C: GPIO-15 (D8)
-// RST: GPIO-0 (D3)
-// SDA: GPIO-4 (D2)
-// SCL: GPIO-5 (D1)
-// LED: GPIO-2 (D4)
-U8G2_PCD8544_84X48_F_4W_HW_SPI u8g2(U8G2_R2, /* cs=*/ D0, /* dc=*/ D8, /* reset=*/ D3);
-#elif defined(ESP32)
-// ESP32 pin mapping
-U8G2_PCD8544_84X48_F_4W_HW_SPI u8g2(U8G2_R2, /* cs=*/ 15, /* dc=*/ 4, /* reset=*/ 5);
+// Display setup (Nokia 5110), pins come from the board descriptor
+Board::Display u8g2(U8G2_R2, /* cs=*/ Board::LCD_CS, /* dc=*/ Board::LCD_DC, /* reset=*/ Board::LCD_RST);
+
+// Display fonts. With FONT_SUBSETS (defined by tools/fontsubset.py at
+// build time) the status and frequency fonts hold only the glyphs drawn
+// with them; titles and text keep printable ASCII, which covers the RDS
+// basic character set
+#if defined(FONT_SUBSETS)
+const uint8_t *const FONT_STATUS = fmradio_font_6x10_status;
+const uint8_t *const FONT_FREQUENCY = fmradio_font_10x20_freq;
 #else
-// Default Arduino pin mapping
-U8G2_PCD8544_84X48_F_4W_HW_SPI u8g2(U8G2_R2, /* cs=*/ 7, /* dc=*/ 6, /* reset=*/ 5);
+const uint8_t *const FONT_STATUS = u8g2_font_6x10_tr;
+const uint8_t *const FONT_FREQUENCY = u8g2_font_10x20_tn;
+#endif
+const uint8_t *const FONT_TITLE = u8g2_font_7x13B_tr;
+const uint8_t *const FONT_TEXT = u8g2_font_5x7_tr;
+
+// Main page layout
+const uint8_t MAIN_TITLE_Y = 10;           // Title baseline
+const uint8_t MAIN_TITLE_HEIGHT = 14;      // Rows above the frequency digits
+const uint8_t MAIN_FREQ_RIGHT = 60;        // Frequency right edge
+const uint8_t MAIN_FREQ_Y = 30;            // Frequency and "MHz" baseline
+const uint8_t MAIN_STATUS_Y = 45;          // Status line baseline
+
+#if !defined(__AVR__)
+// Pre-rendered main page, see drawMainPage(): the static layout as a
+// whole frame and the frequency glyphs as frame buffer bytes. About 1 KB
+// of RAM, so AVR keeps drawing through the fonts
+#define DISPLAY_CACHE
+const uint16_t FRAME_BYTES = (84 + 7) / 8 * 8 * (48 / 8);
+const uint8_t FREQ_GLYPHS = 11;            // "0" to "9" and "."
+const uint8_t FREQ_GLYPH_PAGES = 4;        // 20 pixel high glyphs span up to 4 pages
+const uint8_t FREQ_GLYPH_WIDTH = 10;       // Monospaced 10x20 font
+uint8_t baseFrame[FRAME_BYTES];            // Frame buffer with the static layout
+bool mainCacheReady = false;
+uint8_t freqGlyphs[FREQ_GLYPHS][FREQ_GLYPH_PAGES][FREQ_GLYPH_WIDTH];
+uint8_t freqGlyphRight[FREQ_GLYPHS];       // Right edge of each glyph, as getStrWidth()
+uint8_t freqGlyphPage = 0;                 // First frame buffer page of the glyphs
+uint8_t volumeX = 0;                       // Where the volume follows "Vol:"
+#endif
+
+#if defined(ESP32) && defined(ENABLE_DISPLAY_DMA)
+// Frames go out by SPI DMA (see displaydma.h), unless the driver failed
+// to start and U8g2 kept the bus
+#define DISPLAY_DMA
+bool displayDma = false;
 #endif
 
 // RDA5807 FM receiver
 RDA5807 radio;
 
-#if defined(ESP8266)
+#if BOARD_HAS_WIFI
 // Web server
-ESP8266WebServer server(80);
-#elif defined(ESP32)
-// Web server
-WebServer server(80);
-#endif
+Board::Server server(80);
 
-// Pin definitions
-#if defined(ESP8266)
-// ESP8266 pin mapping
-#define BTN_UP D2
-#define BTN_DOWN D3
-#define BTN_OK D4
-#elif defined(ESP32)
-// ESP32 pin mapping
-#define BTN_UP 12
-#define BTN_DOWN 14
-#define BTN_OK 27
+// Response bodies are built in a String; the static allocation profile
+// reserves one at boot and reuses it, so building them does not allocate
+#if defined(ENABLE_STATIC_ALLOC)
+const size_t RESPONSE_RESERVE = 4096;
+String httpResponse;
+#define RESPONSE_BUFFER(name) String &name = httpResponse; name = ""
 #else
-// Default Arduino pin mapping
-#define BTN_UP 2
-#define BTN_DOWN 3
-#define BTN_OK 4
+#define RESPONSE_BUFFER(name) String name
+#endif
 #endif
 
+// Buttons (active low, read directly from the GPIO input register)
+typedef Board::BtnUp BtnUp;
+typedef Board::BtnDown BtnDown;
+typedef Board::BtnOk BtnOk;
+#if defined(ENABLE_ENCODER)
+typedef Board::EncA EncA;
+typedef Board::EncB EncB;
+typedef Board::EncSw EncSw;
+#endif
+
+// Button state, one per button, updated by handleButtons()
+struct ButtonState {
+  bool down;                  // Debounced state
+  bool raw;                   // Last raw reading
+  unsigned long changedAt;    // Time of the last raw change
+  unsigned long pressedAt;    // Time the debounced press started
+  unsigned long lastRepeat;   // Time of the last auto-repeat step
+  uint8_t repeats;            // Auto-repeat steps issued during this press
+};
+ButtonState btnUp = {false, false, 0, 0, 0, 0};
+ButtonState btnDown = {false, false, 0, 0, 0, 0};
+ButtonState btnOk = {false, false, 0, 0, 0, 0};
+bool okUsedAsModifier = false;  // OK was held for an OK+UP/DOWN seek
+
 // Variables for buttons
-unsigned long lastButtonPress = 0;
-const unsigned long debounceDelay = 200; // ms
-const unsigned long longPressDelay = 1000; // ms for station seeking
+const unsigned long debounceDelay = 20;    // ms the input must be stable
+const unsigned long repeatDelay = 400;     // ms before a held button repeats
+const unsigned long repeatInterval = 120;  // ms between repeated steps
+const unsigned long longPressDelay = 1000; // ms for an OK long press
+// Auto-repeat acceleration: step size grows after this many repeats
+const uint8_t repeatFastAfter = 8;         // then 500 kHz steps
+const uint8_t repeatFasterAfter = 16;      // then 1 MHz steps
+
+#if defined(ENABLE_ENCODER)
+// Rotary encoder, decoded in encoderISR()
+// Transition table indexed by (previous AB << 2) | current AB: +1/-1 for a
+// valid quarter step, 0 for no change or an invalid (bouncing) transition.
+// Kept in RAM so the ISR never has to touch flash.
+int8_t encoderTable[16] = {
+   0, -1, +1,  0,
+  +1,  0,  0, -1,
+  -1,  0,  0, +1,
+   0, +1, -1,  0
+};
+volatile uint8_t encoderState = 0;    // Last two AB readings
+int8_t encoderQuarters = 0;           // Quarter steps short of a detent, ISR only
+// Whole detents, from encoderISR() to handleEncoder()
+EventRing<InputEvent, 32> inputEvents;
+volatile int16_t encoderHeld = 0;     // Detents that found the ring full
+unsigned long lastEncoderDetent = 0;  // Time of the last detent
+const int8_t encoderStepsPerDetent = 4;
+// Velocity acceleration: detents closer together than these use bigger steps
+const unsigned long encoderFastInterval = 60;    // ms, then 500 kHz
+const unsigned long encoderFasterInterval = 25;  // ms, then 1 MHz
+#endif
 
-// Radio settings
-float currentFrequency = 87.5; // Start frequency in MHz
+// Radio settings, frequencies in 10 kHz units as used by the RDA5807
+const uint16_t FREQ_MIN = 8750;   // 87.5 MHz
+const uint16_t FREQ_MAX = 10800;  // 108.0 MHz
+const uint16_t FREQ_STEP = 10;    // 100 kHz
+uint16_t currentFrequency = FREQ_MIN; // Start frequency
 bool radioOn = false;
 int volume = 5; // Volume level 0-15
 
+// Signal quality history for the current station, filled by sampleSignal()
+const uint8_t SIGNAL_HISTORY = 32;        // Samples kept, a multiple of the graph width
+const uint8_t SIGNAL_GRAPH_WIDTH = 16;    // Columns of the on-screen graph
+const uint8_t SIGNAL_GRAPH_X = 68;        // Graph position (bottom right corner)
+const uint8_t SIGNAL_GRAPH_Y = 40;
+const uint8_t SIGNAL_GRAPH_HEIGHT = 8;
+const uint8_t SIGNAL_FLAG_STEREO = 0x01;
+const uint8_t SIGNAL_FLAG_FMTRUE = 0x02;
+struct SignalSample {
+  uint8_t rssi;
+  uint8_t flags;
+};
+SignalSample signalHistory[SIGNAL_HISTORY];
+uint8_t signalHead = 0;                   // Next slot to write
+uint8_t signalCount = 0;                  // Valid samples
+uint8_t signalGraphDrawn[SIGNAL_GRAPH_WIDTH]; // Bar heights currently on screen
+unsigned long lastSignalSample = 0;
+// The sampler only runs in loop passes that did nothing else, faster once
+// the loop has been idle for a while
+const unsigned long signalIntervalIdle = 250;  // ms
+const unsigned long signalIntervalBusy = 1000; // ms
+const uint8_t signalIdleLoops = 20;       // Idle passes before sampling faster
+uint8_t idleLoops = 0;
+bool loopBusy = false;                    // Set by any work done in this pass
+
+#if defined(ENABLE_HISTORY)
+// History logging (see history.h)
+const unsigned long historySampleInterval = 10000;  // ms between logged RSSI samples
+const unsigned long historyScanInterval = 600000;   // ms between logged band scans
+unsigned long lastHistorySample = 0;
+unsigned long lastHistoryScan = 0;
+bool historyScanLogged = false;
+#endif
+
+// Band scan engine: one channel per step, never blocks the loop
+const uint8_t BAND_CHANNELS = (FREQ_MAX - FREQ_MIN) / FREQ_STEP + 1; // 206
+const unsigned long scanSettleDelay = 40;  // ms between tuning and reading RSSI
+Coroutine scanTask;                        // serviceScan(), running during a pass
+uint8_t scanChannel = 0;                   // Channel being measured
+uint8_t scanColumnMax = 0;                 // Strongest RSSI in the current column
+bool scanSurvey = false;                   // The pass was started by the survey
+
+// Station quality, see measureQuality(): 1 (noise) to 15, cached per
+// channel in a nibble, 0 until the channel has been measured
+const uint8_t QUALITY_UNKNOWN = 0;
+const uint8_t QUALITY_MAX = 15;
+const uint8_t qualityStation = 6;          // Lowest score counted as a station
+const unsigned long qualityRdsWindow = 500; // ms a candidate gets to sync RDS
+const long QUALITY_NO_RDS = -1;            // RDS sync not measured
+uint8_t stationQuality[(BAND_CHANNELS + 1) / 2];
+
+// Station list: one bit per channel, set if the last scan pass measured
+// it at or above qualityStation
+uint8_t stationMap[(BAND_CHANNELS + 7) / 8];
+bool stationMapValid = false;              // A full pass has completed
+
+const unsigned long seekSettleDelay = 50;  // ms between tuning and reading RSSI
+// Seek: one channel per step, stops on the first one scoring at least
+// qualityStation
+Coroutine seekTask;                        // serviceSeek(), running during a seek
+int8_t seekDirection = 0;                  // +1 up, -1 down
+uint16_t seekOrigin = 0;                   // Frequency the seek started from
+uint8_t seekSteps = 0;                     // Channels tried so far
+uint8_t seekRssi = 0;                      // RSSI of the candidate channel
+
+// Scan-and-preview: play each station of the list for previewDwell,
+// scanning the band first if there is no list yet
+unsigned long previewDwell = 5000;         // ms on each station
+bool previewActive = false;
+bool previewTuned = false;                 // At least one hop done
+unsigned long previewHopAt = 0;            // Time of the last hop
+// Cost of the last hop and totals, in microseconds
+unsigned long previewRetuneMicros = 0;
+unsigned long previewRdsResetMicros = 0;
+unsigned long previewRetuneTotal = 0;
+unsigned long previewRdsResetTotal = 0;
+
+#if defined(ENABLE_SURVEY)
+// Band survey: scheduled sweeps with per channel statistics, kept as a
+// struct of arrays so each statistic is one contiguous 206 entry array
+struct SurveyTable {
+  uint8_t rssiMin[BAND_CHANNELS];
+  uint8_t rssiMax[BAND_CHANNELS];
+  uint32_t rssiSum[BAND_CHANNELS];   // For the mean, over surveySweeps
+  uint16_t occupied[BAND_CHANNELS];  // Sweeps scoring at least qualityStation
+  uint16_t pi[BAND_CHANNELS];        // RDS Program Identification, 0 if unknown
+  char ps[BAND_CHANNELS][9];         // RDS Program Service name
+};
+SurveyTable survey;
+uint16_t surveySweeps = 0;
+bool surveyRunning = false;
+unsigned long surveyInterval = 300000;        // ms between sweep starts
+unsigned long surveyLastSweep = 0;
+// RDS probe of occupied channels after each sweep
+const unsigned long surveyProbeDwell = 3000;  // ms listening on each channel
+bool surveyProbePending = false;              // A sweep finished, probe its channels
+bool surveyProbing = false;                   // Tuned to surveyProbeChannel
+uint8_t surveyProbeChannel = 0;
+unsigned long surveyProbeStart = 0;
+#endif
+
+// Display pages, cycled with a long press of OK
+enum DisplayPage {
+  PAGE_MAIN,
+#if defined(ENABLE_RDS)
+  PAGE_RDS,
+#endif
+  PAGE_SIGNAL,
+  PAGE_SPECTRUM,
+#if BOARD_HAS_WIFI
+  PAGE_NETWORK,
+#endif
+  PAGE_STATS,
+  PAGE_COUNT
+};
+DisplayPage displayPage = PAGE_MAIN;
+
+// State fields shown on the display; each page declares the ones it uses
+// and a change only triggers a redraw if the active page shows it
+const uint16_t FIELD_FREQUENCY = 0x0001;
+const uint16_t FIELD_POWER     = 0x0002;
+const uint16_t FIELD_VOLUME    = 0x0004;
+const uint16_t FIELD_RDS_PS    = 0x0008;
+const uint16_t FIELD_RDS_RT    = 0x0010;
+const uint16_t FIELD_RDS_INFO  = 0x0020;  // PI, PTY, TP/TA
+const uint16_t FIELD_SIGNAL    = 0x0040;
+const uint16_t FIELD_SCAN      = 0x0080;
+const uint16_t FIELD_NETWORK   = 0x0100;
+const uint16_t FIELD_STATS     = 0x0200;
+const uint16_t FIELD_PAGE      = 0x8000;  // Page switched, redraw everything
+uint16_t displayDirty = FIELD_PAGE;
+
+struct DisplayPageInfo {
+  void (*draw)();
+  uint16_t fields;
+};
+
+// Activity counters for the statistics page
+unsigned long statRetunes = 0;
+unsigned long statSeeks = 0;
+unsigned long statScans = 0;
+unsigned long statRenders = 0;
+unsigned long statHops = 0;
+
+// Latency of the work the user waits for, in us
+struct LatencyStat {
+  unsigned long count;
+  unsigned long last;
+  unsigned long max;
+  unsigned long total;        // For the mean
+};
+LatencyStat latencyInput;     // Input event to the redraw showing it
+LatencyStat latencyRequest;   // HTTP handler run time
+LatencyStat latencyLoop;      // Loop pass, without the final delay
+const unsigned long inputLatencyTimeout = 1000000;  // us, input with no redraw
+unsigned long inputPendingSince = 0;                // micros() of the oldest input
+bool inputPending = false;
+#if defined(DISPLAY_DMA)
+unsigned long inputFrame = 0;   // DMA frame showing the pending input, 0 if not sent yet
+#endif
+void latencyAdd(LatencyStat &stat, unsigned long us);
+
+#if BOARD_HAS_WIFI
+/**
+ * @brief Run a web handler and record how long it took
+ */
+template <void (*Handler)()>
+void timedHandler() {
+  unsigned long start = micros();
+  Handler();
+  latencyAdd(latencyRequest, micros() - start);
+}
+#endif
+
+// Heap and stack usage sampling (see memstats.h)
+const unsigned long memSampleInterval = 5000;  // ms
+
+// Spectrum view: the band as 84 columns of about 2.5 channels each,
+// holding the strongest RSSI seen in each column during the last sweep
+const uint8_t SPECTRUM_WIDTH = 84;
+const uint8_t SPECTRUM_Y = 8;              // Below the header line
+const uint8_t SPECTRUM_HEIGHT = 40;
+uint8_t spectrum[SPECTRUM_WIDTH];
+
+// Coalesced tuning: tuneStep() only moves the target, serviceTuning()
+// programs the tuner and redraws once per loop pass with the latest target
+uint16_t tuneTarget = FREQ_MIN;
+bool tunePending = false;
+
 // RDS data
 #if defined(ENABLE_RDS)
 char rdsProgramService[9] = "";     // 8 chars + null terminator
@@ -119,11 +465,14 @@ char rdsProgramType[17] = "";       // 16 chars + null terminator
 bool rdsTrafficProgram = false;
 bool rdsTrafficAnnouncement = false;
 unsigned int rdsPI = 0;             // Program Identification
+// The tuner holds only the last group, 87.6 ms on air: poll faster than
+// that, or most groups are lost and the PS segments can alias
+const unsigned long rdsPollInterval = 40;  // ms
 #endif
 
-// WiFi connection state (for ESP platforms)
-#if defined(ESP8266) || defined(ESP32)
-bool wifiConnectAttempted = false;
+// WiFi station connection (for ESP platforms), see serviceWiFi()
+#if BOARD_HAS_WIFI
+Coroutine wifiTask;
 unsigned long wifiConnectStartTime = 0;
 const unsigned long wifiConnectTimeout = 10000; // 10 seconds
 #endif
@@ -144,19 +493,46 @@ const unsigned long wifiConnectTimeout = 10000; // 10 seconds
  */
 void setup() {
   // Initialize serial communication
+#if BOARD_BUTTON_ON_RX
+  // The OK button takes the RX pin, only transmit
+#if defined(ESP8266)
+  Serial.begin(9600, SERIAL_8N1, SERIAL_TX_ONLY);
+#else
+  Serial.begin(9600, SERIAL_8N1, -1, TX);
+#endif
+#else
   Serial.begin(9600);
+#endif
+  
+  // Report loop stalls recorded before the last reset
+  watchdogBegin();
   
   // Initialize display
   u8g2.begin();
   u8g2.enableUTF8Print();
-  u8g2.setFont(u8g2_font_6x10_tf);
+  u8g2.setFont(FONT_STATUS);
+#if defined(DISPLAY_DMA)
+  displayDma = displayDmaBegin(Board::LCD_CS, Board::LCD_DC);
+  if (!displayDma) {
+    Serial.println(F("Display DMA unavailable, using U8g2 SPI"));
+  }
+#endif
   
   // Initialize button pins
-  pinMode(BTN_UP, INPUT_PULLUP);
-  pinMode(BTN_DOWN, INPUT_PULLUP);
-  pinMode(BTN_OK, INPUT_PULLUP);
+  BtnUp::begin();
+  BtnDown::begin();
+  BtnOk::begin();
   
-#if defined(ESP8266) || defined(ESP32)
+#if defined(ENABLE_ENCODER)
+  // Initialize rotary encoder
+  EncA::begin();
+  EncB::begin();
+  EncSw::begin();
+  encoderState = (EncA::read() << 1) | EncB::read();
+  Board::attachEncoder(encoderISR);
+#endif
+  
+#if BOARD_HAS_WIFI
   // Start AP mode (always available)
   #ifdef AP_PASSWORD
     WiFi.softAP(AP_SSID, AP_PASSWORD);
@@ -164,28 +540,61 @@ void setup() {
     WiFi.softAP(AP_SSID);  // Open AP (no password)
   #endif
   
-  Serial.println("AP started");
-  Serial.print("AP IP address: ");
+  Serial.println(F("AP started"));
+  Serial.print(F("AP IP address: "));
   Serial.println(WiFi.softAPIP());
   
   // Setup web server routes
-  server.on("/", handleRoot);
-  server.on("/up", handleUp);
-  server.on("/down", handleDown);
-  server.on("/seekup", handleSeekUp);
-  server.on("/seekdown", handleSeekDown);
-  server.on("/toggle", handleToggle);
+  server.on("/", timedHandler<handleRoot>);
+  server.on("/up", timedHandler<handleUp>);
+  server.on("/down", timedHandler<handleDown>);
+  server.on("/seekup", timedHandler<handleSeekUp>);
+  server.on("/seekdown", timedHandler<handleSeekDown>);
+  server.on("/toggle", timedHandler<handleToggle>);
+  server.on("/api/status", timedHandler<handleApiStatus>);
+  server.on("/scan", timedHandler<handleScan>);
+  server.on("/preview", timedHandler<handlePreview>);
+  server.on("/metrics", timedHandler<handleMetrics>);
+  server.on("/api/diag", timedHandler<handleApiDiag>);
+#if defined(ENABLE_TRACE)
+  server.on("/api/trace", timedHandler<handleApiTrace>);
+#endif
+#if defined(ENABLE_HISTORY)
+  server.on("/api/history", timedHandler<handleApiHistory>);
+#endif
+#if defined(ENABLE_SURVEY)
+  server.on("/api/survey", timedHandler<handleApiSurvey>);
+#endif
+#if defined(ENABLE_RDS_CAPTURE)
+  server.on("/api/rdscapture", timedHandler<handleApiRdsCapture>);
+#endif
   server.begin();
+#if defined(ENABLE_STATIC_ALLOC)
+  httpResponse.reserve(RESPONSE_RESERVE);
+#endif
+  
+  // Connect to the WiFi station in the background
+  #if defined(WIFI_SSID) && defined(WIFI_PASSWORD)
+  coStart(wifiTask);
+  #endif
+#endif
+  
+#if defined(ENABLE_SURVEY)
+  surveyReset();
+#endif
   
-  // Initialize WiFi connection state
-  wifiConnectAttempted = false;
-  wifiConnectStartTime = 0;
+#if defined(ENABLE_HISTORY)
+  // Mount the filesystem for the history log
+  if (!historyBegin()) {
+    Serial.println(F("History log unavailable, filesystem mount failed"));
+  }
 #endif
   
   // Initialize radio
   radio.setup();
-  radio.setFrequency(currentFrequency);
-  radio.setVolume(volume);
+  tunerBusBegin();
+  tunerSetFrequency(currentFrequency);
+  tunerSetVolume(volume);
   radioOn = true;
   
 #if defined(ENABLE_RDS)
@@ -195,8 +604,22 @@ void setup() {
   memset(rdsProgramType, 0, sizeof(rdsProgramType));
 #endif
   
+  // First memory sample, so the stats page starts with real numbers
+  memstatsSample();
+  
   // Display initial screen
   updateDisplay();
+  displayDirty = 0;
+  
+#if defined(ENABLE_BENCHMARK)
+  runBenchmark();
+#endif
+  
+  // Watch the loop from now on
+  watchdogStart();
+#if defined(ENABLE_STATIC_ALLOC)
+  heapguardArm();
+#endif
 }
 
 /**
@@ -206,459 +629,2455 @@ void setup() {
  * 1. For ESP platforms: 
  *    - Handles incoming web server requests
  *    - Manages non-blocking WiFi station connection
- * 2. Checks for button presses with debounce logic:
- *    - UP button (short press): Increases frequency by 0.1 MHz (wraps from 108.0 to 87.5)
- *    - DOWN button (short press): Decreases frequency by 0.1 MHz (wraps from 87.5 to 108.0)
- *    - UP button (long press): Seeks up to next station
- *    - DOWN button (long press): Seeks down to next station
- *    - OK button: Toggles radio power state (ON/OFF)
- * 3. Updates the display when changes occur
- * 4. Implements button debouncing to prevent multiple triggers
+ * 2. Polls the buttons (see handleButtons())
+ * 3. Applies the coalesced tuning target and updates the display
+ * 4. Advances the background band scan (see serviceScan())
+ * 5. Samples the signal quality in idle passes (see serviceSignal())
+ * 6. Redraws the display if the active page changed (see serviceDisplay())
  */
 void loop() {
   unsigned long currentMillis = millis();
+  unsigned long loopStart = micros();
+  loopBusy = false;
   
-#if defined(ESP8266) || defined(ESP32)
+#if BOARD_HAS_WIFI
   // Handle web server requests
+  watchdogEnter(WD_WEB);
   server.handleClient();
   
   // Handle non-blocking WiFi station connection
-  #if defined(WIFI_SSID) && defined(WIFI_PASSWORD)
-  if (!wifiConnectAttempted) {
-    // Attempt to connect to WiFi station
-    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
-    Serial.print("Connecting to WiFi");
-    wifiConnectAttempted = true;
-    wifiConnectStartTime = currentMillis;
-  }
-  #endif
-  
-  // Check WiFi connection status
-  #if defined(WIFI_SSID) && defined(WIFI_PASSWORD)
-  static bool stationIPPrinted = false;
-  if (wifiConnectAttempted && WiFi.status() == WL_CONNECTED) {
-    if (!stationIPPrinted) {
-      Serial.println();
-      Serial.print("Station IP address: ");
-      Serial.println(WiFi.localIP());
-      stationIPPrinted = true;
-    }
-    // Reset flag to prevent repeated printing
-    wifiConnectAttempted = true; // Keep it true to prevent reconnection attempts
-  } 
-  else if (wifiConnectAttempted && (currentMillis - wifiConnectStartTime > wifiConnectTimeout) && WiFi.status() != WL_CONNECTED) {
-    Serial.println();
-    Serial.println("WiFi station connection failed or timed out");
-    // Reset flag to prevent repeated printing
-    wifiConnectAttempted = true; // Keep it true to prevent reconnection attempts
-  }
-  else if (wifiConnectAttempted && WiFi.status() != WL_CONNECTED && (currentMillis - wifiConnectStartTime <= wifiConnectTimeout)) {
-    // Still trying to connect, print dots periodically
-    static unsigned long lastDotPrint = 0;
-    if (currentMillis - lastDotPrint > 500) {
-      Serial.print(".");
-      lastDotPrint = currentMillis;
-    }
-  }
-  #endif
+  watchdogEnter(WD_WIFI);
+  serviceWiFi();
   
-  // Periodically check for RDS data (every 500ms)
-  static unsigned long lastRdsCheck = 0;
-  if (currentMillis - lastRdsCheck > 500) {
 #if defined(ENABLE_RDS)
+  // Check for RDS data at the group rate
+  static unsigned long lastRdsCheck = 0;
+  if (currentMillis - lastRdsCheck >= rdsPollInterval && !tunerBusy()) {
+    watchdogEnter(WD_RDS);
     checkRDSData();
-#endif
     lastRdsCheck = currentMillis;
   }
+#endif
+#if defined(ENABLE_RDS_CAPTURE)
+  // Record raw RDS groups while a capture runs
+  if (rdsCaptureRunning() && !tunerBusy()) {
+    watchdogEnter(WD_RDS);
+    rdsCaptureService(currentFrequency, currentMillis);
+  }
+#endif
 #endif
   
-  // Check for UP button press (increase frequency)
-  if (digitalRead(BTN_UP) == LOW && (currentMillis - lastButtonPress > debounceDelay)) {
-    unsigned long buttonPressTime = currentMillis;
-    
-    // Wait for button release or long press
-    while (digitalRead(BTN_UP) == LOW) {
-      // Check for long press (station seeking)
-      if (currentMillis - buttonPressTime > longPressDelay) {
-        // Seek up to next station
-        seekUp();
-        break;
-      }
-      delay(10);
-      currentMillis = millis();
-    }
-    
-    // If it wasn't a long press, do normal frequency increment
-    if (currentMillis - buttonPressTime <= longPressDelay) {
-      currentFrequency += 0.1;
-      if (currentFrequency > 108.0) currentFrequency = 87.5;
-      
-      // Update radio frequency
-      radio.setFrequency(currentFrequency);
-      updateDisplay();
-    }
-    
-    lastButtonPress = currentMillis;
+  // Handle buttons and apply any tuning they requested
+  watchdogEnter(WD_INPUT);
+  handleButtons(currentMillis);
+#if defined(ENABLE_ENCODER)
+  handleEncoder(currentMillis);
+#endif
+  watchdogEnter(WD_TUNING);
+  serviceTuning();
+  
+  // Advance the seek, if one is running
+  watchdogEnter(WD_SEEK);
+  serviceSeek();
+  
+  // Advance the band scan, if one is running
+  watchdogEnter(WD_SCAN);
+  serviceScan(currentMillis);
+  watchdogEnter(WD_PREVIEW);
+  servicePreview(currentMillis);
+#if defined(ENABLE_SURVEY)
+  watchdogEnter(WD_SURVEY);
+  serviceSurvey(currentMillis);
+#endif
+  
+  // Sample signal quality when there is nothing else to do
+  watchdogEnter(WD_SIGNAL);
+  serviceSignal(currentMillis);
+  
+#if defined(ENABLE_HISTORY)
+  // Write batched history records to flash in idle passes
+  watchdogEnter(WD_HISTORY);
+  historyService(!loopBusy);
+#endif
+  
+  // Check the tuner bus, the tuner reads are not checked one by one
+  watchdogEnter(WD_TUNING);
+  tunerBusService(currentMillis);
+  
+  // Heap and stack usage
+  static unsigned long lastMemSample = 0;
+  if (currentMillis - lastMemSample >= memSampleInterval) {
+    watchdogEnter(WD_MEMSTATS);
+    memstatsSample();
+    lastMemSample = currentMillis;
   }
   
-  // Check for DOWN button press (decrease frequency)
-  if (digitalRead(BTN_DOWN) == LOW && (currentMillis - lastButtonPress > debounceDelay)) {
-    unsigned long buttonPressTime = currentMillis;
-    
-    // Wait for button release or long press
-    while (digitalRead(BTN_DOWN) == LOW) {
-      // Check for long press (station seeking)
-      if (currentMillis - buttonPressTime > longPressDelay) {
-        // Seek down to next station
-        seekDown();
-        break;
-      }
-      delay(10);
-      currentMillis = millis();
-    }
-    
-    // If it wasn't a long press, do normal frequency decrement
-    if (currentMillis - buttonPressTime <= longPressDelay) {
-      currentFrequency -= 0.1;
-      if (currentFrequency < 87.5) currentFrequency = 108.0;
-      
-      // Update radio frequency
-      radio.setFrequency(currentFrequency);
-      updateDisplay();
-    }
-    
-    lastButtonPress = currentMillis;
+  // Uptime on the statistics page
+  static unsigned long lastStatsUpdate = 0;
+  if (currentMillis - lastStatsUpdate >= 1000) {
+    markDirty(FIELD_STATS);
+    lastStatsUpdate = currentMillis;
   }
   
-  // Check for OK button press (toggle radio on/off)
-  if (digitalRead(BTN_OK) == LOW && (currentMillis - lastButtonPress > debounceDelay)) {
-    radioOn = !radioOn;
-    if (radioOn) {
-      radio.setFrequency(currentFrequency);
-      radio.setMute(false);
-    } else {
-      radio.setMute(true);
-    }
-    updateDisplay();
-    lastButtonPress = currentMillis;
-    
-    // Wait for button release
-    while (digitalRead(BTN_OK) == LOW) delay(10);
+  // Redraw the display if anything on the active page changed
+  watchdogEnter(WD_DISPLAY);
+  serviceDisplay();
+#if defined(DISPLAY_DMA)
+  // Take back the frames the SPI driver has finished sending
+  if (displayDma) {
+    displayDmaService();
+    serviceInputFrame();
   }
+#endif
   
+  latencyAdd(latencyLoop, micros() - loopStart);
+  watchdogEnter(WD_IDLE);
   delay(10);
 }
 
-
+#if BOARD_HAS_WIFI
 /**
- * @brief Update the Nokia 5110 display with current radio information
- * 
- * This function updates the display with:
- * - Title "FM Radio"
- * - Current frequency in MHz
- * - Radio status (ON/OFF)
- * - Volume level
- * - For ESP platforms: RDS data (if available) and Access Point IP address
+ * @brief Connect to the WiFi station, without blocking (coroutine)
  * 
- * The display uses a double-buffering technique where all content is drawn
- * to a buffer first, then displayed all at once to prevent flickering.
+ * Started in setup() when WIFI_SSID and WIFI_PASSWORD are configured.
+ * Checks the connection every 500 ms, printing a dot each time, and
+ * gives up after wifiConnectTimeout; the access point stays up either
+ * way.
  */
-void updateDisplay() {
-  u8g2.firstPage();
-  do {
-    // Display title or station name
-#if defined(ENABLE_RDS)
-    if (strlen(rdsProgramService) > 0) {
-      u8g2.setFont(u8g2_font_6x10_tf);
-      u8g2.drawStr(0, 10, rdsProgramService);
-    } else {
-      u8g2.setFont(u8g2_font_7x13B_tr);
-      int width = u8g2.getStrWidth("FM Radio");
-      int x = (84 - width) / 2;
-      u8g2.drawStr(x, 10, "FM Radio");
-    }
-#else
-    u8g2.setFont(u8g2_font_7x13B_tr);
-    int width = u8g2.getStrWidth("FM Radio");
-    int x = (84 - width) / 2;
-    u8g2.drawStr(x, 10, "FM Radio");
-#endif
-    
-    // Display frequency
-    u8g2.setFont(u8g2_font_10x20_tn);
-    char freqStr[10];
-    dtostrf(currentFrequency, 5, 1, freqStr);
-    u8g2.drawStr(10, 30, freqStr);
-    u8g2.setFont(u8g2_font_7x13B_tr);
-    u8g2.drawStr(65, 30, "MHz");
-    
-    // Display status
-    u8g2.setFont(u8g2_font_6x10_tf);
-    if (radioOn) {
-      u8g2.drawStr(0, 45, "ON ");
-    } else {
-      u8g2.drawStr(0, 45, "OFF");
-    }
-    
-    // Display volume
-    u8g2.setCursor(30, 45);
-    u8g2.print("Vol: ");
-    u8g2.print(volume);
-    
-    // Display RDS information if available
-    u8g2.setFont(u8g2_font_5x7_tf);
-#if defined(ENABLE_RDS)
-    if (strlen(rdsProgramService) > 0) {
-      u8g2.setCursor(0, 55);
-      u8g2.print(rdsProgramService);
-    } else if (strlen(rdsRadioText) > 0) {
-      // Truncate radio text to fit display width
-      char truncatedText[12]; // ~11 chars fit on display
-      strncpy(truncatedText, rdsRadioText, sizeof(truncatedText) - 1);
-      truncatedText[sizeof(truncatedText) - 1] = '\0';
-      u8g2.setCursor(0, 55);
-      u8g2.print(truncatedText);
+void serviceWiFi() {
+  CO_BEGIN(wifiTask);
+#if defined(WIFI_SSID) && defined(WIFI_PASSWORD)
+  WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+  Serial.print(F("Connecting to WiFi"));
+  wifiConnectStartTime = millis();
+  while (WiFi.status() != WL_CONNECTED) {
+    if (millis() - wifiConnectStartTime > wifiConnectTimeout) {
+      Serial.println();
+      Serial.println(F("WiFi station connection failed or timed out"));
+      CO_EXIT(wifiTask);
     }
+    Serial.print('.');
+    CO_AWAIT_MS(wifiTask, 500);
+  }
+  Serial.println();
+  Serial.print(F("Station IP address: "));
+  Serial.println(WiFi.localIP());
+  markDirty(FIELD_NETWORK);
 #endif
-    
-  } while (u8g2.nextPage());
+  CO_END(wifiTask);
 }
+#endif
+
 
-#if defined(ENABLE_RDS)
 /**
- * @brief Check for and update RDS data from the radio
+ * @brief Debounce one button
  * 
- * This function polls the RDA5807 for available RDS data and updates
- * the internal RDS data structures. It retrieves:
- * - Program Service (PS) name
- * - Radio Text (RT)
- * - Program Type (PTY)
- * - Traffic flags
- * - Program Identification (PI)
+ * The raw reading has to stay unchanged for debounceDelay before the
+ * debounced state follows it.
+ * 
+ * @param b Button state
+ * @param raw Current raw reading (true when pressed)
+ * @param now Current time in ms
+ * @return true if the debounced state changed
  */
-void checkRDSData() {
-  // Check if RDS data is available
-  if (radio.getRDSready()) {
-    // Get Program Service name (8 characters)
-    radio.getRDS_PS(rdsProgramService);
-    
-    // Get Radio Text (up to 64 characters)
-    radio.getRDS_RT(rdsRadioText);
-    
-    // Get Program Type
-    uint8_t pty = radio.getRDS_PTY();
-    // Convert PTY code to string (simplified)
-    snprintf(rdsProgramType, sizeof(rdsProgramType), "PTY:%d", pty);
-    
-    // Get Traffic flags
-    rdsTrafficProgram = radio.getRDS_TP();
-    rdsTrafficAnnouncement = radio.getRDS_TA();
-    
-    // Get Program Identification
-    rdsPI = radio.getRDS_PI();
-    
-    // Update display if RDS data changed
-    updateDisplay();
+bool debounceButton(ButtonState &b, bool raw, unsigned long now) {
+  if (raw != b.raw) {
+    b.raw = raw;
+    b.changedAt = now;
+    return false;
+  }
+  if (raw != b.down && now - b.changedAt >= debounceDelay) {
+    b.down = raw;
+    if (raw) {
+      b.pressedAt = now;
+      b.lastRepeat = now;
+      b.repeats = 0;
+    }
+    return true;
   }
+  return false;
 }
-#endif
 
 /**
- * @brief Seek up to the next valid FM station
+ * @brief Handle the UP or DOWN button
+ * 
+ * - Press: one 100 kHz step, or a seek when OK is held (OK+UP / OK+DOWN)
+ * - Hold: after repeatDelay, steps repeat every repeatInterval and
+ *   accelerate from 100 kHz to 500 kHz and then 1 MHz
  * 
- * This function implements station seeking by:
- * 1. Increasing frequency in small steps
- * 2. Checking the RSSI (signal strength) at each step
- * 3. Stopping when a strong enough signal is found
- * 4. Wrapping from 108.0 MHz to 87.5 MHz if needed
+ * @param b Button state
+ * @param changed Debounced state changed during this poll
+ * @param dir +1 for up, -1 for down
+ * @param now Current time in ms
  */
-void seekUp() {
-  float originalFrequency = currentFrequency;
-  float step = 0.1; // MHz
-  int rssiThreshold = 30; // Minimum RSSI for a valid station
-  int maxSteps = 2050; // Maximum steps to prevent infinite loop (205 MHz range / 0.1 MHz step)
-  
-  Serial.println("Seeking up...");
-  
-  for (int i = 0; i < maxSteps; i++) {
-    currentFrequency += step;
-    if (currentFrequency > 108.0) currentFrequency = 87.5;
-    
-    // Set the new frequency
-    radio.setFrequency(currentFrequency);
-    
-    // Small delay to allow RSSI to stabilize
-    delay(50);
-    
-    // Check signal strength
-    int rssi = radio.getRssi();
-    
-    // If we found a strong enough signal, stop seeking
-    if (rssi > rssiThreshold) {
-      Serial.print("Found station at ");
-      Serial.print(currentFrequency);
-      Serial.print(" MHz with RSSI ");
-      Serial.println(rssi);
-      updateDisplay();
-      return;
-    }
-    
-    // If we've gone full circle, stop seeking
-    if (abs(currentFrequency - originalFrequency) < 0.01 && i > 10) {
-      Serial.println("No stations found during seek up");
-      break;
+void handleTuneButton(ButtonState &b, bool changed, int dir, unsigned long now) {
+  if (changed && b.down) {
+    if (btnOk.down) {
+      // OK+UP/DOWN seeks; mark the press so it does not repeat
+      okUsedAsModifier = true;
+      b.repeats = 0xFF;
+      if (dir > 0) seekUp(); else seekDown();
+    } else {
+      tuneStep(dir * FREQ_STEP);
     }
+    return;
   }
   
-  // If no station found, restore original frequency
-  currentFrequency = originalFrequency;
-  radio.setFrequency(currentFrequency);
-  updateDisplay();
+  if (b.down && b.repeats != 0xFF &&
+      now - b.pressedAt >= repeatDelay &&
+      now - b.lastRepeat >= repeatInterval) {
+    int step = FREQ_STEP;
+    if (b.repeats >= repeatFasterAfter) step = 10 * FREQ_STEP;
+    else if (b.repeats >= repeatFastAfter) step = 5 * FREQ_STEP;
+    tuneStep(dir * step);
+    if (b.repeats < repeatFasterAfter) b.repeats++;
+    b.lastRepeat = now;
+  }
 }
 
 /**
- * @brief Seek down to the next valid FM station
+ * @brief Poll and handle all buttons without blocking
+ * 
+ * - UP/DOWN: step, hold to auto-repeat (see handleTuneButton())
+ * - OK+UP / OK+DOWN: seek to the next/previous station
+ * - OK released without being used for a seek: toggle radio power
+ * - OK held for longPressDelay and released: next display page
  * 
- * This function implements station seeking by:
- * 1. Decreasing frequency in small steps
- * 2. Checking the RSSI (signal strength) at each step
- * 3. Stopping when a strong enough signal is found
- * 4. Wrapping from 87.5 MHz to 108.0 MHz if needed
+ * With ENABLE_ENCODER, the encoder push switch behaves as OK.
+ * 
+ * @param currentMillis Current time in ms
  */
-void seekDown() {
-  float originalFrequency = currentFrequency;
-  float step = 0.1; // MHz
-  int rssiThreshold = 30; // Minimum RSSI for a valid station
-  int maxSteps = 2050; // Maximum steps to prevent infinite loop (205 MHz range / 0.1 MHz step)
+void handleButtons(unsigned long currentMillis) {
+  bool upChanged = debounceButton(btnUp, BtnUp::pressed(), currentMillis);
+  bool downChanged = debounceButton(btnDown, BtnDown::pressed(), currentMillis);
+#if defined(ENABLE_ENCODER)
+  // The encoder push switch acts as a second OK button
+  bool okChanged = debounceButton(btnOk, BtnOk::pressed() || EncSw::pressed(), currentMillis);
+#else
+  bool okChanged = debounceButton(btnOk, BtnOk::pressed(), currentMillis);
+#endif
   
-  Serial.println("Seeking down...");
+  if (okChanged && btnOk.down) {
+    okUsedAsModifier = false;
+  }
   
-  for (int i = 0; i < maxSteps; i++) {
-    currentFrequency -= step;
-    if (currentFrequency < 87.5) currentFrequency = 108.0;
-    
-    // Set the new frequency
-    radio.setFrequency(currentFrequency);
-    
-    // Small delay to allow RSSI to stabilize
-    delay(50);
-    
-    // Check signal strength
-    int rssi = radio.getRssi();
-    
-    // If we found a strong enough signal, stop seeking
-    if (rssi > rssiThreshold) {
-      Serial.print("Found station at ");
-      Serial.print(currentFrequency);
-      Serial.print(" MHz with RSSI ");
-      Serial.println(rssi);
-      updateDisplay();
-      return;
-    }
-    
-    // If we've gone full circle, stop seeking
-    if (abs(currentFrequency - originalFrequency) < 0.01 && i > 10) {
-      Serial.println("No stations found during seek down");
-      break;
-    }
+  // Trace the presses: 1 UP, 2 DOWN, 3 OK
+  if (upChanged && btnUp.down) TRACE_INSTANT(TRACE_BUTTON, 1);
+  if (downChanged && btnDown.down) TRACE_INSTANT(TRACE_BUTTON, 2);
+  if (okChanged && btnOk.down) TRACE_INSTANT(TRACE_BUTTON, 3);
+  if (upChanged || downChanged || okChanged) noteInput();
+  
+  // Any press during a preview stays on the current station and is
+  // otherwise ignored
+  if (previewActive && ((upChanged && btnUp.down) || (downChanged && btnDown.down) ||
+                        (okChanged && btnOk.down))) {
+    stopPreview();
+    if (btnUp.down) btnUp.repeats = 0xFF;
+    if (btnDown.down) btnDown.repeats = 0xFF;
+    if (btnOk.down) okUsedAsModifier = true;
+    return;
   }
   
-  // If no station found, restore original frequency
-  currentFrequency = originalFrequency;
-  radio.setFrequency(currentFrequency);
-  updateDisplay();
+  // UP and DOWN pressed together start a preview
+  if ((upChanged && btnUp.down && btnDown.down) || (downChanged && btnDown.down && btnUp.down)) {
+    btnUp.repeats = 0xFF;
+    btnDown.repeats = 0xFF;
+    startPreview();
+    return;
+  }
+  
+  handleTuneButton(btnUp, upChanged, +1, currentMillis);
+  handleTuneButton(btnDown, downChanged, -1, currentMillis);
+  
+  // OK released, unless it was held for a seek: a long press switches the
+  // display page, a short one toggles the radio on/off
+  if (okChanged && !btnOk.down && !okUsedAsModifier) {
+    if (currentMillis - btnOk.pressedAt >= longPressDelay) {
+      nextDisplayPage();
+    } else {
+      togglePower();
+    }
+  }
 }
 
-#if defined(ESP8266) || defined(ESP32)
 /**
- * @brief Handle root web page request
+ * @brief Toggle the radio power state
  * 
- * This function generates and sends the main web interface page
- * that displays current radio status and provides control buttons.
- * The page includes:
- * - Current frequency in MHz
- * - Radio status (ON/OFF)
- * - Volume level
- * - Control buttons for UP, DOWN, and TOGGLE functions
+ * When turning ON, stops any background scan, tunes back to the current
+ * frequency and unmutes. When turning OFF, mutes the radio; the tuner is
+ * then free for background band scans.
  */
-void handleRoot() {
-  String html = "<!DOCTYPE html><html>";
-  html += "<head><title>FM Radio Control</title>";
-  html += "<meta name='viewport' content='width=device-width, initial-scale=1'>";
-  html += "<style>";
-  html += "body { font-family: Arial, sans-serif; text-align: center; margin: 20px; }";
-  html += "button { font-size: 24px; padding: 15px; margin: 10px; width: 200px; }";
-  html += ".freq { font-size: 36px; margin: 20px; }";
-  html += ".status { font-size: 24px; margin: 20px; }";
-  html += "</style></head>";
-  html += "<body>";
-  html += "<h1>FM Radio Control</h1>";
-  html += "<div class='freq'>" + String(currentFrequency, 1) + " MHz</div>";
-  html += "<div class='status'>Status: " + String(radioOn ? "ON" : "OFF") + "</div>";
-  html += "<div class='status'>Volume: " + String(volume) + "</div>";
-  
-#if defined(ENABLE_RDS)
-  // Add RDS information if available
-  if (strlen(rdsProgramService) > 0) {
-    html += "<div class='status'>Station: " + String(rdsProgramService) + "</div>";
-  }
-  if (strlen(rdsProgramType) > 0) {
-    html += "<div class='status'>Type: " + String(rdsProgramType) + "</div>";
-  }
-  if (strlen(rdsRadioText) > 0) {
-    html += "<div class='status'>Info: " + String(rdsRadioText) + "</div>";
+void togglePower() {
+  stopPreview();
+  stopSeek();
+  radioOn = !radioOn;
+  if (radioOn) {
+    stopScan();
+    tunerSetFrequency(currentFrequency);
+    tunerSetMute(false);
+  } else {
+    tunerSetMute(true);
   }
-#endif
-  
-  html += "<button onclick='location.href=\"/up\"'>UP (+0.1)</button><br>";
-  html += "<button onclick='location.href=\"/seekup\"'>SEEK UP</button><br>";
-  html += "<button onclick='location.href=\"/down\"'>DOWN (-0.1)</button><br>";
-  html += "<button onclick='location.href=\"/seekdown\"'>SEEK DOWN</button><br>";
-  html += "<button onclick='location.href=\"/toggle\"'>TOGGLE</button><br>";
-  html += "</body></html>";
-  server.send(200, "text/html", html);
+  markDirty(FIELD_POWER | FIELD_SCAN);
 }
 
 /**
- * @brief Handle frequency increase request from web interface
+ * @brief Tune the receiver, retrying if the tuner does not acknowledge
  * 
- * Increases the radio frequency by 0.1 MHz with wraparound
- * from 108.0 MHz to 87.5 MHz, updates the radio module,
- * refreshes the display, and redirects back to the main page.
+ * @param frequency Frequency in 10 kHz units
  */
-void handleUp() {
-  currentFrequency += 0.1;
-  if (currentFrequency > 108.0) currentFrequency = 87.5;
-  radio.setFrequency(currentFrequency);
-  updateDisplay();
-  server.sendHeader("Location", "/");
-  server.send(303);
+void tunerSetFrequency(uint16_t frequency) {
+  tunerBusRun([=]() { radio.setFrequency(frequency); });
 }
 
 /**
- * @brief Handle frequency decrease request from web interface
- * 
- * Decreases the radio frequency by 0.1 MHz with wraparound
- * from 87.5 MHz to 108.0 MHz, updates the radio module,
- * refreshes the display, and redirects back to the main page.
+ * @brief Mute or unmute the receiver, retrying if the tuner does not
+ * acknowledge
  */
-void handleDown() {
-  currentFrequency -= 0.1;
-  if (currentFrequency < 87.5) currentFrequency = 108.0;
-  radio.setFrequency(currentFrequency);
-  updateDisplay();
-  server.sendHeader("Location", "/");
-  server.send(303);
+void tunerSetMute(bool mute) {
+  tunerBusRun([=]() { radio.setMute(mute); });
 }
 
 /**
- * @brief Handle station seek up request from web interface
- * 
- * Seeks up to the next valid FM station using RSSI detection,
- * updates the radio module, refreshes the display, and 
+ * @brief Set the receiver volume, retrying if the tuner does not
+ * acknowledge
+ */
+void tunerSetVolume(uint8_t level) {
+  tunerBusRun([=]() { radio.setVolume(level); });
+}
+
+#if defined(ENABLE_ENCODER)
+/**
+ * @brief Rotary encoder interrupt handler
+ * 
+ * Called on every edge of either encoder phase. Looks the transition up in
+ * encoderTable and adds it to the quarter steps; contact bounce produces
+ * invalid or cancelling transitions that add up to zero. Each whole
+ * detent is queued in inputEvents, or added to encoderHeld if the ring is
+ * full, so the loop gets every detent however long it was blocked and
+ * the quarter steps never leave the ISR.
+ */
+void IRAM_ATTR encoderISR() {
+  uint8_t state = ((encoderState << 2) | (EncA::read() << 1) | EncB::read()) & 0x0F;
+  encoderState = state;
+  encoderQuarters += encoderTable[state];
+  if (encoderQuarters >= encoderStepsPerDetent || encoderQuarters <= -encoderStepsPerDetent) {
+    int8_t detent = encoderQuarters > 0 ? 1 : -1;
+    encoderQuarters -= detent * encoderStepsPerDetent;
+    if (!inputEvents.push({EVENT_ENCODER, detent})) {
+#if defined(__AVR__)
+      encoderHeld += detent;          // The loop cannot run meanwhile
+#else
+      __atomic_fetch_add(&encoderHeld, detent, __ATOMIC_RELAXED);
+#endif
+    }
+  }
+}
+
+#if defined(BOARD_ENCODER_PCINT_VECT)
+ISR(BOARD_ENCODER_PCINT_VECT) {
+  encoderISR();
+}
+#endif
+
+/**
+ * @brief Turn encoder movement into tuning steps
+ * 
+ * Drains the detents queued by the ISR, and any it had to hold back,
+ * converts them to frequency steps and queues them with tuneStep(), so a
+ * fast spin becomes a single retune. Detents arriving quickly one after
+ * another are scaled up to 500 kHz or 1 MHz steps.
+ * 
+ * @param currentMillis Current time in ms
+ */
+void handleEncoder(unsigned long currentMillis) {
+  int detents = 0;
+  InputEvent event;
+  while (inputEvents.pop(event)) {
+    if (event.type == EVENT_ENCODER) detents += event.value;
+  }
+#if defined(__AVR__)
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    detents += encoderHeld;
+    encoderHeld = 0;
+  }
+#else
+  detents += __atomic_exchange_n(&encoderHeld, 0, __ATOMIC_RELAXED);
+#endif
+  if (detents == 0) return;
+  
+  int step = FREQ_STEP;
+  unsigned long interval = currentMillis - lastEncoderDetent;
+  if (interval < encoderFasterInterval) step = 10 * FREQ_STEP;
+  else if (interval < encoderFastInterval) step = 5 * FREQ_STEP;
+  lastEncoderDetent = currentMillis;
+  noteInput();
+  
+  if (previewActive) {
+    stopPreview();
+    return;
+  }
+  
+  // Turning with the switch (or OK) held seeks instead
+  if (btnOk.down) {
+    okUsedAsModifier = true;
+    if (detents > 0) seekUp(); else seekDown();
+    return;
+  }
+  
+  tuneStep(detents * step);
+}
+#endif
+
+/**
+ * @brief Queue a frequency change
+ * 
+ * The step is added to the pending tuning target, wrapping around the
+ * band edges. Several steps queued in the same loop pass result in a
+ * single retune in serviceTuning().
+ * 
+ * @param delta Frequency change in 10 kHz units
+ */
+void tuneStep(int delta) {
+  long target = (long)(tunePending ? tuneTarget : currentFrequency) + delta;
+  if (target > FREQ_MAX) target = FREQ_MIN;
+  if (target < FREQ_MIN) target = FREQ_MAX;
+  tuneTarget = (uint16_t)target;
+  tunePending = true;
+}
+
+/**
+ * @brief Apply the pending tuning target, if any
+ * 
+ * Programs the tuner and redraws the display once, with the latest target.
+ */
+void serviceTuning() {
+  if (!tunePending) return;
+  tunePending = false;
+  stopPreview();
+  stopSeek();
+  if (tuneTarget == currentFrequency) return;
+  stopScan();
+  currentFrequency = tuneTarget;
+  tunerSetFrequency(currentFrequency);
+  resetSignalHistory();
+  statRetunes++;
+  TRACE_INSTANT(TRACE_RETUNE, currentFrequency);
+  markDirty(FIELD_FREQUENCY | FIELD_SIGNAL);
+}
+
+/**
+ * @brief Draw a string kept in flash, at the baseline like drawStr()
+ */
+void drawFlashStr(uint8_t x, uint8_t y, const __FlashStringHelper *str) {
+  u8g2.setCursor(x, y);
+  u8g2.print(str);
+}
+
+#if defined(DISPLAY_CACHE)
+/**
+ * @brief Frame buffer index of a screen pixel column in a buffer page
+ * 
+ * The display is mounted upside down (U8G2_R2), so columns are mirrored.
+ */
+uint16_t frameIndex(uint8_t page, uint8_t x) {
+  return page * u8g2.getBufferTileWidth() * 8 + (u8g2.getDisplayWidth() - 1 - x);
+}
+
+/**
+ * @brief Render the static part of the main page and the frequency glyphs
+ * 
+ * Runs once, on the first main page frame: draws "FM Radio", "MHz" and
+ * "Vol:" into the cleared frame buffer and keeps a copy of it, then draws
+ * each frequency glyph on its own and keeps the buffer bytes it covers.
+ * The frequency baseline never moves, so neither do the pages the glyphs
+ * fall on; only their column changes.
+ */
+void buildMainCache() {
+  uint8_t *buf = u8g2.getBufferPtr();
+  
+  u8g2.clearBuffer();
+  u8g2.setFont(FONT_TITLE);
+  char title[9];
+  strcpy_P(title, PSTR("FM Radio"));
+  u8g2.drawStr((84 - u8g2.getStrWidth(title)) / 2, MAIN_TITLE_Y, title);
+  drawFlashStr(65, MAIN_FREQ_Y, F("MHz"));
+  u8g2.setFont(FONT_STATUS);
+  drawFlashStr(30, MAIN_STATUS_Y, F("Vol:"));
+  volumeX = u8g2.tx;
+  memcpy(baseFrame, buf, FRAME_BYTES);
+  
+  // Pages covered by the glyphs, from the lowest to the highest set pixel
+  u8g2.setFont(FONT_FREQUENCY);
+  uint8_t pages = u8g2.getBufferTileHeight();
+  uint8_t first = pages;
+  for (uint8_t g = 0; g < FREQ_GLYPHS; g++) {
+    char glyph[2] = {g < 10 ? (char)('0' + g) : '.', '\0'};
+    freqGlyphRight[g] = u8g2.getStrWidth(glyph);
+    u8g2.clearBuffer();
+    u8g2.drawStr(0, MAIN_FREQ_Y, glyph);
+    for (uint8_t p = 0; p < pages && p < first; p++) {
+      for (uint8_t i = 0; i < FREQ_GLYPH_WIDTH; i++) {
+        if (buf[frameIndex(p, i)]) {
+          first = p;
+          break;
+        }
+      }
+    }
+  }
+  freqGlyphPage = first < pages - FREQ_GLYPH_PAGES ? first : pages - FREQ_GLYPH_PAGES;
+  for (uint8_t g = 0; g < FREQ_GLYPHS; g++) {
+    char glyph[2] = {g < 10 ? (char)('0' + g) : '.', '\0'};
+    u8g2.clearBuffer();
+    u8g2.drawStr(0, MAIN_FREQ_Y, glyph);
+    for (uint8_t p = 0; p < FREQ_GLYPH_PAGES; p++) {
+      for (uint8_t i = 0; i < FREQ_GLYPH_WIDTH; i++) {
+        freqGlyphs[g][p][i] = buf[frameIndex(freqGlyphPage + p, i)];
+      }
+    }
+  }
+  u8g2.clearBuffer();
+  mainCacheReady = true;
+}
+
+/**
+ * @brief Draw the frequency from the glyph cache, right aligned like
+ * drawStr() at MAIN_FREQ_RIGHT - getStrWidth()
+ */
+void drawCachedFrequency(const char *str, uint8_t len) {
+  uint8_t *buf = u8g2.getBufferPtr();
+  char last = str[len - 1];
+  uint8_t x = MAIN_FREQ_RIGHT - (len - 1) * FREQ_GLYPH_WIDTH -
+              freqGlyphRight[last == '.' ? 10 : last - '0'];
+  for (uint8_t n = 0; n < len; n++, x += FREQ_GLYPH_WIDTH) {
+    const uint8_t (*glyph)[FREQ_GLYPH_WIDTH] = freqGlyphs[str[n] == '.' ? 10 : str[n] - '0'];
+    for (uint8_t p = 0; p < FREQ_GLYPH_PAGES; p++) {
+      for (uint8_t i = 0; i < FREQ_GLYPH_WIDTH; i++) {
+        buf[frameIndex(freqGlyphPage + p, x + i)] |= glyph[p][i];
+      }
+    }
+  }
+}
+#endif
+
+/**
+ * @brief Draw the main page
+ * 
+ * - Title "FM Radio", or the RDS station name when available
+ * - Current frequency in MHz
+ * - Radio status (ON/OFF)
+ * - Volume level
+ * - Signal strength graph of the current station
+ * 
+ * With DISPLAY_CACHE the frame starts as a copy of the pre-rendered
+ * static layout and the frequency is copied from the glyph cache, so
+ * only the status, the volume and an RDS title go through the fonts.
+ */
+void drawMainPage() {
+  char title[9] = "";
+#if defined(ENABLE_RDS)
+  strcpy(title, rdsProgramService);
+#endif
+  char freqStr[FORMAT_FREQUENCY_SIZE];
+  
+#if defined(DISPLAY_CACHE)
+  if (!mainCacheReady) buildMainCache();
+  memcpy(u8g2.getBufferPtr(), baseFrame, FRAME_BYTES);
+  if (title[0]) {
+    // The station name replaces the title of the base frame
+    u8g2.setDrawColor(0);
+    u8g2.drawBox(0, 0, 84, MAIN_TITLE_HEIGHT);
+    u8g2.setDrawColor(1);
+    u8g2.setFont(FONT_TITLE);
+    int x = (84 - u8g2.getStrWidth(title)) / 2;
+    u8g2.drawStr(x < 0 ? 0 : x, MAIN_TITLE_Y, title);
+  }
+  drawCachedFrequency(freqStr, formatFrequency(freqStr, currentFrequency));
+  u8g2.setFont(FONT_STATUS);
+#else
+  // Display title or station name, and the frequency unit in the same
+  // font, so each font is selected once per frame
+  u8g2.setFont(FONT_TITLE);
+  if (!title[0]) strcpy_P(title, PSTR("FM Radio"));
+  int x = (84 - u8g2.getStrWidth(title)) / 2;
+  u8g2.drawStr(x < 0 ? 0 : x, MAIN_TITLE_Y, title);
+  drawFlashStr(65, MAIN_FREQ_Y, F("MHz"));
+  
+  // Display frequency, right aligned to five digits
+  u8g2.setFont(FONT_FREQUENCY);
+  formatFrequency(freqStr, currentFrequency);
+  u8g2.drawStr(MAIN_FREQ_RIGHT - u8g2.getStrWidth(freqStr), MAIN_FREQ_Y, freqStr);
+  
+  u8g2.setFont(FONT_STATUS);
+#endif
+  
+  // Display status
+  if (previewActive) {
+    drawFlashStr(0, MAIN_STATUS_Y, F("PRV"));
+  } else if (radioOn) {
+    drawFlashStr(0, MAIN_STATUS_Y, F("ON "));
+  } else {
+    drawFlashStr(0, MAIN_STATUS_Y, F("OFF"));
+  }
+  
+  // Display volume
+#if defined(DISPLAY_CACHE)
+  u8g2.setCursor(volumeX, MAIN_STATUS_Y);
+#else
+  u8g2.setCursor(30, MAIN_STATUS_Y);
+  u8g2.print(F("Vol:"));
+#endif
+  u8g2.print(volume);
+  
+  // Display signal strength graph
+  drawSignalGraph();
+}
+
+#if defined(ENABLE_RDS)
+/**
+ * @brief Draw the RDS detail page
+ * 
+ * Station name and PI code, program type and traffic flags, then the
+ * whole 64 character radio text wrapped over four lines.
+ */
+void drawRdsPage() {
+  char line[17];
+  u8g2.setFont(FONT_TEXT);
+  // 5 pixel wide cells: PI and the flags start at fixed columns
+  u8g2.drawStr(0, 7, rdsProgramService);
+  formatHex4(line, rdsPI);
+  u8g2.drawStr(45, 7, line);
+  u8g2.drawStr(0, 15, rdsProgramType);
+  if (rdsTrafficProgram) drawFlashStr(40, 15, F("TP"));
+  if (rdsTrafficAnnouncement) drawFlashStr(55, 15, F("TA"));
+  
+  // 16 characters per line, 4 lines hold the full radio text
+  const char *rt = rdsRadioText;
+  for (uint8_t row = 0; row < 4 && *rt; row++) {
+    strncpy(line, rt, 16);
+    line[16] = '\0';
+    u8g2.drawStr(0, 23 + row * 8, line);
+    rt += strlen(line);
+  }
+}
+#endif
+
+/**
+ * @brief Draw the signal page
+ * 
+ * Latest RSSI with the stereo and FM-true indicators, and the whole signal
+ * history of the current station as a bar chart.
+ */
+void drawSignalPage() {
+  u8g2.setFont(FONT_STATUS);
+  SignalSample last = {0, 0};
+  if (signalCount) last = signalHistory[(signalHead + SIGNAL_HISTORY - 1) % SIGNAL_HISTORY];
+  u8g2.setCursor(0, 9);
+  u8g2.print(last.rssi);
+  u8g2.print(F("dBuV"));
+  if (last.flags & SIGNAL_FLAG_STEREO) drawFlashStr(48, 9, F("ST"));
+  if (last.flags & SIGNAL_FLAG_FMTRUE) drawFlashStr(66, 9, F("FM"));
+  
+  // Oldest sample on the left, 2 pixels per sample, up to 36 pixels high
+  uint8_t start = (signalHead + SIGNAL_HISTORY - signalCount) % SIGNAL_HISTORY;
+  for (uint8_t i = 0; i < signalCount; i++) {
+    uint8_t rssi = signalHistory[(start + i) % SIGNAL_HISTORY].rssi;
+    uint8_t h = rssi > 64 ? 36 : (uint16_t)rssi * 36 / 64;
+    if (h > 0) u8g2.drawBox(i * 2 + 10, 48 - h, 2, h);
+  }
+}
+
+#if BOARD_HAS_WIFI
+/**
+ * @brief Draw the network page: access point name and address, station
+ * address (or connection state)
+ */
+void drawNetworkPage() {
+  u8g2.setFont(FONT_TEXT);
+  drawFlashStr(0, 7, F("AP " AP_SSID));
+  // Printed straight to the display, toString() would allocate
+  u8g2.setCursor(0, 15);
+  u8g2.print(WiFi.softAPIP());
+  drawFlashStr(0, 31, F("Station"));
+  if (WiFi.status() == WL_CONNECTED) {
+    u8g2.setCursor(0, 39);
+    u8g2.print(WiFi.localIP());
+  } else {
+    drawFlashStr(0, 39, F("not connected"));
+  }
+}
+#endif
+
+/**
+ * @brief Draw the statistics page: uptime and activity counters
+ */
+void drawStatsPage() {
+  const MemStats &mem = memstats();
+  u8g2.setFont(FONT_TEXT);
+  u8g2.setCursor(0, 7);
+  u8g2.print(F("Up "));
+  u8g2.print(millis() / 60000UL);
+  u8g2.print('m');
+  u8g2.setCursor(42, 7);
+  u8g2.print(F("Drw "));
+  u8g2.print(statRenders);
+  u8g2.setCursor(0, 15);
+  u8g2.print(F("Tun "));
+  u8g2.print(statRetunes);
+  u8g2.setCursor(42, 15);
+  u8g2.print(F("Sek "));
+  u8g2.print(statSeeks);
+  u8g2.setCursor(0, 23);
+  u8g2.print(F("Scn "));
+  u8g2.print(statScans);
+  u8g2.setCursor(42, 23);
+  u8g2.print(F("Hop "));
+  u8g2.print(statHops);
+  
+  // Memory: free heap and fragmentation, largest block, lowest free
+  // heap, unused stack and fragmentation alarms
+  u8g2.drawHLine(0, 25, 84);
+  u8g2.setCursor(0, 33);
+  u8g2.print(F("H "));
+  u8g2.print(mem.heapFree);
+  u8g2.setCursor(42, 33);
+  u8g2.print(F("F "));
+  u8g2.print(mem.fragmentation);
+  u8g2.print('%');
+  u8g2.setCursor(0, 40);
+  u8g2.print(F("B "));
+  u8g2.print(mem.largestBlock);
+  u8g2.setCursor(42, 40);
+  u8g2.print(F("L "));
+  u8g2.print(mem.heapMinFree);
+  u8g2.setCursor(0, 47);
+  u8g2.print(F("S "));
+  u8g2.print(mem.stackFree);
+  u8g2.setCursor(42, 47);
+  u8g2.print(F("A "));
+  u8g2.print(mem.alarms);
+}
+
+// Display pages in cycling order, with the state fields each one shows
+// (must follow the order of the DisplayPage enum)
+const DisplayPageInfo displayPages[] = {
+  {drawMainPage, FIELD_FREQUENCY | FIELD_POWER | FIELD_VOLUME | FIELD_RDS_PS},
+#if defined(ENABLE_RDS)
+  {drawRdsPage, FIELD_RDS_PS | FIELD_RDS_RT | FIELD_RDS_INFO},
+#endif
+  {drawSignalPage, FIELD_FREQUENCY | FIELD_SIGNAL},
+  {drawSpectrumPage, FIELD_FREQUENCY | FIELD_SCAN},
+#if BOARD_HAS_WIFI
+  {drawNetworkPage, FIELD_NETWORK},
+#endif
+  {drawStatsPage, FIELD_STATS},
+};
+static_assert(sizeof(displayPages) / sizeof(displayPages[0]) == PAGE_COUNT,
+              "displayPages must have one entry per DisplayPage");
+
+/**
+ * @brief Mark state fields as changed
+ * 
+ * The display is redrawn by serviceDisplay() only if the active page
+ * shows one of the changed fields.
+ * 
+ * @param fields FIELD_* bits
+ */
+void markDirty(uint16_t fields) {
+  displayDirty |= fields;
+}
+
+/**
+ * @brief Switch to the next display page
+ */
+void nextDisplayPage() {
+  displayPage = (DisplayPage)((displayPage + 1) % PAGE_COUNT);
+  markDirty(FIELD_PAGE);
+}
+
+/**
+ * @brief Redraw the display if the active page shows a changed field
+ * 
+ * Changes to fields that are not on the active page are dropped: the
+ * page that shows them is drawn from scratch when it becomes active.
+ */
+void serviceDisplay() {
+  // An input that changed nothing on this page is not waited for
+  if (inputPending && micros() - inputPendingSince > inputLatencyTimeout) {
+    inputPending = false;
+#if defined(DISPLAY_DMA)
+    inputFrame = 0;
+#endif
+  }
+  uint16_t dirty = displayDirty;
+  displayDirty = 0;
+  if (dirty & (displayPages[displayPage].fields | FIELD_PAGE)) {
+    updateDisplay();
+  }
+}
+
+/**
+ * @brief Add a measurement to a latency statistic
+ */
+void latencyAdd(LatencyStat &stat, unsigned long us) {
+  stat.count++;
+  stat.last = us;
+  stat.total += us;
+  if (us > stat.max) stat.max = us;
+}
+
+/**
+ * @brief Note a user input; the next full redraw closes its latency
+ * 
+ * Inputs arriving before that redraw are merged into the oldest one.
+ */
+void noteInput() {
+  if (inputPending) return;
+  inputPending = true;
+  inputPendingSince = micros();
+}
+
+/**
+ * @brief Update the Nokia 5110 display with the active page
+ * 
+ * The display uses a double-buffering technique where all content is drawn
+ * to a buffer first, then displayed all at once to prevent flickering.
+ */
+void updateDisplay() {
+  loopBusy = true;
+  statRenders++;
+  TRACE_BEGIN(TRACE_RENDER);
+  // Full frame buffer: the same as firstPage()/nextPage(), in one pass
+  u8g2.clearBuffer();
+  displayPages[displayPage].draw();
+#if defined(DISPLAY_DMA)
+  if (displayDma) {
+    displayDmaSend(u8g2.getBufferPtr(), u8g2.getBufferTileWidth() * 8,
+                   0, u8g2.getDisplayWidth(), 0, u8g2.getBufferTileHeight());
+  } else {
+    u8g2.sendBuffer();
+  }
+#else
+  u8g2.sendBuffer();
+#endif
+  TRACE_END(TRACE_RENDER);
+  
+  if (inputPending) {
+#if defined(DISPLAY_DMA)
+    // The input shows once the frame is out: serviceInputFrame() closes it
+    if (displayDma) {
+      if (!inputFrame) inputFrame = displayDmaStats().frames;
+      return;
+    }
+#endif
+    latencyAdd(latencyInput, micros() - inputPendingSince);
+    inputPending = false;
+  }
+}
+
+#if defined(DISPLAY_DMA)
+/**
+ * @brief Close the pending input latency when the DMA frame showing it
+ * has been sent
+ */
+void serviceInputFrame() {
+  const DisplayDmaStats &dma = displayDmaStats();
+  if (!inputFrame || (long)(dma.sent - inputFrame) < 0) return;
+  latencyAdd(latencyInput, dma.sentAt - inputPendingSince);
+  inputPending = false;
+  inputFrame = 0;
+}
+#endif
+
+/**
+ * @brief Push a rectangle of the frame buffer to the display
+ * 
+ * The display is mounted upside down (U8G2_R2) while updateDisplayArea()
+ * works in unrotated tile coordinates, so the rectangle is mirrored before
+ * being converted to the 8x8 tiles that cover it.
+ * 
+ * @param x Left edge in screen coordinates
+ * @param y Top edge in screen coordinates
+ * @param w Width in pixels
+ * @param h Height in pixels
+ */
+void updateDisplayRect(uint8_t x, uint8_t y, uint8_t w, uint8_t h) {
+  uint8_t hx = u8g2.getDisplayWidth() - x - w;
+  uint8_t hy = u8g2.getDisplayHeight() - y - h;
+  uint8_t tx = hx / 8;
+  uint8_t ty = hy / 8;
+#if defined(DISPLAY_DMA)
+  // The DMA backend addresses columns, not tiles
+  if (displayDma) {
+    displayDmaSend(u8g2.getBufferPtr(), u8g2.getBufferTileWidth() * 8,
+                   hx, w, ty, (hy + h + 7) / 8 - ty);
+    return;
+  }
+#endif
+  u8g2.updateDisplayArea(tx, ty, (hx + w + 7) / 8 - tx, (hy + h + 7) / 8 - ty);
+}
+
+/**
+ * @brief Bar height for one signal sample
+ * 
+ * RSSI values up to 64 dBuV are spread over the graph height.
+ */
+uint8_t signalBarHeight(uint8_t rssi) {
+  uint8_t h = rssi / 8;
+  return h > SIGNAL_GRAPH_HEIGHT ? SIGNAL_GRAPH_HEIGHT : h;
+}
+
+/**
+ * @brief Draw one column of the signal graph into the frame buffer
+ * 
+ * @param col Graph column
+ * @param h Bar height in pixels
+ */
+void drawSignalColumn(uint8_t col, uint8_t h) {
+  uint8_t x = SIGNAL_GRAPH_X + col;
+  u8g2.setDrawColor(0);
+  u8g2.drawVLine(x, SIGNAL_GRAPH_Y, SIGNAL_GRAPH_HEIGHT);
+  u8g2.setDrawColor(1);
+  if (h > 0) {
+    u8g2.drawVLine(x, SIGNAL_GRAPH_Y + SIGNAL_GRAPH_HEIGHT - h, h);
+  }
+  signalGraphDrawn[col] = h;
+}
+
+/**
+ * @brief Draw the whole signal graph into the frame buffer
+ * 
+ * The graph is a sweep: sample n always lands in column n modulo the graph
+ * width, so a new sample changes a single column instead of scrolling the
+ * whole graph.
+ */
+void drawSignalGraph() {
+  for (uint8_t col = 0; col < SIGNAL_GRAPH_WIDTH; col++) {
+    signalGraphDrawn[col] = 0;
+  }
+  for (uint8_t i = 0; i < signalCount && i < SIGNAL_GRAPH_WIDTH; i++) {
+    uint8_t idx = (signalHead + SIGNAL_HISTORY - 1 - i) % SIGNAL_HISTORY;
+    drawSignalColumn(idx % SIGNAL_GRAPH_WIDTH, signalBarHeight(signalHistory[idx].rssi));
+  }
+}
+
+/**
+ * @brief Forget the signal history, called whenever the station changes
+ */
+void resetSignalHistory() {
+  signalHead = 0;
+  signalCount = 0;
+  idleLoops = 0;
+}
+
+/**
+ * @brief Take one signal quality sample
+ * 
+ * Reads RSSI and the stereo/FM-true indicators into the ring buffer. On
+ * the main page, if the bar height of its graph column changed, redraws
+ * that column and sends only the tiles it covers to the display; other
+ * pages showing the signal are redrawn by serviceDisplay().
+ * 
+ * @param currentMillis Current time in ms
+ */
+void sampleSignal(unsigned long currentMillis) {
+  SignalSample &sample = signalHistory[signalHead];
+  sample.rssi = radio.getRssi();
+  sample.flags = 0;
+  if (radio.isStereo()) sample.flags |= SIGNAL_FLAG_STEREO;
+  if (radio.isFmTrue()) sample.flags |= SIGNAL_FLAG_FMTRUE;
+  lastSignalSample = currentMillis;
+  
+#if defined(ENABLE_HISTORY)
+  if (currentMillis - lastHistorySample >= historySampleInterval) {
+    historyLogSample(currentFrequency, sample.rssi, sample.flags);
+    lastHistorySample = currentMillis;
+  }
+#endif
+  
+  uint8_t col = signalHead % SIGNAL_GRAPH_WIDTH;
+  signalHead = (signalHead + 1) % SIGNAL_HISTORY;
+  if (signalCount < SIGNAL_HISTORY) signalCount++;
+  
+  uint8_t h = signalBarHeight(sample.rssi);
+  if (displayPage == PAGE_MAIN && h != signalGraphDrawn[col]) {
+    drawSignalColumn(col, h);
+    updateDisplayRect(SIGNAL_GRAPH_X + col, SIGNAL_GRAPH_Y, 1, SIGNAL_GRAPH_HEIGHT);
+  }
+  markDirty(FIELD_SIGNAL);
+}
+
+/**
+ * @brief Run the signal sampler if the loop has time for it
+ * 
+ * Passes that took new RDS data, retuned, redrew the display or served
+ * a page are skipped, so sampling never competes with them. After
+ * signalIdleLoops idle passes in a row the sampling interval drops from
+ * signalIntervalBusy to signalIntervalIdle.
+ * 
+ * @param currentMillis Current time in ms
+ */
+void serviceSignal(unsigned long currentMillis) {
+  if (loopBusy) {
+    idleLoops = 0;
+    return;
+  }
+  if (idleLoops < signalIdleLoops) idleLoops++;
+  if (!radioOn || tunerBusy()) return;
+  
+  unsigned long interval = idleLoops >= signalIdleLoops ? signalIntervalIdle : signalIntervalBusy;
+  if (currentMillis - lastSignalSample >= interval) {
+    sampleSignal(currentMillis);
+  }
+}
+
+/**
+ * @brief Spectrum column of a band channel
+ */
+uint8_t channelColumn(uint8_t channel) {
+  return (uint16_t)channel * SPECTRUM_WIDTH / BAND_CHANNELS;
+}
+
+/**
+ * @brief Draw one spectrum column into the frame buffer
+ * 
+ * RSSI values up to 64 dBuV are spread over the chart height. The column
+ * of the current frequency gets a marker dot on top.
+ * 
+ * @param col Spectrum column
+ */
+void drawSpectrumColumn(uint8_t col) {
+  uint8_t h = (uint16_t)spectrum[col] * SPECTRUM_HEIGHT / 64;
+  if (h > SPECTRUM_HEIGHT) h = SPECTRUM_HEIGHT;
+  u8g2.setDrawColor(0);
+  u8g2.drawVLine(col, SPECTRUM_Y, SPECTRUM_HEIGHT);
+  u8g2.setDrawColor(1);
+  if (h > 0) {
+    u8g2.drawVLine(col, SPECTRUM_Y + SPECTRUM_HEIGHT - h, h);
+  }
+  if (col == channelColumn((currentFrequency - FREQ_MIN) / FREQ_STEP)) {
+    u8g2.drawPixel(col, SPECTRUM_Y);
+  }
+}
+
+/**
+ * @brief Draw the spectrum page: band edges on the header line, then the
+ * last sweep as an 84 column bar chart
+ */
+void drawSpectrumPage() {
+  u8g2.setFont(FONT_TEXT);
+  drawFlashStr(0, 7, F("87.5"));
+  drawFlashStr(69, 7, F("108"));
+  if (coRunning(scanTask)) {
+    drawFlashStr(32, 7, F("scan"));
+  }
+  for (uint8_t col = 0; col < SPECTRUM_WIDTH; col++) {
+    drawSpectrumColumn(col);
+  }
+}
+
+/**
+ * @brief Start a band scan pass from the bottom of the band
+ * 
+ * The audio is muted during the pass. Any pass already running restarts.
+ * The first channel is tuned by the next serviceScan().
+ */
+void startScan() {
+  coStart(scanTask);
+  scanSurvey = false;
+  scanColumnMax = 0;
+  markDirty(FIELD_SCAN);
+  tunerSetMute(true);
+}
+
+/**
+ * @brief Abort a running band scan (or survey RDS probe) and go back to
+ * the current frequency
+ */
+void stopScan() {
+#if defined(ENABLE_SURVEY)
+  surveyAbortProbe();
+#endif
+  if (!coRunning(scanTask)) return;
+  coStop(scanTask);
+  tunerSetFrequency(currentFrequency);
+  if (radioOn) tunerSetMute(false);
+  markDirty(FIELD_SCAN);
+}
+
+/**
+ * @brief Advance the band scan by at most one channel (coroutine)
+ * 
+ * Tunes each channel in turn and measures its RSSI once scanSettleDelay
+ * has passed. When the last channel of a spectrum column is measured,
+ * the column is stored and, on the spectrum page, redrawn and sent to
+ * the display on its own.
+ * 
+ * While the radio is off, a new pass starts as soon as the previous one
+ * ends, so the spectrum keeps following the band.
+ * 
+ * @param currentMillis Current time in ms
+ */
+void serviceScan(unsigned long currentMillis) {
+  if (!coRunning(scanTask)) {
+    if (radioOn || tunerBusy()) return;
+    startScan();
+  }
+  
+  CO_BEGIN(scanTask);
+  for (scanChannel = 0; scanChannel < BAND_CHANNELS; scanChannel++) {
+    tunerSetFrequency(FREQ_MIN + scanChannel * FREQ_STEP);
+    CO_AWAIT_MS(scanTask, scanSettleDelay);
+    loopBusy = true;
+    
+    uint8_t rssi = radio.getRssi();
+    if (rssi > scanColumnMax) scanColumnMax = rssi;
+    uint8_t quality = measureQuality(rssi, QUALITY_NO_RDS);
+    cacheQuality(scanChannel, quality);
+#if defined(ENABLE_HISTORY)
+    historyScanChannel(scanChannel, rssi);
+#endif
+#if defined(ENABLE_SURVEY)
+    if (scanSurvey) surveyScanChannel(scanChannel, rssi, quality);
+#endif
+    
+    uint8_t col = channelColumn(scanChannel);
+    if (scanChannel == BAND_CHANNELS - 1 || channelColumn(scanChannel + 1) != col) {
+      spectrum[col] = scanColumnMax;
+      scanColumnMax = 0;
+      if (displayPage == PAGE_SPECTRUM) {
+        drawSpectrumColumn(col);
+        updateDisplayRect(col, SPECTRUM_Y, 1, SPECTRUM_HEIGHT);
+      }
+    }
+  }
+  
+  // Pass complete
+  if (radioOn) {
+    tunerSetFrequency(currentFrequency);
+    tunerSetMute(false);
+  }
+  statScans++;
+  stationMapValid = true;
+  markDirty(FIELD_SCAN);
+#if defined(ENABLE_HISTORY)
+  if (!historyScanLogged || currentMillis - lastHistoryScan >= historyScanInterval) {
+    historyScanDone();
+    lastHistoryScan = currentMillis;
+    historyScanLogged = true;
+  }
+#endif
+#if defined(ENABLE_SURVEY)
+  if (scanSurvey) surveyScanDone();
+#endif
+  CO_END(scanTask);
+}
+
+/**
+ * @brief Start the scan-and-preview mode
+ * 
+ * Turns the radio on if needed. The first hop happens on the next loop
+ * pass, or after a band scan when there is no station list yet.
+ */
+void startPreview() {
+  stopSeek();
+  if (!radioOn) togglePower();
+  previewActive = true;
+  previewTuned = false;
+  markDirty(FIELD_POWER);
+}
+
+/**
+ * @brief Leave the scan-and-preview mode, staying on the current station
+ */
+void stopPreview() {
+  if (!previewActive) return;
+  previewActive = false;
+  markDirty(FIELD_POWER);
+}
+
+#if defined(ENABLE_RDS)
+/**
+ * @brief Forget the RDS data of the previous station
+ * 
+ * The library keeps what it decoded across a retune, so its buffer is
+ * cleared too; otherwise the next poll would bring the old PS and RT back.
+ */
+void resetRdsData() {
+  radio.clearRdsBuffer();
+  memset(rdsProgramService, 0, sizeof(rdsProgramService));
+  memset(rdsRadioText, 0, sizeof(rdsRadioText));
+  memset(rdsProgramType, 0, sizeof(rdsProgramType));
+  rdsTrafficProgram = false;
+  rdsTrafficAnnouncement = false;
+  rdsPI = 0;
+  markDirty(FIELD_RDS_PS | FIELD_RDS_RT | FIELD_RDS_INFO);
+}
+#endif
+
+/**
+ * @brief Score the reception of the channel tuned now
+ * 
+ * Reads the FM-true, FM-ready and stereo indicators of the tuner and
+ * weighs them with the RSSI and the time RDS took to sync:
+ * - RSSI: 1 point per 5 dBuV above 20 dBuV, up to 6
+ * - Stereo pilot: 2
+ * - RDS sync within 250 ms: 3, within qualityRdsWindow: 2
+ * - FM-true and FM-ready both set: 4; without them the channel is noise
+ *   or an image of a strong station, and scores 3 at most
+ * 
+ * @param rssi RSSI of the channel, dBuV
+ * @param rdsSyncMs ms from tuning to RDS sync, QUALITY_NO_RDS if not
+ *        measured or not synced
+ * @return Score, 1 to QUALITY_MAX
+ */
+uint8_t measureQuality(uint8_t rssi, long rdsSyncMs) {
+  uint8_t score = rssi > 20 ? (rssi - 20) / 5 : 0;
+  if (score > 6) score = 6;
+  if (radio.isStereo()) score += 2;
+  if (rdsSyncMs != QUALITY_NO_RDS) {
+    if (rdsSyncMs <= 250) score += 3;
+    else if (rdsSyncMs <= (long)qualityRdsWindow) score += 2;
+  }
+  if (radio.isFmTrue() && radio.isFmReady()) score += 4;
+  else if (score > 3) score = 3;
+  return score ? score : 1;
+}
+
+/**
+ * @brief Get the cached quality of a channel, QUALITY_UNKNOWN if never
+ * measured
+ */
+uint8_t channelQuality(uint8_t ch) {
+  return (stationQuality[ch >> 1] >> ((ch & 1) * 4)) & 0x0F;
+}
+
+/**
+ * @brief Set the cached quality of a channel
+ */
+void setChannelQuality(uint8_t ch, uint8_t quality) {
+  uint8_t shift = (ch & 1) * 4;
+  stationQuality[ch >> 1] = (stationQuality[ch >> 1] & ~(0x0F << shift)) | (quality << shift);
+}
+
+/**
+ * @brief Cache a new quality measurement and update the station list
+ * 
+ * A score refined with the RDS sync time is kept while quick
+ * measurements (no RDS) still find a station on the channel.
+ */
+void cacheQuality(uint8_t ch, uint8_t quality) {
+  if (quality < qualityStation || channelQuality(ch) < qualityStation || quality > channelQuality(ch)) {
+    setChannelQuality(ch, quality);
+  }
+  if (quality >= qualityStation) stationMap[ch >> 3] |= 1 << (ch & 7);
+  else stationMap[ch >> 3] &= ~(1 << (ch & 7));
+}
+
+/**
+ * @brief Tune the next station of the station list
+ * 
+ * Stations are visited best first, by cached quality, and by frequency
+ * among equals. Measures the time spent programming the tuner and
+ * resetting RDS (the library's decoded data, then the firmware's
+ * copies), so the cost of a hop shows up in /api/status.
+ * 
+ * @return false if the list has no station
+ */
+bool previewHop() {
+  // Rank key: higher quality first, then lower frequency; the next
+  // station is the one with the smallest key after the current one,
+  // wrapping around to the smallest overall
+  uint8_t current = (currentFrequency - FREQ_MIN) / FREQ_STEP;
+  uint16_t currentKey = (QUALITY_MAX - channelQuality(current)) << 8 | current;
+  uint16_t nextKey = 0xFFFF;
+  uint16_t firstKey = 0xFFFF;
+  for (uint8_t i = 0; i < BAND_CHANNELS; i++) {
+    if (!(stationMap[i >> 3] & (1 << (i & 7)))) continue;
+    uint16_t key = (QUALITY_MAX - channelQuality(i)) << 8 | i;
+    if (key < firstKey) firstKey = key;
+    if (key > currentKey && key < nextKey) nextKey = key;
+  }
+  if (firstKey == 0xFFFF) return false;
+  uint8_t ch = (nextKey != 0xFFFF ? nextKey : firstKey) & 0xFF;
+  
+  unsigned long start = micros();
+  currentFrequency = FREQ_MIN + ch * FREQ_STEP;
+  tunerSetFrequency(currentFrequency);
+  unsigned long tuned = micros();
+#if defined(ENABLE_RDS)
+  // The library would hand the previous station's PS and RT back
+  resetRdsData();
+#endif
+  previewRetuneMicros = tuned - start;
+  previewRdsResetMicros = micros() - tuned;
+  previewRetuneTotal += previewRetuneMicros;
+  previewRdsResetTotal += previewRdsResetMicros;
+  statHops++;
+  TRACE_INSTANT(TRACE_HOP, currentFrequency);
+  
+  resetSignalHistory();
+  markDirty(FIELD_FREQUENCY | FIELD_SIGNAL | FIELD_STATS);
+  return true;
+}
+
+/**
+ * @brief Run the scan-and-preview mode
+ * 
+ * Waits for any scan pass in progress (starting one if there is no
+ * station list), then hops to the next station every previewDwell while
+ * RDS is polled as usual.
+ * 
+ * @param currentMillis Current time in ms
+ */
+void servicePreview(unsigned long currentMillis) {
+  if (!previewActive || tunerBusy()) return;
+  if (!stationMapValid) {
+    startScan();
+    return;
+  }
+  if (previewTuned && currentMillis - previewHopAt < previewDwell) return;
+  
+  loopBusy = true;
+  if (!previewHop()) {
+    Serial.println(F("No stations to preview"));
+    stopPreview();
+    return;
+  }
+  previewTuned = true;
+  previewHopAt = currentMillis;
+}
+
+/**
+ * @brief Check whether the tuner is away from the current station
+ * 
+ * True during a seek, a band scan pass or a survey RDS probe; station
+ * specific work (RDS polling, signal sampling) pauses meanwhile.
+ */
+bool tunerBusy() {
+#if defined(ENABLE_SURVEY)
+  if (surveyProbing) return true;
+#endif
+  return coRunning(seekTask) || coRunning(scanTask);
+}
+
+#if defined(ENABLE_SURVEY)
+/**
+ * @brief Clear the survey statistics
+ */
+void surveyReset() {
+  memset(&survey, 0, sizeof(survey));
+  memset(survey.rssiMin, 0xFF, sizeof(survey.rssiMin));
+  surveySweeps = 0;
+  surveyProbePending = false;
+}
+
+/**
+ * @brief Add one channel of a survey sweep to the statistics
+ * 
+ * The channel counts as occupied when it scores as a station, the same
+ * test seek and the station list use.
+ */
+void surveyScanChannel(uint8_t channel, uint8_t rssi, uint8_t quality) {
+  if (rssi < survey.rssiMin[channel]) survey.rssiMin[channel] = rssi;
+  if (rssi > survey.rssiMax[channel]) survey.rssiMax[channel] = rssi;
+  survey.rssiSum[channel] += rssi;
+  if (quality >= qualityStation) survey.occupied[channel]++;
+}
+
+/**
+ * @brief Count a finished survey sweep and queue the RDS probe
+ */
+void surveyScanDone() {
+  surveySweeps++;
+#if defined(ENABLE_RDS)
+  surveyProbePending = true;
+  surveyProbeChannel = 0;
+#endif
+}
+
+/**
+ * @brief Leave the channel being probed, e.g. because the user retuned
+ * 
+ * The rest of the probe is skipped until the next sweep.
+ */
+void surveyAbortProbe() {
+  surveyProbePending = false;
+  if (!surveyProbing) return;
+  surveyProbing = false;
+  tunerSetFrequency(currentFrequency);
+#if defined(ENABLE_RDS)
+  // Drop what was decoded on the probed channel
+  resetRdsData();
+#endif
+  if (radioOn) tunerSetMute(false);
+}
+
+#if defined(ENABLE_RDS)
+/**
+ * @brief Advance the RDS probe of occupied channels by one step
+ * 
+ * Listens on each occupied channel without a known PI for up to
+ * surveyProbeDwell, storing PI and PS as soon as they are decoded, then
+ * moves to the next one. When all are done the current station is
+ * restored.
+ */
+void surveyProbeStep(unsigned long currentMillis) {
+  if (surveyProbing) {
+    uint8_t ch = surveyProbeChannel;
+    bool done = currentMillis - surveyProbeStart >= surveyProbeDwell;
+    // Only groups of this channel: the decoder syncs again after a tune
+    if (radio.getRdsSync() && radio.getRDSready()) {
+      loopBusy = true;
+      char ps[9];
+      memset(ps, 0, sizeof(ps));
+      radio.getRDS_PS(ps);
+      survey.pi[ch] = radio.getRDS_PI();
+      if (strlen(ps) > 0) memcpy(survey.ps[ch], ps, sizeof(ps));
+      done = done || strlen(ps) == 8;
+    }
+    if (!done) return;
+    surveyProbing = false;
+    surveyProbeChannel++;
+  }
+  
+  // Next occupied channel without RDS data
+  while (surveyProbeChannel < BAND_CHANNELS &&
+         (survey.pi[surveyProbeChannel] != 0 ||
+          survey.occupied[surveyProbeChannel] == 0)) {
+    surveyProbeChannel++;
+  }
+  
+  if (surveyProbeChannel >= BAND_CHANNELS) {
+    surveyProbePending = false;
+    tunerSetFrequency(currentFrequency);
+    resetRdsData();
+    if (radioOn) tunerSetMute(false);
+    return;
+  }
+  
+  // The library still holds the PS of the last channel
+  tunerSetMute(true);
+  tunerSetFrequency(FREQ_MIN + surveyProbeChannel * FREQ_STEP);
+  radio.clearRdsBuffer();
+  surveyProbeStart = currentMillis;
+  surveyProbing = true;
+}
+#endif
+
+/**
+ * @brief Run the band survey schedule
+ * 
+ * Starts a sweep of the scan engine every surveyInterval and, with RDS
+ * enabled, probes the occupied channels for PI/PS after each sweep. Each
+ * call does at most one small step, so the loop stays responsive.
+ * 
+ * @param currentMillis Current time in ms
+ */
+void serviceSurvey(unsigned long currentMillis) {
+  if (!surveyRunning || previewActive || coRunning(seekTask)) return;
+  if (coRunning(scanTask) && scanSurvey) return;
+  
+#if defined(ENABLE_RDS)
+  if (surveyProbePending) {
+    surveyProbeStep(currentMillis);
+    return;
+  }
+#endif
+  
+  if (surveySweeps == 0 || currentMillis - surveyLastSweep >= surveyInterval) {
+    startScan();
+    scanSurvey = true;
+    surveyLastSweep = currentMillis;
+  }
+}
+#endif
+
+#if defined(ENABLE_RDS)
+/**
+ * @brief Check for and update RDS data from the radio
+ * 
+ * This function polls the RDA5807 for available RDS data and updates
+ * the internal RDS data structures. It retrieves:
+ * - Program Service (PS) name
+ * - Radio Text (RT)
+ * - Program Type (PTY)
+ * - Traffic flags
+ * - Program Identification (PI)
+ */
+void checkRDSData() {
+  // Check if RDS data is available
+  if (radio.getRDSready()) {
+    char ps[sizeof(rdsProgramService)];
+    char rt[sizeof(rdsRadioText)];
+    
+    // Get Program Service name (8 characters)
+    memset(ps, 0, sizeof(ps));
+    radio.getRDS_PS(ps);
+    if (strcmp(ps, rdsProgramService) != 0) {
+      memcpy(rdsProgramService, ps, sizeof(ps));
+      markDirty(FIELD_RDS_PS);
+      loopBusy = true;
+    }
+    
+    // Get Radio Text (up to 64 characters)
+    memset(rt, 0, sizeof(rt));
+    radio.getRDS_RT(rt);
+    if (strcmp(rt, rdsRadioText) != 0) {
+      memcpy(rdsRadioText, rt, sizeof(rt));
+      markDirty(FIELD_RDS_RT);
+      loopBusy = true;
+    }
+    
+    // Get Program Type
+    uint8_t pty = radio.getRDS_PTY();
+    // Convert PTY code to string (simplified)
+    char type[sizeof(rdsProgramType)];
+    strcpy_P(type, PSTR("PTY:"));
+    formatUnsigned(type + 4, pty);
+    
+    // Get Traffic flags and Program Identification
+    bool tp = radio.getRDS_TP();
+    bool ta = radio.getRDS_TA();
+    unsigned int pi = radio.getRDS_PI();
+    
+    // The same group is read again until the next one arrives: redraw
+    // only on a change
+    if (strcmp(type, rdsProgramType) != 0 || tp != rdsTrafficProgram ||
+        ta != rdsTrafficAnnouncement || pi != rdsPI) {
+      strcpy(rdsProgramType, type);
+      rdsTrafficProgram = tp;
+      rdsTrafficAnnouncement = ta;
+      rdsPI = pi;
+      markDirty(FIELD_RDS_INFO);
+      loopBusy = true;
+    }
+    
+#if defined(ENABLE_SURVEY)
+    // Keep the survey table up to date with the station being listened to
+    uint8_t ch = (currentFrequency - FREQ_MIN) / FREQ_STEP;
+    survey.pi[ch] = rdsPI;
+    memcpy(survey.ps[ch], rdsProgramService, sizeof(survey.ps[ch]));
+#endif
+  }
+}
+#endif
+
+/**
+ * @brief Seek up to the next valid FM station, see startSeek()
+ */
+void seekUp() {
+  startSeek(+1);
+}
+
+/**
+ * @brief Seek down to the next valid FM station, see startSeek()
+ */
+void seekDown() {
+  startSeek(-1);
+}
+
+/**
+ * @brief Start a seek
+ * 
+ * A seek supersedes any queued tuning step, scan or preview. It runs in
+ * serviceSeek(), one channel per step, so the loop (display, web server,
+ * buttons) keeps going meanwhile; any tuning input cancels it.
+ * 
+ * @param dir +1 to seek up, -1 to seek down
+ */
+void startSeek(int8_t dir) {
+  Serial.println(dir > 0 ? F("Seeking up...") : F("Seeking down..."));
+  statSeeks++;
+  if (coRunning(seekTask)) TRACE_END(TRACE_SEEK);
+  TRACE_BEGIN(TRACE_SEEK);
+  
+  tunePending = false;
+  stopPreview();
+  stopScan();
+  seekDirection = dir;
+  seekOrigin = currentFrequency;
+  coStart(seekTask);
+}
+
+/**
+ * @brief Cancel a running seek, staying on the channel it reached
+ */
+void stopSeek() {
+  if (!coRunning(seekTask)) return;
+  coStop(seekTask);
+  resetSignalHistory();
+  markDirty(FIELD_FREQUENCY | FIELD_SIGNAL);
+  TRACE_END(TRACE_SEEK);
+}
+
+/**
+ * @brief Advance the seek by at most one channel (coroutine)
+ * 
+ * 1. Steps the frequency by 100 kHz in the seek direction, wrapping
+ *    around the band edges
+ * 2. Scores the channel once it has had seekSettleDelay to settle (see
+ *    measureQuality()); noise and images of strong stations score low
+ *    even when their RSSI is high
+ * 3. Stops on the first channel scoring at least qualityStation; with
+ *    RDS, gives it up to qualityRdsWindow to sync, for its cached score
+ * 4. After a full turn around the band without a station, returns to
+ *    the original frequency
+ */
+void serviceSeek() {
+  CO_BEGIN(seekTask);
+  for (seekSteps = 0; seekSteps < BAND_CHANNELS; seekSteps++) {
+    if (seekDirection > 0) {
+      currentFrequency = currentFrequency == FREQ_MAX ? FREQ_MIN : currentFrequency + FREQ_STEP;
+    } else {
+      currentFrequency = currentFrequency == FREQ_MIN ? FREQ_MAX : currentFrequency - FREQ_STEP;
+    }
+    tunerSetFrequency(currentFrequency);
+    markDirty(FIELD_FREQUENCY);
+    CO_AWAIT_MS(seekTask, seekSettleDelay);
+    loopBusy = true;
+    
+    seekRssi = radio.getRssi();
+    if (measureQuality(seekRssi, QUALITY_NO_RDS) >= qualityStation) {
+#if defined(ENABLE_RDS)
+      // seekTask.since is still the time the channel was tuned
+      CO_AWAIT_UNTIL(seekTask, radio.getRdsSync() || millis() - seekTask.since >= qualityRdsWindow);
+      cacheQuality((currentFrequency - FREQ_MIN) / FREQ_STEP,
+                   measureQuality(seekRssi, radio.getRdsSync() ? (long)(millis() - seekTask.since) : QUALITY_NO_RDS));
+#else
+      cacheQuality((currentFrequency - FREQ_MIN) / FREQ_STEP, measureQuality(seekRssi, QUALITY_NO_RDS));
+#endif
+      Serial.print(F("Found station at "));
+      printFrequency(Serial, currentFrequency);
+      Serial.print(F(" MHz with RSSI "));
+      Serial.println(seekRssi);
+      resetSignalHistory();
+      markDirty(FIELD_FREQUENCY | FIELD_SIGNAL);
+      TRACE_END(TRACE_SEEK);
+      CO_EXIT(seekTask);
+    }
+    
+    // Full circle: no station on the band
+    if (currentFrequency == seekOrigin) {
+      Serial.print(F("No stations found during seek "));
+      Serial.println(seekDirection > 0 ? F("up") : F("down"));
+      break;
+    }
+  }
+  
+  // If no station found, restore original frequency
+  currentFrequency = seekOrigin;
+  tunerSetFrequency(currentFrequency);
+  resetSignalHistory();
+  markDirty(FIELD_FREQUENCY | FIELD_SIGNAL);
+  TRACE_END(TRACE_SEEK);
+  CO_END(seekTask);
+}
+
+#if defined(ENABLE_BENCHMARK)
+// Runs of each benchmark operation
+const uint16_t BENCH_FRAMES = 50;
+const uint16_t BENCH_PAGES = 20;
+const uint16_t BENCH_FORMATS = 1000;
+const uint16_t BENCH_TUNES = 20;
+const uint16_t BENCH_RDS_POLLS = 100;
+
+/**
+ * @brief Run the benchmark suite and print the results (see benchmark.h)
+ * 
+ * - render: full redraw, cycling through all display pages
+ * - main: main page with a new frequency in each frame
+ * - root, status: build the main web page and the /api/status JSON
+ * - format: frequency, RSSI, volume and PI to text
+ * - tune: retune to the next channel and back, every other run
+ * - rds: one RDS poll of the tuner
+ * 
+ * The radio state is restored afterwards.
+ */
+void runBenchmark() {
+  DisplayPage page = displayPage;
+  uint16_t frequency = currentFrequency;
+  
+  benchmarkSections();
+  benchmarkRun(F("render"), BENCH_FRAMES, [](uint16_t i) {
+    displayPage = (DisplayPage)(i % PAGE_COUNT);
+    updateDisplay();
+  });
+  benchmarkRun(F("main"), BENCH_FRAMES, [](uint16_t i) {
+    displayPage = PAGE_MAIN;
+    currentFrequency = FREQ_MIN + (i % BAND_CHANNELS) * FREQ_STEP;
+    updateDisplay();
+  });
+  currentFrequency = frequency;
+#if BOARD_HAS_WIFI
+  benchmarkRun(F("root"), BENCH_PAGES, [](uint16_t i) {
+    RESPONSE_BUFFER(html);
+    rootPage(html);
+  });
+  benchmarkRun(F("status"), BENCH_PAGES, [](uint16_t i) {
+    RESPONSE_BUFFER(json);
+    statusJson(json);
+  });
+#endif
+  benchmarkRun(F("format"), BENCH_FORMATS, [](uint16_t i) {
+    char buf[FORMAT_UNSIGNED_SIZE];
+    formatFrequency(buf, FREQ_MIN + i);
+    formatUnsigned(buf, i & 0x7F);
+    formatUnsigned(buf, i & 0x0F);
+    formatHex4(buf, i);
+  });
+  benchmarkRun(F("tune"), BENCH_TUNES, [](uint16_t i) {
+    uint16_t next = currentFrequency < FREQ_MAX ? currentFrequency + FREQ_STEP : FREQ_MIN;
+    tunerSetFrequency(i & 1 ? currentFrequency : next);
+  });
+#if defined(ENABLE_RDS)
+  benchmarkRun(F("rds"), BENCH_RDS_POLLS, [](uint16_t i) {
+    checkRDSData();
+  });
+#endif
+  benchmarkDone();
+  
+  displayPage = page;
+  tunerSetFrequency(currentFrequency);
+  updateDisplay();
+}
+#endif
+
+#if BOARD_HAS_WIFI
+/**
+ * @brief Handle root web page request
+ * 
+ * Sends the main web interface page, see rootPage().
+ */
+void handleRoot() {
+  loopBusy = true;
+  RESPONSE_BUFFER(html);
+  rootPage(html);
+  server.send(200, "text/html", html);
+}
+
+/**
+ * @brief Build the main web interface page
+ * 
+ * The page displays the current radio status and provides control
+ * buttons:
+ * - Current frequency in MHz
+ * - Radio status (ON/OFF)
+ * - Volume level
+ * - Control buttons for UP, DOWN, and TOGGLE functions
+ * 
+ * @param html Response to append the HTML document to
+ */
+void rootPage(String &html) {
+  html += F("<!DOCTYPE html><html>");
+  html += F("<head><title>FM Radio Control</title>");
+  html += F("<meta name='viewport' content='width=device-width, initial-scale=1'>");
+  html += F("<style>");
+  html += F("body { font-family: Arial, sans-serif; text-align: center; margin: 20px; }");
+  html += F("button { font-size: 24px; padding: 15px; margin: 10px; width: 200px; }");
+  html += F(".freq { font-size: 36px; margin: 20px; }");
+  html += F(".status { font-size: 24px; margin: 20px; }");
+  html += F("polyline { fill: none; stroke: #06c; stroke-width: 2; }");
+  html += F("</style></head>");
+  html += F("<body>");
+  html += F("<h1>FM Radio Control</h1>");
+  char freqStr[FORMAT_FREQUENCY_SIZE];
+  formatFrequency(freqStr, currentFrequency);
+  html += F("<div class='freq'>");
+  html += freqStr;
+  html += F(" MHz</div><div class='status'>Status: ");
+  html += radioOn ? F("ON") : F("OFF");
+  html += F("</div><div class='status'>Volume: ");
+  html += volume;
+  html += F("</div><div class='status'>Signal: <span id='rssi'>");
+  html += signalCount ? signalHistory[(signalHead + SIGNAL_HISTORY - 1) % SIGNAL_HISTORY].rssi : 0;
+  html += F("</span> dBuV<br><svg width='192' height='48' viewBox='0 0 ");
+  html += SIGNAL_HISTORY - 1;
+  html += F(" 64' preserveAspectRatio='none'><polyline id='spark' points='");
+  signalSparkline(html);
+  html += F("'/></svg></div>");
+  
+#if defined(ENABLE_RDS)
+  // Add RDS information if available
+  if (strlen(rdsProgramService) > 0) {
+    html += F("<div class='status'>Station: ");
+    html += rdsProgramService;
+    html += F("</div>");
+  }
+  if (strlen(rdsProgramType) > 0) {
+    html += F("<div class='status'>Type: ");
+    html += rdsProgramType;
+    html += F("</div>");
+  }
+  if (strlen(rdsRadioText) > 0) {
+    html += F("<div class='status'>Info: ");
+    html += rdsRadioText;
+    html += F("</div>");
+  }
+#endif
+  
+  html += F("<button onclick='location.href=\"/up\"'>UP (+0.1)</button><br>");
+  html += F("<button onclick='location.href=\"/seekup\"'>SEEK UP</button><br>");
+  html += F("<button onclick='location.href=\"/down\"'>DOWN (-0.1)</button><br>");
+  html += F("<button onclick='location.href=\"/seekdown\"'>SEEK DOWN</button><br>");
+  html += F("<button onclick='location.href=\"/toggle\"'>TOGGLE</button><br>");
+  html += F("<button onclick='location.href=\"/scan\"'>SCAN BAND</button><br>");
+  html += previewActive ? F("<button onclick='location.href=\"/preview?stop=1\"'>STOP PREVIEW</button><br>")
+                        : F("<button onclick='location.href=\"/preview\"'>PREVIEW</button><br>");
+  // Refresh the signal sparkline from /api/status
+  html += F("<script>setInterval(function(){fetch('/api/status').then(function(r){return r.json();}).then(function(s){");
+  html += F("document.getElementById('rssi').textContent=s.rssi;");
+  html += F("var p='';s.history.forEach(function(v,i){p+=i+','+(64-Math.min(v,64))+' ';});");
+  html += F("document.getElementById('spark').setAttribute('points',p);});},2000);</script>");
+  html += F("</body></html>");
+}
+
+/**
+ * @brief Build the sparkline points of the signal history
+ * 
+ * Oldest sample first, one SVG polyline point per sample, with RSSI
+ * values up to 64 dBuV mapped onto a 64 unit high view box.
+ * 
+ * @param points String to append the space separated "x,y" points to
+ */
+void signalSparkline(String &points) {
+  uint8_t start = (signalHead + SIGNAL_HISTORY - signalCount) % SIGNAL_HISTORY;
+  for (uint8_t i = 0; i < signalCount; i++) {
+    uint8_t rssi = signalHistory[(start + i) % SIGNAL_HISTORY].rssi;
+    points += i;
+    points += ',';
+    points += 64 - (rssi > 64 ? 64 : rssi);
+    points += ' ';
+  }
+}
+
+/**
+ * @brief Append a string to a JSON document as a quoted, escaped value
+ * 
+ * @param json Document being built
+ * @param str String to append
+ */
+void jsonAppendString(String &json, const char *str) {
+  json += '"';
+  for (; *str; str++) {
+    char c = *str;
+    if (c == '"' || c == '\\') {
+      json += '\\';
+      json += c;
+    } else if ((uint8_t)c < 0x20) {
+      json += ' ';
+    } else {
+      json += c;
+    }
+  }
+  json += '"';
+}
+
+/**
+ * @brief Append a boolean to a JSON document
+ */
+void jsonAppendBool(String &json, bool value) {
+  json += value ? F("true") : F("false");
+}
+
+/**
+ * @brief Get a query argument as a number, 0 if missing or not a number
+ *
+ * server.arg() hands out a String copy on ESP32. A number fits in the
+ * inline buffer of a String (11 characters), so the copy does not
+ * allocate; only a value too long to be a number would.
+ */
+long webArgNumber(const char *name) {
+  return server.arg(name).toInt();
+}
+
+/**
+ * @brief Check a query argument against a short keyword, see
+ * webArgNumber() for the copy
+ */
+bool webArgIs(const char *name, const char *value) {
+  return server.arg(name) == value;
+}
+
+/**
+ * @brief Handle status API request
+ * 
+ * Sends the radio state as JSON, see statusJson().
+ */
+void handleApiStatus() {
+  loopBusy = true;
+  RESPONSE_BUFFER(json);
+  statusJson(json);
+  server.send(200, "application/json", json);
+}
+
+/**
+ * @brief Build the radio state as JSON
+ * 
+ * Frequency, power, volume, the latest signal sample (RSSI, stereo,
+ * FM-true), the RSSI history of the current station (oldest first) and,
+ * with RDS enabled, the decoded RDS data.
+ * 
+ * @param json Response to append the JSON document to
+ */
+void statusJson(String &json) {
+  SignalSample last = {0, 0};
+  if (signalCount) last = signalHistory[(signalHead + SIGNAL_HISTORY - 1) % SIGNAL_HISTORY];
+  
+  char freqStr[FORMAT_FREQUENCY_SIZE];
+  formatFrequency(freqStr, currentFrequency);
+  json += F("{\"frequency\":");
+  json += freqStr;
+  json += F(",\"on\":");
+  jsonAppendBool(json, radioOn);
+  json += F(",\"volume\":");
+  json += volume;
+  json += F(",\"rssi\":");
+  json += last.rssi;
+  json += F(",\"stereo\":");
+  jsonAppendBool(json, last.flags & SIGNAL_FLAG_STEREO);
+  json += F(",\"fmTrue\":");
+  jsonAppendBool(json, last.flags & SIGNAL_FLAG_FMTRUE);
+  json += F(",\"quality\":");
+  json += channelQuality((currentFrequency - FREQ_MIN) / FREQ_STEP);
+  json += F(",\"history\":[");
+  uint8_t start = (signalHead + SIGNAL_HISTORY - signalCount) % SIGNAL_HISTORY;
+  for (uint8_t i = 0; i < signalCount; i++) {
+    if (i) json += ',';
+    json += signalHistory[(start + i) % SIGNAL_HISTORY].rssi;
+  }
+  json += ']';
+  json += F(",\"preview\":{\"active\":");
+  jsonAppendBool(json, previewActive);
+  json += F(",\"dwell\":");
+  json += previewDwell / 1000;
+  json += F(",\"hops\":");
+  json += statHops;
+  json += F(",\"retuneUs\":");
+  json += previewRetuneMicros;
+  json += F(",\"rdsResetUs\":");
+  json += previewRdsResetMicros;
+  json += F(",\"retuneTotalUs\":");
+  json += previewRetuneTotal;
+  json += F(",\"rdsResetTotalUs\":");
+  json += previewRdsResetTotal;
+  json += '}';
+#if defined(ENABLE_RDS)
+  json += F(",\"rds\":{\"ps\":");
+  jsonAppendString(json, rdsProgramService);
+  json += F(",\"rt\":");
+  jsonAppendString(json, rdsRadioText);
+  json += F(",\"pty\":");
+  jsonAppendString(json, rdsProgramType);
+  json += F(",\"pi\":");
+  json += rdsPI;
+  json += F(",\"tp\":");
+  jsonAppendBool(json, rdsTrafficProgram);
+  json += F(",\"ta\":");
+  jsonAppendBool(json, rdsTrafficAnnouncement);
+  json += '}';
+#endif
+  json += '}';
+}
+
+/**
+ * @brief Handle band scan request from web interface
+ * 
+ * Starts a full band scan pass (muting the audio while it runs) to refresh
+ * the spectrum view, and redirects back to the main page.
+ */
+void handleScan() {
+  stopPreview();
+  startScan();
+  server.sendHeader("Location", "/");
+  server.send(303);
+}
+
+#if defined(ENABLE_HISTORY)
+/**
+ * @brief Handle history download request
+ * 
+ * Streams one segment of the history log per request, as chunked output,
+ * so a download never holds the loop for more than a segment:
+ * - ?segment=N: segment N, the oldest one without it; the X-Next-Segment
+ *   header names the segment to ask for next and is missing on the
+ *   newest (the range is also in the history object of /api/diag)
+ * - ?format=raw: the segment file as stored (see history.h)
+ * - otherwise CSV, one line per record:
+ *   boot,time,type,frequency,rssi,min,max,count,flags,scan
+ *   where scan holds the 206 channel RSSI values of a band scan,
+ *   separated by spaces
+ * 
+ * Records still batched in RAM (up to 30 s) are not included.
+ */
+void handleApiHistory() {
+  loopBusy = true;
+  bool raw = webArgIs("format", "raw");
+  uint32_t seq = server.hasArg("segment") ? (uint32_t)webArgNumber("segment") : historyFirstSegment();
+  if (seq < historyFirstSegment() || seq >= historyEndSegment()) {
+    server.send(404, "text/plain", "No such segment\n");
+    return;
+  }
+  char line[96];
+  if (seq + 1 < historyEndSegment()) {
+    formatUnsigned(line, seq + 1);
+    server.sendHeader("X-Next-Segment", line);
+  }
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, raw ? "application/octet-stream" : "text/csv", "");
+  
+  if (raw) {
+    File f = historyOpenSegment(seq);
+    if (f) {
+      size_t n;
+      while ((n = f.read((uint8_t *)line, sizeof(line))) > 0) {
+        server.sendContent(line, n);
+      }
+      f.close();
+    }
+    server.sendContent("");
+    return;
+  }
+  
+  server.sendContent_P(PSTR("boot,time,type,frequency,rssi,min,max,count,flags,scan\n"));
+  static HistoryRecord rec;
+  HistoryReader reader;
+  if (reader.open(seq)) {
+    while (reader.next(rec)) {
+      int len = 0;
+      if (rec.type == HIST_REC_SAMPLE) {
+        len = snprintf_P(line, sizeof(line), PSTR("%u,%lu,sample,%u.%02u,%u,,,,%u,\n"),
+                       rec.boot, (unsigned long)rec.time, rec.frequency / 100, rec.frequency % 100,
+                       rec.rssi, rec.flags);
+      } else if (rec.type == HIST_REC_ROLLUP) {
+        len = snprintf_P(line, sizeof(line), PSTR("%u,%lu,rollup,%u.%02u,%u,%u,%u,%u,,\n"),
+                       rec.boot, (unsigned long)rec.time, rec.frequency / 100, rec.frequency % 100,
+                       rec.rssi, rec.rssiMin, rec.rssiMax, rec.count);
+      } else if (rec.type == HIST_REC_SCAN) {
+        len = snprintf_P(line, sizeof(line), PSTR("%u,%lu,scan,,,,,,,"), rec.boot, (unsigned long)rec.time);
+        for (uint8_t ch = 0; ch < HIST_SCAN_CHANNELS; ch++) {
+          if (len > (int)sizeof(line) - 6) {
+            server.sendContent(line, len);
+            len = 0;
+          }
+          len += snprintf_P(line + len, sizeof(line) - len, ch ? PSTR(" %u") : PSTR("%u"), rec.scan[ch]);
+        }
+        line[len++] = '\n';
+      }
+      if (len > 0) server.sendContent(line, len);
+    }
+    reader.close();
+  }
+  server.sendContent("");
+}
+#endif
+
+/**
+ * @brief Append one Prometheus gauge line to a metrics response
+ * 
+ * @param name Metric name without the prefix, in flash
+ * @param label Optional label set, in RAM
+ * @param value Gauge value
+ */
+void metricsLine(PGM_P name, const char *label, unsigned long value) {
+  char line[80];
+  strcpy_P(line, PSTR("fmradio_"));
+  strncpy_P(line + 8, name, 48);
+  line[56] = '\0';
+  size_t len = strlen(line);
+  if (label) len += snprintf_P(line + len, sizeof(line) - len, PSTR("{%s}"), label);
+  len += snprintf_P(line + len, sizeof(line) - len, PSTR(" %lu\n"), value);
+  server.sendContent(line, len);
+}
+
+/**
+ * @brief Handle metrics request
+ * 
+ * Serves heap, stack and activity counters in the Prometheus text
+ * format, streamed line by line so that watching the heap does not
+ * itself churn it.
+ */
+void handleMetrics() {
+  loopBusy = true;
+  memstatsSample();
+  const MemStats &mem = memstats();
+  
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "text/plain; version=0.0.4", "");
+  metricsLine(PSTR("uptime_seconds"), NULL, millis() / 1000);
+  metricsLine(PSTR("heap_free_bytes"), NULL, mem.heapFree);
+  metricsLine(PSTR("heap_min_free_bytes"), NULL, mem.heapMinFree);
+  metricsLine(PSTR("heap_largest_block_bytes"), NULL, mem.largestBlock);
+  metricsLine(PSTR("heap_fragmentation_percent"), NULL, mem.fragmentation);
+  metricsLine(PSTR("heap_fragmentation_max_percent"), NULL, mem.maxFragmentation);
+  metricsLine(PSTR("heap_fragmentation_alarms_total"), NULL, mem.alarms);
+  metricsLine(PSTR("heap_fragmentation_last_alarm_seconds"), NULL, mem.lastAlarm / 1000);
+#if defined(ESP32)
+  const MemTaskStack *tasks = memstatsTasks();
+  for (uint8_t i = 0; i < MEM_TASKS; i++) {
+    char label[24];
+    snprintf_P(label, sizeof(label), PSTR("task=\"%s\""), tasks[i].name);
+    metricsLine(PSTR("stack_free_bytes"), label, tasks[i].free);
+  }
+#else
+  metricsLine(PSTR("stack_free_bytes"), "task=\"loop\"", mem.stackFree);
+#endif
+  const TunerBusStats &bus = tunerBusStats();
+  metricsLine(PSTR("i2c_errors_total"), NULL, bus.errors);
+  metricsLine(PSTR("i2c_retries_total"), NULL, bus.retries);
+  metricsLine(PSTR("i2c_failures_total"), NULL, bus.failures);
+  metricsLine(PSTR("i2c_recoveries_total"), NULL, bus.recoveries);
+  metricsLine(PSTR("i2c_recovery_microseconds_total"), NULL, bus.recoveryMicros);
+  metricsLine(PSTR("latency_input_max_microseconds"), NULL, latencyInput.max);
+  metricsLine(PSTR("latency_input_microseconds_total"), NULL, latencyInput.total);
+  metricsLine(PSTR("latency_input_count"), NULL, latencyInput.count);
+  metricsLine(PSTR("latency_request_max_microseconds"), NULL, latencyRequest.max);
+  metricsLine(PSTR("latency_request_microseconds_total"), NULL, latencyRequest.total);
+  metricsLine(PSTR("latency_request_count"), NULL, latencyRequest.count);
+  metricsLine(PSTR("latency_loop_max_microseconds"), NULL, latencyLoop.max);
+  metricsLine(PSTR("retunes_total"), NULL, statRetunes);
+  metricsLine(PSTR("seeks_total"), NULL, statSeeks);
+  metricsLine(PSTR("scans_total"), NULL, statScans);
+  metricsLine(PSTR("preview_hops_total"), NULL, statHops);
+  metricsLine(PSTR("renders_total"), NULL, statRenders);
+#if defined(DISPLAY_DMA)
+  if (displayDma) {
+    const DisplayDmaStats &dma = displayDmaStats();
+    metricsLine(PSTR("display_dma_frames_total"), NULL, dma.frames);
+    metricsLine(PSTR("display_dma_waits_total"), NULL, dma.waits);
+    metricsLine(PSTR("display_dma_wait_microseconds_total"), NULL, dma.waitMicros);
+    metricsLine(PSTR("display_dma_transfer_microseconds"), NULL, dma.transferMicros);
+  }
+#endif
+#if defined(ENABLE_ENCODER)
+  metricsLine(PSTR("input_event_overflows_total"), NULL, inputEvents.overflows());
+#endif
+#if defined(ENABLE_STATIC_ALLOC)
+  const HeapGuardStats &heap = heapguardStats();
+  for (uint8_t i = 0; i < WD_SECTIONS; i++) {
+    char label[24];
+    strcpy_P(label, PSTR("section=\""));
+    strncpy_P(label + 9, (PGM_P)watchdogSectionName(i), 12);
+    label[21] = '\0';
+    strcat(label, "\"");
+    metricsLine(PSTR("heap_allocations_total"), label, heap.sections[i]);
+  }
+#endif
+  server.sendContent("");
+}
+
+/**
+ * @brief Append a latency statistic to a JSON response, in us
+ */
+void latencyJson(String &json, const LatencyStat &stat) {
+  json += F("{\"count\":");
+  json += stat.count;
+  json += F(",\"last\":");
+  json += stat.last;
+  json += F(",\"mean\":");
+  json += stat.count ? stat.total / stat.count : 0;
+  json += F(",\"max\":");
+  json += stat.max;
+  json += '}';
+}
+
+/**
+ * @brief Handle diagnostics request
+ * 
+ * Reports the boot number, the loop section running and the loop stalls
+ * on record, including those from before the last reset.
+ */
+void handleApiDiag() {
+  loopBusy = true;
+  StallRecord records[WD_RECORDS];
+  uint8_t count = watchdogRecords(records);
+  
+  RESPONSE_BUFFER(json);
+  json += F("{\"boot\":");
+  json += watchdogBoot();
+  json += F(",\"section\":\"");
+  json += watchdogSectionName(watchdogSection());
+  json += F("\",\"stallThreshold\":");
+  json += WD_STALL_THRESHOLD;
+  json += F(",\"stalls\":[");
+  for (uint8_t i = 0; i < count; i++) {
+    if (i) json += ',';
+    json += F("{\"section\":\"");
+    json += watchdogSectionName(records[i].section);
+    json += F("\",\"boot\":");
+    json += records[i].boot;
+    json += F(",\"start\":");
+    json += records[i].start;
+    json += F(",\"duration\":");
+    json += records[i].duration;
+    json += F(",\"open\":");
+    jsonAppendBool(json, records[i].flags & WD_STALL_OPEN);
+    json += F(",\"reset\":");
+    jsonAppendBool(json, records[i].flags & WD_STALL_RESET);
+    json += '}';
+  }
+  json += ']';
+  const TunerBusStats &bus = tunerBusStats();
+  json += F(",\"i2c\":{\"errors\":");
+  json += bus.errors;
+  json += F(",\"retries\":");
+  json += bus.retries;
+  json += F(",\"failures\":");
+  json += bus.failures;
+  json += F(",\"recoveries\":");
+  json += bus.recoveries;
+  json += F(",\"recoveryUs\":");
+  json += bus.recoveryMicros;
+  json += F(",\"recoveryMaxUs\":");
+  json += bus.recoveryMaxMicros;
+  json += F(",\"lastError\":");
+  json += bus.lastError;
+  json += '}';
+  json += F(",\"latency\":{\"input\":");
+  latencyJson(json, latencyInput);
+  json += F(",\"request\":");
+  latencyJson(json, latencyRequest);
+  json += F(",\"loop\":");
+  latencyJson(json, latencyLoop);
+  json += '}';
+#if defined(ENABLE_STATIC_ALLOC)
+  const HeapGuardStats &heap = heapguardStats();
+  json += F(",\"heap\":{\"allocations\":");
+  json += heap.total;
+  if (heap.total) {
+    json += F(",\"lastSection\":\"");
+    json += watchdogSectionName(heap.lastSection);
+    json += F("\",\"lastSize\":");
+    json += (unsigned long)heap.lastSize;
+  }
+  json += F(",\"sections\":{");
+  bool first = true;
+  for (uint8_t i = 0; i < WD_SECTIONS; i++) {
+    if (!heap.sections[i]) continue;
+    if (!first) json += ',';
+    first = false;
+    json += '"';
+    json += watchdogSectionName(i);
+    json += F("\":");
+    json += heap.sections[i];
+  }
+  json += F("}}");
+#endif
+#if defined(ENABLE_HISTORY)
+  const HistoryStats &hist = historyStats();
+  json += F(",\"history\":{\"first\":");
+  json += historyFirstSegment();
+  json += F(",\"end\":");
+  json += historyEndSegment();
+  json += F(",\"records\":");
+  json += hist.records;
+  json += F(",\"dropped\":");
+  json += hist.dropped;
+  json += F(",\"bytesWritten\":");
+  json += hist.bytesWritten;
+  json += F(",\"compactions\":");
+  json += hist.compactions;
+  json += '}';
+#endif
+  json += '}';
+  server.send(200, "application/json", json);
+}
+
+#if defined(ENABLE_TRACE)
+/**
+ * @brief Handle trace request
+ * 
+ * Streams the trace ring as Chrome trace JSON, one event per chunk.
+ * Recording is paused meanwhile so the ring does not move under the
+ * dump; the dump itself shows up as a long "web" section in the next one.
+ */
+void handleApiTrace() {
+  loopBusy = true;
+  traceFreeze(true);
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "application/json", "");
+  server.sendContent_P(TRACE_JSON_HEAD);
+  char buf[TRACE_JSON_EVENT];
+  uint16_t count = traceCount();
+  for (uint16_t i = 0; i < count; i++) {
+    server.sendContent(buf, traceFormat(i, buf, sizeof(buf)));
+  }
+  server.sendContent_P(TRACE_JSON_TAIL);
+  server.sendContent("");
+  traceFreeze(false);
+}
+#endif
+
+/**
+ * @brief Handle scan-and-preview request
+ * 
+ * Starts the preview, with dwell=<seconds> setting the time on each
+ * station; stop=1 stops it on the current station.
+ */
+void handlePreview() {
+  if (server.hasArg("stop")) {
+    stopPreview();
+  } else {
+    if (server.hasArg("dwell")) {
+      long seconds = webArgNumber("dwell");
+      if (seconds >= 1 && seconds <= 600) previewDwell = seconds * 1000UL;
+    }
+    startPreview();
+  }
+  server.sendHeader("Location", "/");
+  server.send(303);
+}
+
+#if defined(ENABLE_SURVEY)
+/**
+ * @brief Handle band survey request
+ * 
+ * Commands, as query arguments:
+ * - start=1: start the survey, optionally with interval=<seconds>
+ * - stop=1: stop scheduling sweeps (the statistics are kept)
+ * - reset=1: clear the statistics
+ * 
+ * Always answers with the survey state and, per channel, the RSSI
+ * minimum, maximum and mean, the occupancy percentage and the RDS PI/PS
+ * when known. The 206 channel list is streamed about a kilobyte at a
+ * time, so the whole response is never held in memory.
+ */
+void handleApiSurvey() {
+  loopBusy = true;
+  if (server.hasArg("reset")) surveyReset();
+  if (server.hasArg("stop")) {
+    surveyRunning = false;
+    stopScan();
+  }
+  if (server.hasArg("start")) {
+    if (server.hasArg("interval")) {
+      long seconds = webArgNumber("interval");
+      if (seconds >= 10) surveyInterval = seconds * 1000UL;
+    }
+    if (!surveyRunning && surveySweeps == 0) surveyReset();
+    surveyRunning = true;
+  }
+  
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "application/json", "");
+  // Rows are gathered and sent about a kilobyte at a time: one chunk per
+  // row would cost a TCP write each
+  const size_t SURVEY_CHUNK = 1024;
+  RESPONSE_BUFFER(json);
+  json.reserve(SURVEY_CHUNK + 128);
+  char buf[112];
+  snprintf_P(buf, sizeof(buf), PSTR("{\"running\":%s,\"interval\":%lu,\"sweeps\":%u,\"channels\":["),
+             surveyRunning ? "true" : "false", surveyInterval / 1000, surveySweeps);
+  json += buf;
+  for (uint8_t ch = 0; ch < BAND_CHANNELS; ch++) {
+    uint16_t freq = FREQ_MIN + ch * FREQ_STEP;
+    uint8_t mean = surveySweeps ? survey.rssiSum[ch] / surveySweeps : 0;
+    uint8_t occupancy = surveySweeps ? (uint32_t)survey.occupied[ch] * 100 / surveySweeps : 0;
+    int len = snprintf_P(buf, sizeof(buf),
+                         PSTR("%s{\"f\":%u.%u,\"min\":%u,\"max\":%u,\"mean\":%u,\"occ\":%u"),
+                         ch ? "," : "", freq / 100, (freq % 100) / 10,
+                         surveySweeps ? survey.rssiMin[ch] : 0, survey.rssiMax[ch], mean, occupancy);
+    if (survey.pi[ch]) {
+      snprintf_P(buf + len, sizeof(buf) - len, PSTR(",\"pi\":\"%04X\""), survey.pi[ch]);
+    }
+    json += buf;
+    if (survey.ps[ch][0]) {
+      json += F(",\"ps\":");
+      jsonAppendString(json, survey.ps[ch]);
+    }
+    json += '}';
+    if (json.length() >= SURVEY_CHUNK) {
+      server.sendContent(json);
+      json = "";
+    }
+  }
+  json += F("]}");
+  server.sendContent(json);
+  server.sendContent("");
+}
+#endif
+
+#if defined(ENABLE_RDS_CAPTURE)
+/**
+ * @brief Handle RDS capture request
+ * 
+ * Commands, as query arguments:
+ * - start=1: start a new capture on the tuned station
+ * - stop=1: stop recording (the capture is kept)
+ * 
+ * With format=raw, streams the capture in the binary format described
+ * in rdscapture.h, recording being paused meanwhile; otherwise answers
+ * with the capture state.
+ */
+void handleApiRdsCapture() {
+  loopBusy = true;
+  if (server.hasArg("stop")) rdsCaptureStop();
+  if (server.hasArg("start")) rdsCaptureStart(currentFrequency, millis());
+  
+  const RdsCaptureHeader &header = rdsCaptureHeader();
+  if (webArgIs("format", "raw")) {
+    rdsCaptureFreeze(true);
+    server.setContentLength(sizeof(header) + (size_t)header.records * sizeof(RdsCaptureRecord));
+    server.send(200, "application/octet-stream", "");
+    server.sendContent((const char *)&header, sizeof(header));
+    // Records go out in batches, the ring wraps between them
+    RdsCaptureRecord batch[16];
+    for (uint16_t i = 0; i < header.records; ) {
+      uint8_t n = 0;
+      while (n < 16 && i < header.records) batch[n++] = rdsCaptureGet(i++);
+      server.sendContent((const char *)batch, n * sizeof(RdsCaptureRecord));
+    }
+    rdsCaptureFreeze(false);
+    return;
+  }
+  
+  char buf[112];
+  snprintf_P(buf, sizeof(buf), PSTR("{\"running\":%s,\"frequency\":%u.%u,\"records\":%u,\"dropped\":%u}"),
+           rdsCaptureRunning() ? "true" : "false", header.frequency / 100, (header.frequency % 100) / 10,
+           header.records, header.dropped);
+  RESPONSE_BUFFER(json);
+  json += buf;
+  server.send(200, "application/json", json);
+}
+#endif
+
+/**
+ * @brief Handle frequency increase request from web interface
+ * 
+ * Queues a 0.1 MHz frequency increase (wrapping from 108.0 MHz
+ * to 87.5 MHz) and redirects back to the main page. The tuner and
+ * display are updated by serviceTuning() in the main loop.
+ */
+void handleUp() {
+  noteInput();
+  tuneStep(FREQ_STEP);
+  server.sendHeader("Location", "/");
+  server.send(303);
+}
+
+/**
+ * @brief Handle frequency decrease request from web interface
+ * 
+ * Queues a 0.1 MHz frequency decrease (wrapping from 87.5 MHz
+ * to 108.0 MHz) and redirects back to the main page. The tuner and
+ * display are updated by serviceTuning() in the main loop.
+ */
+void handleDown() {
+  noteInput();
+  tuneStep(-FREQ_STEP);
+  server.sendHeader("Location", "/");
+  server.send(303);
+}
+
+/**
+ * @brief Handle station seek up request from web interface
+ * 
+ * Seeks up to the next valid FM station using RSSI detection,
+ * updates the radio module, refreshes the display, and 
  * redirects back to the main page.
  */
 void handleSeekUp() {
+  noteInput();
   seekUp();
   server.sendHeader("Location", "/");
   server.send(303);
@@ -672,6 +3091,7 @@ void handleSeekUp() {
  * redirects back to the main page.
  */
 void handleSeekDown() {
+  noteInput();
   seekDown();
   server.sendHeader("Location", "/");
   server.send(303);
@@ -680,20 +3100,12 @@ void handleSeekDown() {
 /**
  * @brief Handle radio power toggle request from web interface
  * 
- * Toggles the radio power state between ON and OFF.
- * When turning ON, unmutes the radio and sets the current frequency.
- * When turning OFF, mutes the radio.
- * Updates the display and redirects back to the main page.
+ * Toggles the radio power state between ON and OFF (see togglePower())
+ * and redirects back to the main page.
  */
 void handleToggle() {
-  radioOn = !radioOn;
-  if (radioOn) {
-    radio.setFrequency(currentFrequency);
-    radio.setMute(false);
-  } else {
-    radio.setMute(true);
-  }
-  updateDisplay();
+  noteInput();
+  togglePower();
   server.sendHeader("Location", "/");
   server.send(303);
 }
@@ -0,0 +1,171 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <Arduino.h>
+
+#include "memstats.h"
+
+MemStats memStats = {0, 0xFFFFFFFFUL, 0, 0, 0, 0, 0, 0};
+bool memFragAlarmArmed = true;
+
+#if defined(__AVR__)
+// Byte painted over the free RAM at boot
+const uint8_t MEM_CANARY = 0xA5;
+
+// Linker and avr-libc malloc symbols
+extern uint8_t _end;
+extern char __heap_start;
+extern char *__brkval;
+struct __freelist {
+  size_t sz;
+  struct __freelist *nx;
+};
+extern struct __freelist *__flp;
+
+/**
+ * @brief Paint the RAM above .bss with the canary byte
+ *
+ * Runs from .init3, after the stack pointer and the zero register are
+ * set up and before any C++ constructor or main(), while the stack is
+ * still empty.
+ */
+void memstatsPaint() __attribute__((naked, used, section(".init3")));
+void memstatsPaint() {
+  uint8_t *p = &_end;
+  while (p < (uint8_t *)SP) *p++ = MEM_CANARY;
+}
+
+/**
+ * @brief Measure the AVR heap and the unused stack
+ */
+void memstatsMeasure() {
+  uint8_t stackMarker;        // Lives at the current top of the stack
+  uint8_t *stackTop = &stackMarker;
+  uint8_t *heapTop = (uint8_t *)(__brkval ? __brkval : &__heap_start);
+  uint32_t gap = stackTop > heapTop ? stackTop - heapTop : 0;
+
+  // Blocks freed below the top of the heap can only be reused by
+  // allocations that fit in them
+  uint32_t total = gap;
+  uint32_t largest = gap;
+  for (struct __freelist *fl = __flp; fl; fl = fl->nx) {
+    total += fl->sz;
+    if (fl->sz > largest) largest = fl->sz;
+  }
+  memStats.heapFree = total;
+  memStats.largestBlock = largest;
+
+  // Canary bytes still untouched above the heap were never reached by
+  // the stack
+  uint32_t untouched = 0;
+  for (uint8_t *p = heapTop; p < stackTop && *p == MEM_CANARY; p++) untouched++;
+  memStats.stackFree = untouched;
+}
+
+#elif defined(ESP8266)
+/**
+ * @brief Measure the ESP8266 heap and the loop stack
+ */
+void memstatsMeasure() {
+  memStats.heapFree = ESP.getFreeHeap();
+  memStats.largestBlock = ESP.getMaxFreeBlockSize();
+  memStats.stackFree = ESP.getFreeContStack();
+}
+
+#elif defined(ESP32)
+// Tasks whose stacks are watched, the loop task first
+MemTaskStack memTasks[MEM_TASKS] = {
+  {"loopTask", 0},
+  {"tiT", 0},         // lwIP TCP/IP
+  {"wifi", 0},
+#if defined(CONFIG_IDF_TARGET_ESP32C3)
+  {"IDLE", 0},
+#else
+  {"IDLE0", 0},
+#endif
+};
+
+/**
+ * @brief Measure the ESP32 heap and the watched task stacks
+ */
+void memstatsMeasure() {
+  memStats.heapFree = ESP.getFreeHeap();
+  memStats.largestBlock = ESP.getMaxAllocHeap();
+  for (uint8_t i = 0; i < MEM_TASKS; i++) {
+    TaskHandle_t task = xTaskGetHandle(memTasks[i].name);
+    // The ESP-IDF port reports the high-water mark in bytes
+    memTasks[i].free = task ? uxTaskGetStackHighWaterMark(task) : 0;
+  }
+  memStats.stackFree = memTasks[0].free;
+}
+
+/**
+ * @brief Get the stack high-water marks of the watched tasks
+ *
+ * @return Array of MEM_TASKS entries, updated by memstatsSample()
+ */
+const MemTaskStack *memstatsTasks() {
+  return memTasks;
+}
+
+#elif defined(ARDUINO_SIM)
+/**
+ * @brief Nothing to measure on the host simulation
+ */
+void memstatsMeasure() {
+  memStats.heapFree = 0;
+  memStats.largestBlock = 0;
+  memStats.stackFree = 0;
+}
+#endif
+
+/**
+ * @brief Sample heap and stack usage and check the fragmentation alarm
+ */
+void memstatsSample() {
+  memstatsMeasure();
+
+  if (memStats.heapFree < memStats.heapMinFree) memStats.heapMinFree = memStats.heapFree;
+  memStats.fragmentation = memStats.heapFree ?
+    100 - (uint8_t)(memStats.largestBlock * 100 / memStats.heapFree) : 0;
+  if (memStats.fragmentation > memStats.maxFragmentation) {
+    memStats.maxFragmentation = memStats.fragmentation;
+  }
+
+  if (memFragAlarmArmed && memStats.fragmentation >= MEM_FRAG_ALARM) {
+    memFragAlarmArmed = false;
+    memStats.alarms++;
+    memStats.lastAlarm = millis();
+    Serial.print(F("ALARM: heap fragmentation "));
+    Serial.print(memStats.fragmentation);
+    Serial.print(F("% (free "));
+    Serial.print(memStats.heapFree);
+    Serial.print(F(", largest block "));
+    Serial.print(memStats.largestBlock);
+    Serial.println(')');
+  } else if (!memFragAlarmArmed && memStats.fragmentation < MEM_FRAG_REARM) {
+    memFragAlarmArmed = true;
+  }
+}
+
+/**
+ * @brief Get the last memory usage snapshot
+ */
+const MemStats &memstats() {
+  return memStats;
+}
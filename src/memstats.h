@@ -0,0 +1,77 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Heap and stack usage monitor
+ *
+ * memstatsSample() is called periodically from the loop and records the
+ * free heap, the largest free block, the heap fragmentation and the
+ * stack high-water marks:
+ *
+ * - ESP8266: SDK heap counters and the free space of the loop (cont)
+ *   stack, which the core paints at boot.
+ * - ESP32: heap counters and the stack high-water mark of the loop task
+ *   and of the system tasks listed in memstats.cpp.
+ * - AVR: the RAM between the heap and the stack is painted with a canary
+ *   byte before main() runs; the untouched canary bytes are the stack
+ *   (and heap) headroom that was never used. Fragmentation comes from the
+ *   malloc free list.
+ *
+ * When the fragmentation rises above MEM_FRAG_ALARM an alarm is logged
+ * to Serial and counted; it rearms once it drops below MEM_FRAG_REARM.
+ */
+
+#ifndef MEMSTATS_H
+#define MEMSTATS_H
+
+#include <Arduino.h>
+
+// Fragmentation alarm thresholds, percent
+const uint8_t MEM_FRAG_ALARM = 50;
+const uint8_t MEM_FRAG_REARM = 40;
+
+/**
+ * @brief Memory usage snapshot
+ */
+struct MemStats {
+  uint32_t heapFree;          // Bytes free now
+  uint32_t heapMinFree;       // Lowest heapFree seen
+  uint32_t largestBlock;      // Largest block malloc() can return
+  uint8_t fragmentation;      // 100 - largestBlock / heapFree, percent
+  uint8_t maxFragmentation;   // Highest fragmentation seen
+  uint32_t stackFree;         // Loop stack never used (high-water mark)
+  uint16_t alarms;            // Fragmentation alarms raised
+  unsigned long lastAlarm;    // millis() of the last alarm
+};
+
+#if defined(ESP32)
+/**
+ * @brief Stack high-water mark of one FreeRTOS task
+ */
+struct MemTaskStack {
+  const char *name;
+  uint32_t free;              // Bytes never used, 0 if the task is missing
+};
+const uint8_t MEM_TASKS = 4;
+const MemTaskStack *memstatsTasks();
+#endif
+
+void memstatsSample();
+const MemStats &memstats();
+
+#endif // MEMSTATS_H
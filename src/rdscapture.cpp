@@ -0,0 +1,197 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <Arduino.h>
+
+#include "board.h"
+
+#if BOARD_HAS_WIFI
+  #include "config.h"
+#endif
+
+#if defined(ENABLE_RDS_CAPTURE)
+
+#if !BOARD_HAS_WIFI
+#error "ENABLE_RDS_CAPTURE needs a board with WiFi (the capture is served at /api/rdscapture)"
+#endif
+#if !defined(ENABLE_RDS)
+#error "ENABLE_RDS_CAPTURE needs ENABLE_RDS"
+#endif
+
+#include <Wire.h>
+
+#include "rdscapture.h"
+#include "tunerbus.h"
+
+// RDA5807M status registers, read sequentially from 0x0A
+const uint8_t RDA_STATUS_WORDS = 6;          // 0x0A to 0x0F
+const uint16_t RDA_0A_RDSR = 0x8000;         // New group ready
+const uint16_t RDA_0A_RDSS = 0x1000;         // RDS decoder synchronized
+const uint16_t RDA_0B_ABCD_E = 0x0010;       // Block E instead of A
+const uint8_t RDA_0B_BLERA_SHIFT = 2;
+const uint16_t RDA_0B_BLER_MASK = 0x0003;
+
+static_assert(sizeof(RdsCaptureHeader) == 16, "RDS capture header is 16 bytes");
+static_assert(sizeof(RdsCaptureRecord) == 12, "RDS capture record is 12 bytes");
+
+// A group takes 87.6 ms on air; identical blocks seen again sooner are
+// the same group polled twice
+const unsigned long RDS_GROUP_MS = 88;
+
+RdsCaptureRecord rdsRing[RDS_CAPTURE_RECORDS];
+RdsCaptureHeader rdsHeader;
+uint16_t rdsHead = 0;               // Next slot
+bool rdsRunning = false;
+bool rdsFrozen = false;             // Set while the ring is being dumped
+unsigned long rdsStartedAt = 0;     // millis() when the capture started
+unsigned long rdsLastAt = 0;        // millis() of the last record
+unsigned long rdsLastPoll = 0;
+
+/**
+ * @brief Start a new capture, dropping the previous one
+ *
+ * @param frequency Tuned frequency, 10 kHz units
+ * @param now millis()
+ */
+void rdsCaptureStart(uint16_t frequency, unsigned long now) {
+  memset(&rdsHeader, 0, sizeof(rdsHeader));
+  memcpy(rdsHeader.magic, "RDS", 3);
+  rdsHeader.version = RDS_CAPTURE_VERSION;
+  rdsHeader.frequency = frequency;
+  rdsHeader.recordSize = sizeof(RdsCaptureRecord);
+  rdsHeader.flags = RDS_CAPTURE_CD_UNCHECKED;
+  rdsHead = 0;
+  rdsStartedAt = now;
+  rdsLastPoll = now;
+  rdsRunning = true;
+}
+
+/**
+ * @brief Stop recording; the capture is kept for download
+ */
+void rdsCaptureStop() {
+  rdsRunning = false;
+}
+
+/**
+ * @brief Check whether a capture is recording
+ */
+bool rdsCaptureRunning() {
+  return rdsRunning;
+}
+
+/**
+ * @brief Read the tuner status and RDS registers
+ *
+ * @param regs Registers 0x0A to 0x0F
+ * @return false if the tuner did not answer in full
+ */
+bool rdsCaptureRead(uint16_t *regs) {
+  if (Wire.requestFrom(TUNER_I2C_ADDR, (uint8_t)(2 * RDA_STATUS_WORDS)) != 2 * RDA_STATUS_WORDS) {
+    while (Wire.available()) Wire.read();
+    return false;
+  }
+  for (uint8_t i = 0; i < RDA_STATUS_WORDS; i++) {
+    uint16_t hi = Wire.read();
+    regs[i] = (hi << 8) | (uint8_t)Wire.read();
+  }
+  return true;
+}
+
+/**
+ * @brief Append a group to the ring, overwriting the oldest
+ */
+void rdsCaptureStore(const uint16_t *regs, unsigned long now) {
+  if (rdsHeader.records == RDS_CAPTURE_RECORDS) {
+    // The second oldest record becomes the first: carry its delay over
+    // to the header, where the first record's delay is kept
+    RdsCaptureRecord &next = rdsRing[(rdsHead + 1) % RDS_CAPTURE_RECORDS];
+    rdsHeader.first += next.delta;
+    next.delta = 0;
+    if (rdsHeader.dropped < 0xFFFF) rdsHeader.dropped++;
+  } else {
+    rdsHeader.records++;
+  }
+
+  RdsCaptureRecord &rec = rdsRing[rdsHead];
+  if (rdsHeader.records == 1) {
+    rdsHeader.first = now - rdsStartedAt;
+    rec.delta = 0;
+  } else {
+    unsigned long delta = now - rdsLastAt;
+    rec.delta = delta > 0xFFFF ? 0xFFFF : delta;
+  }
+  memcpy(rec.blocks, regs + 2, sizeof(rec.blocks));
+  uint8_t bler = regs[1] & ((RDA_0B_BLER_MASK << RDA_0B_BLERA_SHIFT) | RDA_0B_BLER_MASK);
+  rec.errors = bler << 4;
+  rec.status = 0;
+  if (regs[0] & RDA_0A_RDSS) rec.status |= RDS_CAPTURE_SYNC;
+  if (regs[1] & RDA_0B_ABCD_E) rec.status |= RDS_CAPTURE_BLOCK_E;
+
+  rdsHead = (rdsHead + 1) % RDS_CAPTURE_RECORDS;
+  rdsLastAt = now;
+}
+
+/**
+ * @brief Record the next group, if one arrived
+ *
+ * Call from the loop while the tuner is not seeking or scanning; polls
+ * the tuner every RDS_CAPTURE_POLL ms. A change of frequency starts a new
+ * capture.
+ *
+ * @param frequency Tuned frequency, 10 kHz units
+ * @param now millis()
+ */
+void rdsCaptureService(uint16_t frequency, unsigned long now) {
+  if (!rdsRunning || rdsFrozen) return;
+  if (frequency != rdsHeader.frequency) rdsCaptureStart(frequency, now);
+  if (now - rdsLastPoll < RDS_CAPTURE_POLL) return;
+  rdsLastPoll = now;
+
+  uint16_t regs[RDA_STATUS_WORDS];
+  if (!rdsCaptureRead(regs)) return;
+  if (!(regs[0] & RDA_0A_RDSR)) return;
+  if (rdsHeader.records && now - rdsLastAt < RDS_GROUP_MS) {
+    const RdsCaptureRecord &last = rdsRing[(rdsHead + RDS_CAPTURE_RECORDS - 1) % RDS_CAPTURE_RECORDS];
+    if (memcmp(last.blocks, regs + 2, sizeof(last.blocks)) == 0) return;
+  }
+  rdsCaptureStore(regs, now);
+}
+
+/**
+ * @brief Pause recording while the capture is being dumped
+ */
+void rdsCaptureFreeze(bool frozen) {
+  rdsFrozen = frozen;
+}
+
+/**
+ * @brief Get the capture header
+ */
+const RdsCaptureHeader &rdsCaptureHeader() {
+  return rdsHeader;
+}
+
+/**
+ * @brief Get a record, 0 being the oldest
+ */
+const RdsCaptureRecord &rdsCaptureGet(uint16_t index) {
+  return rdsRing[(rdsHead + RDS_CAPTURE_RECORDS - rdsHeader.records + index) % RDS_CAPTURE_RECORDS];
+}
+
+#endif // ENABLE_RDS_CAPTURE
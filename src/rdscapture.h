@@ -0,0 +1,119 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Raw RDS group capture (ENABLE_RDS_CAPTURE, WiFi boards only)
+ *
+ * While a capture runs, the tuner status and RDS registers (0x0A-0x0F)
+ * are polled every RDS_CAPTURE_POLL ms and each new group is recorded
+ * with its four blocks, error levels and arrival time in a RAM ring of
+ * RDS_CAPTURE_RECORDS entries, overwriting the oldest. A capture covers
+ * one station: it starts over when the tuned frequency changes.
+ *
+ * /api/rdscapture?format=raw downloads it, little endian, as a 16 byte
+ * header:
+ *
+ *   'R' 'D' 'S'  magic
+ *   u8           format version (1)
+ *   u16          frequency, 10 kHz units
+ *   u8           record size (12)
+ *   u8           flags, RDS_CAPTURE_CD_UNCHECKED
+ *   u32          ms from the start of the capture to the first record
+ *   u16          records
+ *   u16          records overwritten (saturates)
+ *
+ * followed by the records, oldest first:
+ *
+ *   u16          ms since the previous record (saturates, 0 for the first)
+ *   u16 x 4      blocks A, B, C, D
+ *   u8           error levels, 2 bits per block, A in bits 7-6 to D in
+ *                bits 1-0: 0 none, 1 1-2 corrected, 2 3-5 corrected,
+ *                3 uncorrectable
+ *   u8           status, RDS_CAPTURE_SYNC and RDS_CAPTURE_BLOCK_E
+ *
+ * The RDA5807M reports error levels for blocks A and B only; C and D are
+ * stored as 0 and the header carries RDS_CAPTURE_CD_UNCHECKED.
+ *
+ * The capture is downloaded over HTTP only; there is no serial dump.
+ *
+ * test/test_rdsreplay (pio test -e native_rds) replays captures into the
+ * chip registers of the host simulation, at their captured pace, so the
+ * firmware decodes them on its own RDS path; tools/rdsreplay.py replays
+ * them through a reference decoder. Both report groups per second and
+ * the time to a complete PS and RT.
+ */
+
+#ifndef RDSCAPTURE_H
+#define RDSCAPTURE_H
+
+#include <Arduino.h>
+
+#if defined(ENABLE_RDS_CAPTURE)
+
+#if defined(ESP32)
+const uint16_t RDS_CAPTURE_RECORDS = 2048;   // About 3 minutes of groups
+#else
+const uint16_t RDS_CAPTURE_RECORDS = 512;    // About 45 s of groups
+#endif
+// Poll interval, ms; a group takes 87.6 ms on air
+const unsigned long RDS_CAPTURE_POLL = 20;
+
+const uint8_t RDS_CAPTURE_VERSION = 1;
+
+// Header flags
+const uint8_t RDS_CAPTURE_CD_UNCHECKED = 0x01;  // No error levels for C and D
+
+// Record status
+const uint8_t RDS_CAPTURE_SYNC = 0x01;          // Decoder synchronized
+const uint8_t RDS_CAPTURE_BLOCK_E = 0x02;       // Block E (RBDS), not A
+
+/**
+ * @brief Capture header, as downloaded
+ */
+struct __attribute__((packed)) RdsCaptureHeader {
+  char magic[3];
+  uint8_t version;
+  uint16_t frequency;
+  uint8_t recordSize;
+  uint8_t flags;
+  uint32_t first;         // ms from the start to the first record
+  uint16_t records;
+  uint16_t dropped;
+};
+
+/**
+ * @brief One captured group, as downloaded
+ */
+struct __attribute__((packed)) RdsCaptureRecord {
+  uint16_t delta;         // ms since the previous record
+  uint16_t blocks[4];
+  uint8_t errors;
+  uint8_t status;
+};
+
+void rdsCaptureStart(uint16_t frequency, unsigned long now);
+void rdsCaptureStop();
+bool rdsCaptureRunning();
+void rdsCaptureService(uint16_t frequency, unsigned long now);
+void rdsCaptureFreeze(bool frozen);
+const RdsCaptureHeader &rdsCaptureHeader();
+const RdsCaptureRecord &rdsCaptureGet(uint16_t index);
+
+#endif // ENABLE_RDS_CAPTURE
+
+#endif // RDSCAPTURE_H
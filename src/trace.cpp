@@ -0,0 +1,177 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <Arduino.h>
+
+#include "board.h"
+
+#if BOARD_HAS_WIFI
+  #include "config.h"
+#endif
+
+#if defined(ENABLE_TRACE)
+
+#if !BOARD_HAS_WIFI
+#error "ENABLE_TRACE needs a board with WiFi (the trace is served at /api/trace)"
+#endif
+
+#include "trace.h"
+#include "watchdog.h"
+#include "flashstr.h"
+
+// Span and instant names, indexed by TraceName - TRACE_NAME_BASE
+const char traceName0[] PROGMEM = "render";
+const char traceName1[] PROGMEM = "seek";
+const char traceName2[] PROGMEM = "button";
+const char traceName3[] PROGMEM = "retune";
+const char traceName4[] PROGMEM = "hop";
+const char traceName5[] PROGMEM = "i2c-error";
+const char *const traceNames[TRACE_NAME_END - TRACE_NAME_BASE] PROGMEM = {
+  traceName0, traceName1, traceName2, traceName3, traceName4, traceName5
+};
+
+const char TRACE_JSON_HEAD[] PROGMEM = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+const char TRACE_JSON_TAIL[] PROGMEM = "]}";
+
+TraceEvent traceRing[TRACE_EVENTS];
+uint16_t traceHead = 0;             // Next slot
+uint16_t traceStored = 0;           // Valid events
+bool traceFrozen = false;           // Set while the ring is being dumped
+uint8_t traceRunning = WD_IDLE;     // Loop section running
+uint32_t traceRunningSince = 0;     // micros() when it was entered
+
+/**
+ * @brief Append an event to the ring, overwriting the oldest
+ */
+void traceStore(uint32_t ts, char phase, uint8_t name, uint32_t value) {
+  if (traceFrozen) return;
+  TraceEvent &ev = traceRing[traceHead];
+  ev.ts = ts;
+  ev.value = value;
+  ev.phase = phase;
+  ev.name = name;
+  traceHead = (traceHead + 1) % TRACE_EVENTS;
+  if (traceStored < TRACE_EVENTS) traceStored++;
+}
+
+/**
+ * @brief Record a begin, end or instant event now
+ */
+void traceEvent(char phase, uint8_t name, uint32_t value) {
+  traceStore(micros(), phase, name, value);
+}
+
+/**
+ * @brief End the running loop section and start the next one
+ *
+ * The ended section is recorded as a complete event if it took at least
+ * TRACE_MIN_SECTION.
+ *
+ * @param section WatchdogSection about to run
+ */
+void traceSection(uint8_t section) {
+  uint32_t now = micros();
+  uint32_t duration = now - traceRunningSince;
+  if (traceRunning != WD_IDLE && duration >= TRACE_MIN_SECTION) {
+    traceStore(traceRunningSince, TRACE_PH_COMPLETE, traceRunning, duration);
+  }
+  traceRunning = section;
+  traceRunningSince = now;
+}
+
+/**
+ * @brief Get the name of a loop section, span or instant, in flash
+ */
+const __FlashStringHelper *traceName(uint8_t name) {
+  if (name >= TRACE_NAME_BASE && name < TRACE_NAME_END) {
+    return FPSTR(pgm_read_ptr(&traceNames[name - TRACE_NAME_BASE]));
+  }
+  return watchdogSectionName(name);
+}
+
+/**
+ * @brief Stop or resume recording, so a dump sees a stable ring
+ */
+void traceFreeze(bool frozen) {
+  traceFrozen = frozen;
+}
+
+/**
+ * @brief Get the number of events in the ring
+ */
+uint16_t traceCount() {
+  return traceStored;
+}
+
+/**
+ * @brief Get an event, 0 being the oldest
+ */
+const TraceEvent &traceGet(uint16_t index) {
+  return traceRing[(traceHead + TRACE_EVENTS - traceStored + index) % TRACE_EVENTS];
+}
+
+/**
+ * @brief Format an event as Chrome trace JSON, with the comma before it
+ * unless it is the first one
+ *
+ * @param size Buffer size, TRACE_JSON_EVENT fits any event
+ * @return Length of the text
+ */
+int traceFormat(uint16_t index, char *buf, size_t size) {
+  const TraceEvent &ev = traceGet(index);
+  char name[16];
+  strncpy_P(name, (PGM_P)traceName(ev.name), sizeof(name) - 1);
+  name[sizeof(name) - 1] = '\0';
+  int len = snprintf_P(buf, size, PSTR("%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%lu,\"pid\":1,\"tid\":1"),
+                       index ? "," : "", name, ev.phase, (unsigned long)ev.ts);
+  if (ev.phase == TRACE_PH_COMPLETE) {
+    len += snprintf_P(buf + len, size - len, PSTR(",\"dur\":%lu}"), (unsigned long)ev.value);
+  } else if (ev.phase == TRACE_PH_INSTANT) {
+    len += snprintf_P(buf + len, size - len, PSTR(",\"s\":\"t\",\"args\":{\"value\":%lu}}"), (unsigned long)ev.value);
+  } else {
+    len += snprintf_P(buf + len, size - len, PSTR("}"));
+  }
+  return len;
+}
+
+#if defined(ARDUINO_SIM)
+/**
+ * @brief Write the ring as Chrome trace JSON to a file on the host, the
+ * same document /api/trace serves
+ *
+ * Timestamps are those of the virtual clock.
+ *
+ * @return False if the file could not be written
+ */
+bool traceWriteFile(const char *path) {
+  FILE *file = fopen(path, "w");
+  if (!file) return false;
+  traceFreeze(true);
+  fputs(TRACE_JSON_HEAD, file);
+  char buf[TRACE_JSON_EVENT];
+  uint16_t count = traceCount();
+  for (uint16_t i = 0; i < count; i++) {
+    fwrite(buf, 1, traceFormat(i, buf, sizeof(buf)), file);
+  }
+  fputs(TRACE_JSON_TAIL, file);
+  traceFreeze(false);
+  return fclose(file) == 0;
+}
+#endif
+
+#endif // ENABLE_TRACE
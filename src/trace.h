@@ -0,0 +1,110 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Event tracer (ENABLE_TRACE, WiFi boards only)
+ *
+ * Records firmware events with micros() timestamps in a RAM ring of
+ * TRACE_EVENTS entries, served by /api/trace as Chrome trace JSON (open
+ * it in chrome://tracing or https://ui.perfetto.dev). The native build
+ * can also write the same JSON to a file, see traceWriteFile().
+ *
+ * - Loop sections: every watchdogEnter() ends the running loop section;
+ *   if it took at least TRACE_MIN_SECTION us it is recorded as one
+ *   complete ("X") event, so idle passes do not flood the ring.
+ * - Spans: TRACE_BEGIN()/TRACE_END() around work inside a section
+ *   (display render, seek).
+ * - Instants: TRACE_INSTANT() for things that happen at a point in time
+ *   (button press, retune, I2C error), with a 16 bit argument.
+ *
+ * Without ENABLE_TRACE the macros expand to empty statements and this
+ * module is not compiled, so tracing costs no code, RAM or time.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <Arduino.h>
+
+#if defined(ENABLE_TRACE)
+
+// Names of spans and instants; loop sections use their WatchdogSection
+// values, below TRACE_NAME_BASE
+enum TraceName : uint8_t {
+  TRACE_NAME_BASE = 0x40,
+  TRACE_RENDER = TRACE_NAME_BASE,
+  TRACE_SEEK,
+  TRACE_BUTTON,
+  TRACE_RETUNE,
+  TRACE_HOP,
+  TRACE_I2C_ERROR,
+  TRACE_NAME_END
+};
+
+// Event phases, as in the Chrome trace format
+const char TRACE_PH_BEGIN = 'B';
+const char TRACE_PH_END = 'E';
+const char TRACE_PH_COMPLETE = 'X';
+const char TRACE_PH_INSTANT = 'i';
+
+const uint16_t TRACE_EVENTS = 256;
+// Shortest loop section worth recording, us
+const unsigned long TRACE_MIN_SECTION = 100;
+// Buffer size for one event formatted by traceFormat()
+const size_t TRACE_JSON_EVENT = 112;
+
+// Chrome trace JSON around the events
+extern const char TRACE_JSON_HEAD[] PROGMEM;
+extern const char TRACE_JSON_TAIL[] PROGMEM;
+
+/**
+ * @brief One trace event
+ */
+struct TraceEvent {
+  uint32_t ts;            // micros()
+  uint32_t value;         // Duration of a complete event, instant argument
+  char phase;
+  uint8_t name;           // WatchdogSection or TraceName
+};
+
+void traceSection(uint8_t section);
+void traceEvent(char phase, uint8_t name, uint32_t value);
+const __FlashStringHelper *traceName(uint8_t name);
+void traceFreeze(bool frozen);
+uint16_t traceCount();
+const TraceEvent &traceGet(uint16_t index);
+int traceFormat(uint16_t index, char *buf, size_t size);
+#if defined(ARDUINO_SIM)
+bool traceWriteFile(const char *path);
+#endif
+
+#define TRACE_BEGIN(name)        traceEvent(TRACE_PH_BEGIN, (name), 0)
+#define TRACE_END(name)          traceEvent(TRACE_PH_END, (name), 0)
+#define TRACE_INSTANT(name, arg) traceEvent(TRACE_PH_INSTANT, (name), (arg))
+#define TRACE_SECTION(section)   traceSection(section)
+
+#else
+
+#define TRACE_BEGIN(name)        do {} while (0)
+#define TRACE_END(name)          do {} while (0)
+#define TRACE_INSTANT(name, arg) do {} while (0)
+#define TRACE_SECTION(section)   do {} while (0)
+
+#endif // ENABLE_TRACE
+
+#endif // TRACE_H
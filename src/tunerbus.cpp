@@ -0,0 +1,168 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#include "board.h"
+
+#if BOARD_HAS_WIFI
+  #include "config.h"
+#endif
+
+#include "tunerbus.h"
+#include "trace.h"
+
+// Wire.endTransmission() status meaning the transfer timed out (AVR)
+const uint8_t TUNER_BUS_TIMEOUT = 5;
+// Half period of the recovery clock, about 100 kHz
+const unsigned int TUNER_BUS_HALF_PERIOD = 5;
+
+TunerBusStats tunerBus = {0, 0, 0, 0, 0, 0, 0};
+unsigned long tunerBusLastCheck = 0;
+
+/**
+ * @brief Bound every Wire transfer in time
+ *
+ * Call after the tuner library has started Wire.
+ */
+void tunerBusTimeouts() {
+#if defined(WIRE_HAS_TIMEOUT)
+  Wire.setWireTimeout(3000, true);     // us, reset the TWI on timeout
+#elif defined(ESP32)
+  Wire.setTimeOut(10);                 // ms
+#elif defined(ESP8266)
+  Wire.setClockStretchLimit(2000);     // us
+#endif
+}
+
+/**
+ * @brief Prepare the tuner bus
+ *
+ * Call after radio.setup(), which starts Wire.
+ */
+void tunerBusBegin() {
+  tunerBusTimeouts();
+}
+
+/**
+ * @brief Address the tuner and return the transfer status
+ *
+ * @return 0 if the tuner acknowledged, the Wire error code otherwise
+ */
+uint8_t tunerBusCheck() {
+  Wire.beginTransmission(TUNER_I2C_ADDR);
+  uint8_t error = Wire.endTransmission();
+  if (error) {
+    TRACE_INSTANT(TRACE_I2C_ERROR, error);
+    tunerBus.errors++;
+    tunerBus.lastError = error;
+  }
+  return error;
+}
+
+/**
+ * @brief Release the I2C lines, clocking out a stuck slave if needed
+ *
+ * The lines are driven open drain: low as an output, high by switching
+ * back to an input with pull-up.
+ */
+void tunerBusRecover() {
+  unsigned long start = micros();
+#if !defined(ESP8266)
+  Wire.end();
+#endif
+  pinMode(SDA, INPUT_PULLUP);
+  pinMode(SCL, INPUT_PULLUP);
+  delayMicroseconds(TUNER_BUS_HALF_PERIOD);
+
+  // Up to nine clocks, until the slave lets go of SDA
+  for (uint8_t i = 0; i < 9 && digitalRead(SDA) == LOW; i++) {
+    pinMode(SCL, OUTPUT);
+    digitalWrite(SCL, LOW);
+    delayMicroseconds(TUNER_BUS_HALF_PERIOD);
+    pinMode(SCL, INPUT_PULLUP);
+    delayMicroseconds(TUNER_BUS_HALF_PERIOD);
+  }
+
+  // STOP: SDA rises while SCL is high
+  pinMode(SCL, OUTPUT);
+  digitalWrite(SCL, LOW);
+  pinMode(SDA, OUTPUT);
+  digitalWrite(SDA, LOW);
+  delayMicroseconds(TUNER_BUS_HALF_PERIOD);
+  pinMode(SCL, INPUT_PULLUP);
+  delayMicroseconds(TUNER_BUS_HALF_PERIOD);
+  pinMode(SDA, INPUT_PULLUP);
+  delayMicroseconds(TUNER_BUS_HALF_PERIOD);
+
+  Wire.begin();
+  tunerBusTimeouts();
+
+  unsigned long elapsed = micros() - start;
+  tunerBus.recoveries++;
+  tunerBus.recoveryMicros += elapsed;
+  if (elapsed > tunerBus.recoveryMaxMicros) tunerBus.recoveryMaxMicros = elapsed;
+}
+
+/**
+ * @brief Prepare to repeat a failed tuner write
+ *
+ * Recovers the bus if a slave holds SDA low or the transfer timed out.
+ *
+ * @param error Wire error code of the failed transfer
+ */
+void tunerBusRetry(uint8_t error) {
+  tunerBus.retries++;
+  if (error == TUNER_BUS_TIMEOUT || digitalRead(SDA) == LOW) {
+    tunerBusRecover();
+  }
+}
+
+/**
+ * @brief Count a tuner write given up after all retries
+ */
+void tunerBusFailed() {
+  tunerBus.failures++;
+  Serial.print(F("Tuner I2C write failed, error "));
+  Serial.println(tunerBus.lastError);
+}
+
+/**
+ * @brief Check the bus once a second, recovering it if it is stuck
+ *
+ * Catches the errors of the tuner reads, which are not checked one by
+ * one.
+ *
+ * @param currentMillis Current time in ms
+ */
+void tunerBusService(unsigned long currentMillis) {
+  if (currentMillis - tunerBusLastCheck < TUNER_BUS_CHECK_INTERVAL) return;
+  tunerBusLastCheck = currentMillis;
+  uint8_t error = tunerBusCheck();
+  if (error && (error == TUNER_BUS_TIMEOUT || digitalRead(SDA) == LOW)) {
+    tunerBusRecover();
+  }
+}
+
+/**
+ * @brief Get the tuner bus counters
+ */
+const TunerBusStats &tunerBusStats() {
+  return tunerBus;
+}
@@ -0,0 +1,88 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Tuner I2C bus health: error detection, retry and bus recovery
+ *
+ * The RDA5807 library talks to the chip through Wire but drops the
+ * transfer status. This layer gets it back: after a tuner write,
+ * tunerBusRun() addresses the chip once more and checks that it
+ * acknowledges. On an error the write is retried, at most
+ * TUNER_BUS_RETRIES times, and if a slave holds SDA low the bus is
+ * recovered first: nine SCL pulses clock out whatever byte the slave is
+ * stuck in, then a STOP condition releases the bus and Wire is
+ * restarted.
+ *
+ * Wire transfers are also given a timeout, so a locked bus makes a
+ * transfer fail instead of hanging loop(). tunerBusService() checks the
+ * bus once a second, which covers the tuner reads.
+ */
+
+#ifndef TUNERBUS_H
+#define TUNERBUS_H
+
+#include <Arduino.h>
+
+// RDA5807 address for sequential register access
+const uint8_t TUNER_I2C_ADDR = 0x10;
+// Retries of a failed tuner write
+const uint8_t TUNER_BUS_RETRIES = 3;
+// Interval of the background bus check, ms
+const unsigned long TUNER_BUS_CHECK_INTERVAL = 1000;
+
+/**
+ * @brief Tuner bus counters
+ */
+struct TunerBusStats {
+  unsigned long errors;           // Failed transfers seen
+  unsigned long retries;          // Tuner writes repeated
+  unsigned long failures;         // Writes given up after all retries
+  unsigned long recoveries;       // Bus recoveries run
+  unsigned long recoveryMicros;   // Time spent in recoveries
+  unsigned long recoveryMaxMicros;
+  uint8_t lastError;              // Last Wire.endTransmission() error code
+};
+
+void tunerBusBegin();
+uint8_t tunerBusCheck();
+void tunerBusRetry(uint8_t error);
+void tunerBusFailed();
+void tunerBusService(unsigned long currentMillis);
+const TunerBusStats &tunerBusStats();
+
+/**
+ * @brief Run a tuner write and repeat it until the tuner acknowledges
+ *
+ * @param op Callable doing the write through the tuner library
+ * @return true if the bus was healthy after the write
+ */
+template <typename Op>
+bool tunerBusRun(Op op) {
+  for (uint8_t attempt = 0; ; attempt++) {
+    op();
+    uint8_t error = tunerBusCheck();
+    if (error == 0) return true;
+    if (attempt == TUNER_BUS_RETRIES) {
+      tunerBusFailed();
+      return false;
+    }
+    tunerBusRetry(error);
+  }
+}
+
+#endif // TUNERBUS_H
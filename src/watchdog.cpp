@@ -0,0 +1,357 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <Arduino.h>
+
+#include "board.h"
+
+#if BOARD_HAS_WIFI
+  #include "config.h"
+#endif
+
+#include "watchdog.h"
+#include "trace.h"
+#include "flashstr.h"
+
+#if defined(__AVR__)
+  #include <avr/wdt.h>
+#elif !defined(ESP8266)
+  // The stall check runs from a Ticker, on the esp_timer task on ESP32
+  #define WD_TICKER
+  #include <Ticker.h>
+#endif
+
+const uint32_t WD_MAGIC = 0x57444731;         // "WDG1"
+const unsigned long WD_CHECK_INTERVAL = 250;   // ms, Ticker check period
+
+// Section names, indexed by WatchdogSection
+const char wdName0[] PROGMEM = "idle";
+const char wdName1[] PROGMEM = "setup";
+const char wdName2[] PROGMEM = "web";
+const char wdName3[] PROGMEM = "wifi";
+const char wdName4[] PROGMEM = "rds";
+const char wdName5[] PROGMEM = "input";
+const char wdName6[] PROGMEM = "tuning";
+const char wdName7[] PROGMEM = "seek";
+const char wdName8[] PROGMEM = "scan";
+const char wdName9[] PROGMEM = "preview";
+const char wdName10[] PROGMEM = "survey";
+const char wdName11[] PROGMEM = "signal";
+const char wdName12[] PROGMEM = "history";
+const char wdName13[] PROGMEM = "memstats";
+const char wdName14[] PROGMEM = "display";
+const char *const wdSectionNames[WD_SECTIONS] PROGMEM = {
+  wdName0, wdName1, wdName2, wdName3, wdName4, wdName5, wdName6, wdName7,
+  wdName8, wdName9, wdName10, wdName11, wdName12, wdName13, wdName14
+};
+
+/**
+ * @brief Watchdog state kept across resets
+ */
+struct WatchdogStore {
+  uint32_t magic;
+  uint8_t section;        // Section running now
+  uint8_t head;           // Next record slot
+  uint16_t boot;          // Boot counter
+  uint32_t enteredAt;     // millis() when section was entered
+  uint8_t count;          // Valid records
+  uint8_t open;           // 1 + index of the open record, 0 if none
+  uint16_t reserved;
+  StallRecord records[WD_RECORDS];
+};
+
+#if defined(__AVR__)
+WatchdogStore wdStore __attribute__((section(".noinit")));
+uint8_t wdResetFlags __attribute__((section(".noinit")));   // MCUSR at boot
+#define WD_LOCK()   uint8_t wdSreg = SREG; cli()
+#define WD_UNLOCK() SREG = wdSreg
+#elif defined(ESP32)
+RTC_NOINIT_ATTR WatchdogStore wdStore;
+portMUX_TYPE wdMux = portMUX_INITIALIZER_UNLOCKED;
+#define WD_LOCK()   portENTER_CRITICAL(&wdMux)
+#define WD_UNLOCK() portEXIT_CRITICAL(&wdMux)
+#elif defined(ESP8266)
+// ESP8266 RAM is cleared at boot, the store is mirrored to RTC user
+// memory instead, after the 128 bytes the OTA updater uses
+WatchdogStore wdStore;
+const uint32_t WD_RTC_OFFSET = 32;            // In 4 byte blocks
+// Nothing runs concurrently with the loop
+#define WD_LOCK()
+#define WD_UNLOCK()
+#else
+// Host simulation: the Ticker fires inside delay()
+WatchdogStore wdStore;
+#define WD_LOCK()
+#define WD_UNLOCK()
+#endif
+
+#if defined(WD_TICKER)
+Ticker wdTicker;
+#endif
+
+/**
+ * @brief Persist the store
+ *
+ * Only ESP8266 has to copy it (to RTC memory), so it is called when the
+ * records change, not on every section change.
+ */
+void watchdogSave() {
+#if defined(ESP8266)
+  ESP.rtcUserMemoryWrite(WD_RTC_OFFSET, (uint32_t *)&wdStore, sizeof(wdStore));
+#endif
+}
+
+/**
+ * @brief Open a new stall record for the running section
+ */
+void watchdogOpenRecord(unsigned long now) {
+  StallRecord &rec = wdStore.records[wdStore.head];
+  rec.section = wdStore.section;
+  rec.flags = WD_STALL_OPEN;
+  rec.boot = wdStore.boot;
+  rec.start = wdStore.enteredAt;
+  rec.duration = now - wdStore.enteredAt;
+  wdStore.open = wdStore.head + 1;
+  wdStore.head = (wdStore.head + 1) % WD_RECORDS;
+  if (wdStore.count < WD_RECORDS) wdStore.count++;
+}
+
+/**
+ * @brief Stall check from outside the loop (WDT interrupt or Ticker)
+ *
+ * Opens a record once the running section passes the threshold and
+ * keeps its duration current while the stall goes on.
+ */
+void watchdogCheck() {
+  WD_LOCK();
+  unsigned long now = millis();
+  if (wdStore.section != WD_IDLE && now - wdStore.enteredAt >= WD_STALL_THRESHOLD) {
+    if (wdStore.open) {
+      wdStore.records[wdStore.open - 1].duration = now - wdStore.enteredAt;
+    } else {
+      watchdogOpenRecord(now);
+    }
+  }
+  WD_UNLOCK();
+}
+
+#if defined(__AVR__)
+/**
+ * @brief Keep the reset cause and stop the watchdog timer
+ *
+ * Runs from .init3, before the C++ constructors: after a watchdog reset
+ * the timer is still running with its shortest period and would reset
+ * the board again before setup().
+ */
+void watchdogEarly() __attribute__((naked, used, section(".init3")));
+void watchdogEarly() {
+  wdResetFlags = MCUSR;
+  MCUSR = 0;
+  wdt_disable();
+}
+
+/**
+ * @brief First timeout: record the stall; the hardware clears WDIE, so
+ * the next timeout resets the board unless watchdogEnter() runs first
+ */
+ISR(WDT_vect) {
+  watchdogCheck();
+}
+#elif defined(ESP8266)
+/**
+ * @brief Persist the running section on a crash or a software watchdog
+ * reset
+ *
+ * The core calls this from its exception handler, just before the
+ * reset. It is the only way to learn the section on ESP8266: timers
+ * only run when the loop yields, so nothing else can see a stuck loop,
+ * and copying the section to RTC memory on every change would cost more
+ * than the whole check. A hardware watchdog reset leaves no trace.
+ */
+extern "C" void custom_crash_callback(struct rst_info *, uint32_t, uint32_t) {
+  if (wdStore.section != WD_IDLE && !wdStore.open) watchdogOpenRecord(millis());
+  watchdogSave();
+}
+#endif
+
+/**
+ * @brief Check whether the last reset was caused by a watchdog or a crash
+ */
+bool watchdogCrashReset() {
+#if defined(ESP32)
+  esp_reset_reason_t reason = esp_reset_reason();
+  return reason == ESP_RST_PANIC || reason == ESP_RST_INT_WDT ||
+         reason == ESP_RST_TASK_WDT || reason == ESP_RST_WDT;
+#elif defined(__AVR__)
+  // Zero if the bootloader cleared MCUSR first
+  return wdResetFlags & _BV(WDRF);
+#else
+  // ESP8266: custom_crash_callback() has opened the record already, and
+  // the section in RTC memory is stale otherwise
+  return false;
+#endif
+}
+
+/**
+ * @brief Validate the persistent store, account for the previous boot
+ * and print its stall records
+ *
+ * Call early in setup(), after Serial is up.
+ */
+void watchdogBegin() {
+#if defined(ESP8266)
+  ESP.rtcUserMemoryRead(WD_RTC_OFFSET, (uint32_t *)&wdStore, sizeof(wdStore));
+#endif
+  if (wdStore.magic != WD_MAGIC || wdStore.head >= WD_RECORDS ||
+      wdStore.count > WD_RECORDS || wdStore.open > WD_RECORDS) {
+    memset(&wdStore, 0, sizeof(wdStore));
+    wdStore.magic = WD_MAGIC;
+  } else if (wdStore.open) {
+    // The stall was still going on when the device reset
+    wdStore.records[wdStore.open - 1].flags = WD_STALL_RESET;
+  } else if (wdStore.section != WD_IDLE && wdStore.section < WD_SECTIONS && watchdogCrashReset()) {
+    // Reset before any check caught the stall: blame the section anyway
+    watchdogOpenRecord(wdStore.enteredAt);
+    wdStore.records[wdStore.open - 1].flags = WD_STALL_RESET;
+  }
+
+  wdStore.open = 0;
+  wdStore.boot++;
+  wdStore.section = WD_SETUP;
+  wdStore.enteredAt = millis();
+  watchdogSave();
+
+  Serial.print(F("Boot "));
+  Serial.print(wdStore.boot);
+  Serial.print(F(", "));
+  Serial.print(wdStore.count);
+  Serial.println(F(" loop stall(s) on record"));
+  StallRecord records[WD_RECORDS];
+  uint8_t count = watchdogRecords(records);
+  for (uint8_t i = 0; i < count; i++) {
+    Serial.print(F("  boot "));
+    Serial.print(records[i].boot);
+    Serial.print(F(" at "));
+    Serial.print(records[i].start);
+    Serial.print(F(" ms: "));
+    Serial.print(watchdogSectionName(records[i].section));
+    Serial.print(F(" stalled "));
+    Serial.print(records[i].duration);
+    Serial.println(records[i].flags & WD_STALL_RESET ? F(" ms, then reset") : F(" ms"));
+  }
+}
+
+/**
+ * @brief Start the periodic stall check
+ *
+ * Call at the end of setup(). On AVR it puts the watchdog timer in
+ * interrupt and reset mode with a 1 s period: a loop section stuck for
+ * a second gets its stall record from the interrupt, one stuck for two
+ * resets the board. On ESP32 it starts a Ticker; ESP8266 has no check
+ * of its own and leaves the stuck loop to the software watchdog of the
+ * core (see custom_crash_callback()).
+ */
+void watchdogStart() {
+  // setup() may legitimately take seconds (WiFi, filesystem), so it is
+  // left without a stall check
+  TRACE_SECTION(WD_IDLE);
+  wdStore.section = WD_IDLE;
+  wdStore.enteredAt = millis();
+#if defined(__AVR__)
+  cli();
+  wdt_reset();
+  WDTCSR = _BV(WDCE) | _BV(WDE);
+  WDTCSR = _BV(WDIE) | _BV(WDE) | _BV(WDP2) | _BV(WDP1);
+  sei();
+#elif defined(WD_TICKER)
+  wdTicker.attach_ms(WD_CHECK_INTERVAL, watchdogCheck);
+#endif
+}
+
+/**
+ * @brief Feed the watchdog and name the section about to run
+ *
+ * Closes the record of a stall of the previous section, or creates one
+ * if the section ran too long between two checks.
+ */
+void watchdogEnter(WatchdogSection section) {
+  TRACE_SECTION(section);
+  unsigned long now = millis();
+  WD_LOCK();
+#if defined(__AVR__)
+  // Feed the timer; after a first timeout, also arm the interrupt again
+  wdt_reset();
+  WDTCSR |= _BV(WDIE);
+#endif
+  bool changed = false;
+  if (wdStore.open) {
+    StallRecord &rec = wdStore.records[wdStore.open - 1];
+    rec.duration = now - wdStore.enteredAt;
+    rec.flags = 0;
+    wdStore.open = 0;
+    changed = true;
+  } else if (wdStore.section != WD_IDLE && now - wdStore.enteredAt >= WD_STALL_THRESHOLD) {
+    watchdogOpenRecord(now);
+    wdStore.records[wdStore.open - 1].flags = 0;
+    wdStore.open = 0;
+    changed = true;
+  }
+  wdStore.section = section;
+  wdStore.enteredAt = now;
+  if (changed) watchdogSave();
+  WD_UNLOCK();
+}
+
+/**
+ * @brief Get the name of a section, in flash
+ */
+const __FlashStringHelper *watchdogSectionName(uint8_t section) {
+  if (section >= WD_SECTIONS) return F("?");
+  return FPSTR(pgm_read_ptr(&wdSectionNames[section]));
+}
+
+/**
+ * @brief Get the section running now
+ */
+uint8_t watchdogSection() {
+  return wdStore.section;
+}
+
+/**
+ * @brief Get the boot number
+ */
+uint16_t watchdogBoot() {
+  return wdStore.boot;
+}
+
+/**
+ * @brief Copy the stall records, oldest first
+ *
+ * @param records Array of at least WD_RECORDS entries
+ * @return Number of records copied
+ */
+uint8_t watchdogRecords(StallRecord *records) {
+  WD_LOCK();
+  uint8_t count = wdStore.count;
+  uint8_t first = (wdStore.head + WD_RECORDS - count) % WD_RECORDS;
+  for (uint8_t i = 0; i < count; i++) {
+    records[i] = wdStore.records[(first + i) % WD_RECORDS];
+  }
+  WD_UNLOCK();
+  return count;
+}
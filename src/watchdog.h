@@ -0,0 +1,101 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Loop-stall watchdog
+ *
+ * The loop calls watchdogEnter() before each of its steps, naming the
+ * section about to run; that both feeds the watchdog and tells it whom
+ * to blame. A section that runs longer than WD_STALL_THRESHOLD is
+ * recorded as a stall: section, boot number, start time and duration.
+ *
+ * Stalls are caught in two places. watchdogEnter() closes a stall when
+ * the slow section finally returns. A check from outside the loop opens
+ * the record while the stall is still going on, so a stall that never
+ * ends is on record before the reset that follows:
+ *
+ * - AVR: the watchdog timer in interrupt and reset mode. The first
+ *   timeout records the stall, the second one resets the board.
+ * - ESP32: a Ticker, which runs on the esp_timer task.
+ * - ESP8266: timers only run when the loop yields, so nothing can watch
+ *   a stuck loop. The core's software watchdog resets it after about
+ *   three seconds, and the crash callback records the section just
+ *   before that reset.
+ *
+ * The state and the last WD_RECORDS stalls live in memory that survives
+ * a reset: .noinit RAM on AVR, RTC slow memory on ESP32 and RTC user
+ * memory on ESP8266. ESP8266 copies them there only when a record
+ * changes. watchdogBegin() validates them at boot, attributes a
+ * watchdog or panic reset to the section that was running and prints
+ * the records. /api/diag serves them.
+ */
+
+#ifndef WATCHDOG_H
+#define WATCHDOG_H
+
+#include <Arduino.h>
+
+// Loop sections, the culprits of a stall
+enum WatchdogSection : uint8_t {
+  WD_IDLE,        // Between sections, never blamed
+  WD_SETUP,
+  WD_WEB,
+  WD_WIFI,
+  WD_RDS,
+  WD_INPUT,
+  WD_TUNING,
+  WD_SEEK,
+  WD_SCAN,
+  WD_PREVIEW,
+  WD_SURVEY,
+  WD_SIGNAL,
+  WD_HISTORY,
+  WD_MEMSTATS,
+  WD_DISPLAY,
+  WD_SECTIONS
+};
+
+// A section running longer than this is a stall, ms
+const unsigned long WD_STALL_THRESHOLD = 1000;
+// Stall records kept across resets
+const uint8_t WD_RECORDS = 4;
+
+// StallRecord flags
+const uint8_t WD_STALL_OPEN = 0x01;    // Still going on when last checked
+const uint8_t WD_STALL_RESET = 0x02;   // Ended by a reset
+
+/**
+ * @brief One recorded loop stall
+ */
+struct StallRecord {
+  uint8_t section;        // WatchdogSection running
+  uint8_t flags;
+  uint16_t boot;          // Boot number it happened in
+  uint32_t start;         // millis() when the section was entered
+  uint32_t duration;      // ms, 0 if the reset came before any check
+};
+
+void watchdogBegin();
+void watchdogStart();
+void watchdogEnter(WatchdogSection section);
+const __FlashStringHelper *watchdogSectionName(uint8_t section);
+uint8_t watchdogSection();
+uint16_t watchdogBoot();
+uint8_t watchdogRecords(StallRecord *records);
+
+#endif // WATCHDOG_H
@@ -0,0 +1,160 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Event ring and encoder stress test (env:native)
+ *
+ * A producer thread stands for the interrupt handler and the test thread
+ * for the loop, running truly in parallel: the ring must hand over every
+ * event once and in order, and the encoder must lose no detent and no
+ * phase, however far behind the loop falls.
+ *
+ *   pio test -e native -f test_eventring
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include <atomic>
+#include <thread>
+
+#include "sim.h"
+#include "eventring.h"
+
+// Firmware under test (src/main.cpp)
+extern uint16_t currentFrequency;
+extern uint16_t tuneTarget;
+extern bool tunePending;
+extern EventRing<InputEvent, 32> inputEvents;
+void handleEncoder(unsigned long currentMillis);
+
+// Encoder pins (BoardSim in src/board.h)
+const uint8_t PIN_ENC_A = 16;
+const uint8_t PIN_ENC_B = 17;
+
+const uint32_t RING_EVENTS = 2000000;
+const int ENCODER_ROUNDS = 20000;
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+void test_ring_threads() {
+  EventRing<uint32_t, 16> ring;
+  std::atomic<bool> done(false);
+  uint32_t full = 0;
+
+  std::thread producer([&]() {
+    for (uint32_t i = 1; i <= RING_EVENTS; ) {
+      if (ring.push(i)) {
+        i++;
+      } else {
+        full++;
+        std::this_thread::yield();
+      }
+    }
+    done = true;
+  });
+
+  uint32_t expected = 1;
+  uint32_t value;
+  bool ordered = true;
+  for (bool last = false; !last; ) {
+    last = done;
+    while (ring.pop(value)) {
+      if (value != expected) ordered = false;
+      expected = value + 1;
+    }
+    std::this_thread::yield();
+  }
+  producer.join();
+
+  TEST_ASSERT_TRUE(ordered);
+  TEST_ASSERT_EQUAL_UINT32(RING_EVENTS + 1, expected);
+  TEST_ASSERT_EQUAL_UINT16((uint16_t)full, ring.overflows());
+}
+
+/**
+ * @brief Drive the phases through one detent, from the producer thread
+ *
+ * Every other edge bounces, which the transition table has to cancel.
+ */
+void turn(int dir) {
+  static const uint8_t cw[4] = {0x01, 0x00, 0x02, 0x03};   // AB after each edge
+  static const uint8_t ccw[4] = {0x02, 0x00, 0x01, 0x03};
+  const uint8_t *seq = dir > 0 ? cw : ccw;
+  uint8_t prev = 0x03;
+  for (uint8_t e = 0; e < 4; e++) {
+    if (e & 1) {
+      uint8_t changed = prev ^ seq[e];
+      uint8_t pin = changed & 0x02 ? PIN_ENC_A : PIN_ENC_B;
+      bool level = seq[e] & changed;
+      simSetPin(pin, level);
+      simSetPin(pin, !level);
+    }
+    simSetPin(PIN_ENC_A, seq[e] & 0x02);
+    simSetPin(PIN_ENC_B, seq[e] & 0x01);
+    prev = seq[e];
+  }
+}
+
+void test_encoder_threads() {
+  // Mid band, far from the wrap around at the edges
+  const uint16_t start = 9800;
+  currentFrequency = start;
+  tunePending = false;
+  uint16_t overflows = inputEvents.overflows();
+  std::atomic<bool> done(false);
+
+  // Back and forth, then five detents up
+  std::thread producer([&]() {
+    for (int r = 0; r < ENCODER_ROUNDS; r++) {
+      for (int i = 0; i < 3; i++) turn(+1);
+      for (int i = 0; i < 3; i++) turn(-1);
+    }
+    for (int i = 0; i < 5; i++) turn(+1);
+    done = true;
+  });
+
+  // Detents 100 ms apart, so each one is a 100 kHz step
+  unsigned long now = millis();
+  for (bool last = false; !last; ) {
+    last = done;
+    now += 100;
+    handleEncoder(now);
+    std::this_thread::yield();
+  }
+  producer.join();
+  handleEncoder(now + 100);
+
+  TEST_ASSERT_TRUE(tunePending);
+  TEST_ASSERT_EQUAL_UINT16(start + 5 * 10, tuneTarget);
+  printf("ring full %u times\n", (uint16_t)(inputEvents.overflows() - overflows));
+}
+
+int main() {
+  simSerialEcho(false);
+  setup();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_ring_threads);
+  RUN_TEST(test_encoder_threads);
+  return UNITY_END();
+}
@@ -0,0 +1,134 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Integer formatting test (env:native)
+ *
+ * The format.h writers replace printf in the firmware: each must give
+ * the same text as the printf format it stands for, return its length
+ * and write nothing past the terminator. The 16 bit writers are checked
+ * over every input; formatUnsigned() over every 24 bit value, every
+ * decade boundary and a sweep across the rest of the 32 bit range.
+ *
+ *   pio test -e native -f test_format
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include "format.h"
+
+// Guard bytes past the documented buffer size
+const uint8_t GUARD = 4;
+const char FILL = '\x55';
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+/**
+ * @brief Compare one formatted value with its printf reference
+ *
+ * Stops at the first mismatch, with the value in the message.
+ */
+static bool checkFormat(const char *expected, const char *buf, uint8_t len, uint8_t size,
+                        unsigned long value) {
+  char msg[48];
+  snprintf(msg, sizeof(msg), "value %lu", value);
+  size_t want = strlen(expected);
+  if (len != want || strcmp(buf, expected) != 0) {
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(expected, buf, msg);
+    TEST_ASSERT_EQUAL_MESSAGE(want, len, msg);
+    return false;
+  }
+  for (uint8_t i = size; i < size + GUARD; i++) {
+    if (buf[i] != FILL) {
+      TEST_FAIL_MESSAGE(msg);
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool checkUnsigned(unsigned long value) {
+  char buf[FORMAT_UNSIGNED_SIZE + GUARD];
+  char expected[24];
+  memset(buf, FILL, sizeof(buf));
+  snprintf(expected, sizeof(expected), "%lu", value);
+  uint8_t len = formatUnsigned(buf, value);
+  return checkFormat(expected, buf, len, FORMAT_UNSIGNED_SIZE, value);
+}
+
+/**
+ * @brief formatUnsigned() against "%lu"
+ */
+void test_unsigned() {
+  for (unsigned long value = 0; value < 0x1000000UL; value++) {
+    if (!checkUnsigned(value)) return;
+  }
+  // Each decade boundary up to the 32 bit maximum
+  for (unsigned long decade = 10; decade <= 1000000000UL; decade *= 10) {
+    if (!checkUnsigned(decade - 1) || !checkUnsigned(decade) || !checkUnsigned(decade + 1)) return;
+  }
+  // The rest of the 32 bit range, with a stride prime to ten
+  for (unsigned long value = 0x1000000UL; value <= 0xFFFFFFFFUL - 997; value += 997) {
+    if (!checkUnsigned(value)) return;
+  }
+  checkUnsigned(0xFFFFFFFFUL);
+}
+
+/**
+ * @brief formatFrequency() against "%u.%u" of MHz and 100 kHz
+ */
+void test_frequency() {
+  for (uint32_t value = 0; value <= 0xFFFF; value++) {
+    char buf[FORMAT_FREQUENCY_SIZE + GUARD];
+    char expected[16];
+    memset(buf, FILL, sizeof(buf));
+    snprintf(expected, sizeof(expected), "%u.%u", (unsigned)(value / 100), (unsigned)(value % 100) / 10);
+    uint8_t len = formatFrequency(buf, value);
+    if (!checkFormat(expected, buf, len, FORMAT_FREQUENCY_SIZE, value)) return;
+  }
+}
+
+/**
+ * @brief formatHex4() against "%04X"
+ */
+void test_hex4() {
+  for (uint32_t value = 0; value <= 0xFFFF; value++) {
+    char buf[FORMAT_HEX4_SIZE + GUARD];
+    char expected[8];
+    memset(buf, FILL, sizeof(buf));
+    snprintf(expected, sizeof(expected), "%04X", (unsigned)value);
+    uint8_t len = formatHex4(buf, value);
+    if (!checkFormat(expected, buf, len, FORMAT_HEX4_SIZE, value)) return;
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_unsigned);
+  RUN_TEST(test_frequency);
+  RUN_TEST(test_hex4);
+  return UNITY_END();
+}
@@ -0,0 +1,301 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Scripted input test (env:native)
+ *
+ * Runs the firmware on the virtual clock of lib/sim and drives it the way
+ * a user would: buttons, the encoder and HTTP requests. Each test checks
+ * the state the input leads to (tuner registers, radio state, responses)
+ * and how long it took to reach the display or the browser. Timings are
+ * deterministic, so the bounds are tight.
+ *
+ *   pio test -e native -f test_harness
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "sim.h"
+#include "simtuner.h"
+#include "trace.h"
+
+#include <fstream>
+#include <sstream>
+
+// Firmware state under test (src/main.cpp)
+extern uint16_t currentFrequency;
+extern bool radioOn;
+
+// Board pins (BoardSim in src/board.h)
+const uint8_t PIN_UP = 12;
+const uint8_t PIN_OK = 27;
+const uint8_t PIN_ENC_A = 16;
+const uint8_t PIN_ENC_B = 17;
+
+// Firmware timing (src/main.cpp)
+const unsigned long LOOP_MS = 10;          // delay() at the end of loop()
+const unsigned long DEBOUNCE_MS = 20;
+const unsigned long REPEAT_DELAY_MS = 400;
+const unsigned long REPEAT_INTERVAL_MS = 120;
+
+// Chrome trace of the run, in the project directory
+const char *const TRACE_FILE = "trace.json";
+
+void setUp() {
+  // Start each test from an idle loop
+  simRun(100);
+}
+
+void tearDown() {
+}
+
+/**
+ * @brief Latency of the last scripted input with this label
+ */
+const SimLatency &lastInput(const char *label) {
+  const std::vector<SimLatency> &log = simLatencies();
+  for (size_t i = log.size(); i > 0; i--) {
+    if (log[i - 1].label == label) return log[i - 1];
+  }
+  TEST_FAIL_MESSAGE(label);
+  return log.front();
+}
+
+/**
+ * @brief Press and release a button, holding it for ms
+ */
+void click(uint8_t pin, const char *label, unsigned long ms) {
+  simPress(pin, label);
+  simRun(ms);
+  simRelease(pin, NULL);
+  simRun(50);
+}
+
+/**
+ * @brief Get a number following key in a response body, -1 if missing
+ */
+long bodyNumber(const std::string &body, const char *key, size_t from = 0) {
+  size_t at = body.find(key, from);
+  if (at == std::string::npos) return -1;
+  return atol(body.c_str() + at + strlen(key));
+}
+
+void test_boot() {
+  TEST_ASSERT_TRUE(radioOn);
+  TEST_ASSERT_EQUAL_UINT16(currentFrequency, simTunerFrequency());
+  TEST_ASSERT_FALSE(simTunerMuted());
+  TEST_ASSERT_EQUAL(5, simTunerVolume());
+  TEST_ASSERT_GREATER_OR_EQUAL(1, simFrames());
+  TEST_ASSERT_TRUE(simFrameText().find("ON") != std::string::npos);
+}
+
+void test_button_step() {
+  uint16_t before = currentFrequency;
+  click(PIN_UP, "up", 100);
+  TEST_ASSERT_EQUAL_UINT16(before + 10, currentFrequency);
+  TEST_ASSERT_EQUAL_UINT16(currentFrequency, simTunerFrequency());
+
+  // Debounced after DEBOUNCE_MS, drawn in the same loop pass: the press
+  // reaches the display within one more loop period
+  const SimLatency &up = lastInput("up");
+  TEST_ASSERT_GREATER_OR_EQUAL(0, up.display);
+  int64_t latency = up.display - (int64_t)up.at;
+  TEST_ASSERT_GREATER_OR_EQUAL(DEBOUNCE_MS * 1000, latency);
+  TEST_ASSERT_LESS_OR_EQUAL((DEBOUNCE_MS + 2 * LOOP_MS) * 1000, latency);
+}
+
+void test_button_repeat() {
+  uint16_t before = currentFrequency;
+  // One step, then the auto-repeat steps every REPEAT_INTERVAL_MS, all
+  // 100 kHz until repeatFastAfter
+  unsigned long hold = 1000;
+  click(PIN_UP, "up hold", hold);
+  unsigned long repeats = (currentFrequency - before) / 10 - 1;
+  unsigned long most = (hold - DEBOUNCE_MS - REPEAT_DELAY_MS) / REPEAT_INTERVAL_MS + 1;
+  TEST_ASSERT_LESS_OR_EQUAL(most, repeats);
+  TEST_ASSERT_GREATER_OR_EQUAL(most - 1, repeats);
+  TEST_ASSERT_EQUAL_UINT16(currentFrequency, simTunerFrequency());
+}
+
+void test_ok_toggles_power() {
+  click(PIN_OK, "ok", 100);
+  TEST_ASSERT_FALSE(radioOn);
+  TEST_ASSERT_TRUE(simTunerMuted());
+  TEST_ASSERT_TRUE(simFrameText().find("OFF") != std::string::npos);
+
+  click(PIN_OK, "ok", 100);
+  TEST_ASSERT_TRUE(radioOn);
+  TEST_ASSERT_FALSE(simTunerMuted());
+  TEST_ASSERT_EQUAL_UINT16(currentFrequency, simTunerFrequency());
+}
+
+void test_encoder_step() {
+  // A lone detent is a 100 kHz step
+  uint16_t before = currentFrequency;
+  simEncoder(PIN_ENC_A, PIN_ENC_B, 1, "encoder");
+  simRun(50);
+  TEST_ASSERT_EQUAL_UINT16(before + 10, currentFrequency);
+  TEST_ASSERT_EQUAL_UINT16(currentFrequency, simTunerFrequency());
+  TEST_ASSERT_LESS_OR_EQUAL(2 * LOOP_MS * 1000, lastInput("encoder").display - (int64_t)lastInput("encoder").at);
+
+  // Two detents 15 ms apart: the second one is a 1 MHz step
+  simRun(200);
+  before = currentFrequency;
+  simEncoder(PIN_ENC_A, PIN_ENC_B, 1, NULL);
+  simRun(15);
+  simEncoder(PIN_ENC_A, PIN_ENC_B, 1, NULL);
+  simRun(50);
+  TEST_ASSERT_EQUAL_UINT16(before + 10 + 100, currentFrequency);
+}
+
+void test_encoder_blocked_loop() {
+  // Detents turned while loop() does not run are all counted once it
+  // does, and come out as one retune; 40 detents overflow the event ring
+  simRun(200);
+  uint16_t before = currentFrequency;
+  unsigned long frames = simFrames();
+  simEncoder(PIN_ENC_A, PIN_ENC_B, 40, "encoder blocked");
+  simRun(50);
+  TEST_ASSERT_EQUAL_UINT16(before + 40 * 10, currentFrequency);
+  TEST_ASSERT_EQUAL_UINT16(currentFrequency, simTunerFrequency());
+  TEST_ASSERT_LESS_OR_EQUAL(frames + 2, simFrames());
+}
+
+void test_encoder_half_detent() {
+  // Half a detent, a loop pass, then the other half: one step, the
+  // phase kept across the passes
+  simRun(200);
+  uint16_t before = currentFrequency;
+  simSetPin(PIN_ENC_A, LOW);
+  simSetPin(PIN_ENC_B, LOW);
+  simRun(50);
+  TEST_ASSERT_EQUAL_UINT16(before, currentFrequency);
+  simSetPin(PIN_ENC_A, HIGH);
+  simSetPin(PIN_ENC_B, HIGH);
+  simRun(50);
+  TEST_ASSERT_EQUAL_UINT16(before + 10, currentFrequency);
+}
+
+void test_http_up() {
+  uint16_t before = currentFrequency;
+  simRequest("/up");
+  simRun(50);
+  const SimResponse &response = simLastResponse();
+  TEST_ASSERT_EQUAL(303, response.code);
+  TEST_ASSERT_EQUAL_STRING("/", response.location.c_str());
+  TEST_ASSERT_EQUAL_UINT16(before + 10, currentFrequency);
+  TEST_ASSERT_EQUAL_UINT16(currentFrequency, simTunerFrequency());
+
+  // Served in the next loop pass, the retune drawn in that same pass
+  const SimLatency &up = lastInput("/up");
+  TEST_ASSERT_LESS_OR_EQUAL(LOOP_MS * 1000 + 1000, up.response - (int64_t)up.at);
+  TEST_ASSERT_LESS_OR_EQUAL(2 * LOOP_MS * 1000, up.display - (int64_t)up.at);
+}
+
+void test_http_status() {
+  simRequest("/api/status");
+  simRun(20);
+  const SimResponse &response = simLastResponse();
+  TEST_ASSERT_EQUAL(200, response.code);
+  TEST_ASSERT_EQUAL_STRING("application/json", response.type.c_str());
+  char freqStr[32];
+  snprintf(freqStr, sizeof(freqStr), "\"frequency\":%u.%u", currentFrequency / 100, currentFrequency % 100 / 10);
+  TEST_ASSERT_TRUE(response.body.find(freqStr) != std::string::npos);
+  TEST_ASSERT_TRUE(response.body.find("\"on\":true") != std::string::npos);
+}
+
+void test_http_toggle() {
+  simRequest("/toggle");
+  simRun(20);
+  TEST_ASSERT_EQUAL(303, simLastResponse().code);
+  TEST_ASSERT_FALSE(radioOn);
+  TEST_ASSERT_TRUE(simTunerMuted());
+
+  simRequest("/toggle");
+  simRun(20);
+  TEST_ASSERT_TRUE(radioOn);
+  TEST_ASSERT_FALSE(simTunerMuted());
+}
+
+void test_http_not_found() {
+  simRequest("/nothing");
+  simRun(20);
+  TEST_ASSERT_EQUAL(404, simLastResponse().code);
+}
+
+void test_firmware_latency() {
+  // The firmware measures from noteInput() in the handler to the redraw,
+  // the harness from the request: they differ by the wait for the loop
+  // pass serving it
+  simRequest("/up");
+  simRun(50);
+  const SimLatency &up = lastInput("/up");
+  int64_t seen = up.display - (int64_t)up.at;
+  simRequest("/api/diag");
+  simRun(20);
+  const std::string &body = simLastResponse().body;
+  size_t input = body.find("\"input\":");
+  TEST_ASSERT_TRUE(input != std::string::npos);
+  TEST_ASSERT_GREATER_THAN(0, bodyNumber(body, "\"count\":", input));
+  long last = bodyNumber(body, "\"last\":", input);
+  TEST_ASSERT_LESS_OR_EQUAL(seen, last);
+  TEST_ASSERT_GREATER_OR_EQUAL(seen - (int64_t)(LOOP_MS + 1) * 1000, last);
+  // Inputs left without a redraw are dropped after a second
+  TEST_ASSERT_LESS_OR_EQUAL(1000000, bodyNumber(body, "\"max\":", input));
+}
+
+void test_trace_file() {
+  // The document /api/trace serves, one entry per event in the ring
+  TEST_ASSERT_TRUE(traceWriteFile(TRACE_FILE));
+  std::ifstream in(TRACE_FILE);
+  std::stringstream buf;
+  buf << in.rdbuf();
+  const std::string json = buf.str();
+  TEST_ASSERT_TRUE(json.rfind("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[{", 0) == 0);
+  TEST_ASSERT_TRUE(json.find("\"name\":\"render\"") != std::string::npos);
+  TEST_ASSERT_EQUAL_STRING("}]}", json.substr(json.size() - 3).c_str());
+  size_t events = 0;
+  for (size_t at = json.find("\"ph\":"); at != std::string::npos; at = json.find("\"ph\":", at + 1)) events++;
+  TEST_ASSERT_EQUAL(traceCount(), events);
+}
+
+int main() {
+  simSerialEcho(false);
+  setup();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_boot);
+  RUN_TEST(test_button_step);
+  RUN_TEST(test_button_repeat);
+  RUN_TEST(test_ok_toggles_power);
+  RUN_TEST(test_encoder_step);
+  RUN_TEST(test_encoder_blocked_loop);
+  RUN_TEST(test_encoder_half_detent);
+  RUN_TEST(test_http_up);
+  RUN_TEST(test_http_status);
+  RUN_TEST(test_http_toggle);
+  RUN_TEST(test_http_not_found);
+  RUN_TEST(test_firmware_latency);
+  RUN_TEST(test_trace_file);
+  int failures = UNITY_END();
+
+  simReport(stdout);
+  printf("Chrome trace written to %s\n", TRACE_FILE);
+  return failures;
+}
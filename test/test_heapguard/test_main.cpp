@@ -0,0 +1,147 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Static allocation profile test (env:native_static)
+ *
+ * Built with ENABLE_STATIC_ALLOC and the allocator wrapped, as the
+ * *_static environments are. The firmware is driven through every
+ * route, the buttons and the encoder, and the allocation counters of
+ * src/heapguard.h must then account only for the web server library:
+ * its allocations (request parsing, response headers) are counted by
+ * the stand-in in lib/sim, and no section may have any other.
+ *
+ *   pio test -e native_static
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "sim.h"
+#include "heapguard.h"
+
+// Board pins (BoardSim in src/board.h)
+const uint8_t PIN_UP = 12;
+const uint8_t PIN_DOWN = 14;
+const uint8_t PIN_OK = 27;
+const uint8_t PIN_ENC_A = 16;
+const uint8_t PIN_ENC_B = 17;
+
+// Every route, with the arguments the web page sends
+const char *const ROUTES[] = {
+  "/",
+  "/up",
+  "/down",
+  "/seekup",
+  "/seekdown",
+  "/toggle",
+  "/toggle",
+  "/api/status",
+  "/scan",
+  "/preview?dwell=2",
+  "/metrics",
+  "/api/diag",
+#if defined(ENABLE_TRACE)
+  "/api/trace",
+#endif
+#if defined(ENABLE_SURVEY)
+  "/api/survey?interval=60",
+  "/api/survey",
+#endif
+  "/nothing",
+};
+
+HeapGuardStats before;
+unsigned long libraryBefore;
+
+void setUp() {
+  simRun(100);
+  before = heapguardStats();
+  libraryBefore = simLibraryAllocs();
+}
+
+void tearDown() {
+}
+
+/**
+ * @brief Check that the allocations since setUp() are all the library's
+ */
+void assertOnlyLibrary() {
+  const HeapGuardStats &heap = heapguardStats();
+  unsigned long library = simLibraryAllocs() - libraryBefore;
+  for (uint8_t s = 0; s < WD_SECTIONS; s++) {
+    unsigned long count = heap.sections[s] - before.sections[s];
+    if (s == WD_WEB) {
+      TEST_ASSERT_EQUAL_MESSAGE(library, count, watchdogSectionName(s));
+    } else {
+      TEST_ASSERT_EQUAL_MESSAGE(0, count, watchdogSectionName(s));
+    }
+  }
+}
+
+void test_idle() {
+  simRun(5000);
+  assertOnlyLibrary();
+}
+
+void test_inputs() {
+  simPress(PIN_UP, "up hold");
+  simRun(1000);
+  simRelease(PIN_UP, NULL);
+  simRun(100);
+  simPress(PIN_DOWN, "down");
+  simRun(100);
+  simRelease(PIN_DOWN, NULL);
+  simRun(100);
+  simEncoder(PIN_ENC_A, PIN_ENC_B, 40, "encoder");
+  simRun(100);
+  simEncoder(PIN_ENC_A, PIN_ENC_B, -40, "encoder");
+  simRun(100);
+  simPress(PIN_OK, "ok");
+  simRun(100);
+  simRelease(PIN_OK, NULL);
+  simRun(100);
+  simPress(PIN_OK, "ok");
+  simRun(100);
+  simRelease(PIN_OK, NULL);
+  simRun(1000);
+  assertOnlyLibrary();
+}
+
+void test_routes() {
+  for (const char *route : ROUTES) {
+    simRequest(route);
+    simRun(100);
+  }
+  // Let the seeks, the scan and the preview run their course
+  simRun(30000);
+  assertOnlyLibrary();
+  // The library does allocate, so the test would see a lost count
+  TEST_ASSERT_GREATER_THAN(0, simLibraryAllocs() - libraryBefore);
+}
+
+int main() {
+  simSerialEcho(false);
+  setup();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_idle);
+  RUN_TEST(test_inputs);
+  RUN_TEST(test_routes);
+  return UNITY_END();
+}
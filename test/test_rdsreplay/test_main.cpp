@@ -0,0 +1,401 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * RDS capture replay (env:native_rds)
+ *
+ * A station is put on the air through the RDA5807M register model, the
+ * firmware records it with /api/rdscapture and the download is replayed
+ * group by group, at the captured pace, into the chip registers of a
+ * freshly tuned receiver. The firmware decodes the replay on its own
+ * RDS path (checkRDSData() and the driver), and the test reports, as
+ * tools/rdsreplay.py does for its reference decoder, the groups per
+ * second and the time from tuning to a complete PS and RT.
+ *
+ * Captures downloaded from a device are replayed the same way when
+ * their paths are listed in RDS_REPLAY (separated by spaces):
+ *
+ *   RDS_REPLAY="capture.bin" pio test -e native_rds
+ *
+ * The preview hops and the band survey's RDS probe are checked here
+ * too, with a second RDS station on the air: the driver stand-in, like
+ * the library, keeps the decoded data across a tune, so neither may show
+ * or store the previous channel's PS for the one it tunes.
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include <fstream>
+#include <sstream>
+
+#include "sim.h"
+#include "simtuner.h"
+#include "rdscapture.h"
+
+// Firmware state under test (src/main.cpp)
+extern uint16_t currentFrequency;
+extern char rdsProgramService[9];
+extern char rdsRadioText[65];
+extern unsigned int rdsPI;
+void tunerSetFrequency(uint16_t frequency);
+void resetRdsData();
+bool tunerBusy();
+
+// The station on the air, a default station of lib/sim/simtuner.cpp
+const uint16_t STATION = 10110;
+const uint16_t STATION_PI = 0xC201;
+const uint8_t STATION_PTY = 10;
+const char STATION_PS[] = "SIM FM  ";
+const char STATION_RT[] = "Replayed through the firmware RDS path\r";
+const uint8_t RT_SEGMENTS = (sizeof(STATION_RT) - 1 + 3) / 4;
+// A group takes 87.6 ms on air
+const unsigned long GROUP_US = 87600;
+const uint16_t GROUPS = 240;
+
+// A second station with RDS, a default station of lib/sim/simtuner.cpp
+const uint16_t OTHER = 9450;
+const uint16_t OTHER_PI = 0xC202;
+const char OTHER_PS[] = "OTHER FM";
+
+// Download of the live capture, replayed by the tests after it
+std::string capture;
+
+/**
+ * @brief Time from tuning to a complete PS and RT, -1 if never
+ */
+struct ReplayResult {
+  long psMs;
+  long rtMs;
+  uint16_t records;
+  unsigned long ms;
+};
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+/**
+ * @brief Tune the receiver afresh, as a hop between stations does
+ */
+void retune() {
+  currentFrequency = STATION;
+  tunerSetFrequency(STATION);
+  resetRdsData();
+  simRun(100);
+}
+
+/**
+ * @brief Blocks of the n-th group of the station: the four PS segments
+ * (0A), then the next RT segment (2A), over and over
+ */
+void stationGroup(uint16_t n, uint16_t *blocks) {
+  uint8_t slot = n % 5;
+  blocks[0] = STATION_PI;
+  if (slot < 4) {
+    blocks[1] = 0x0000 | STATION_PTY << 5 | slot;
+    blocks[2] = 0xE0CD;               // AF: two frequencies follow
+    blocks[3] = (uint8_t)STATION_PS[slot * 2] << 8 | (uint8_t)STATION_PS[slot * 2 + 1];
+  } else {
+    uint8_t seg = (n / 5) % RT_SEGMENTS;
+    char chars[4];
+    for (uint8_t i = 0; i < 4; i++) {
+      uint8_t pos = seg * 4 + i;
+      chars[i] = pos < sizeof(STATION_RT) - 1 ? STATION_RT[pos] : ' ';
+    }
+    blocks[1] = 0x2000 | STATION_PTY << 5 | seg;
+    blocks[2] = (uint8_t)chars[0] << 8 | (uint8_t)chars[1];
+    blocks[3] = (uint8_t)chars[2] << 8 | (uint8_t)chars[3];
+  }
+}
+
+/**
+ * @brief Note when a decoded text is complete: when it first reads as
+ * expected, or without an expected text when it last changed
+ */
+void watch(long &at, std::string &last, const char *text, const char *expected, long ms) {
+  if (expected) {
+    if (at < 0 && strcmp(text, expected) == 0) at = ms;
+  } else if (last != text) {
+    last = text;
+    at = ms;
+  }
+}
+
+/**
+ * @brief Replay a capture into the chip registers at its captured pace
+ *
+ * @param ps, rt Expected PS and RT, NULL to time the last change
+ */
+ReplayResult replay(const std::string &data, const char *ps, const char *rt) {
+  ReplayResult result = {-1, -1, 0, 0};
+  RdsCaptureHeader header;
+  TEST_ASSERT_GREATER_OR_EQUAL(sizeof(header), data.size());
+  memcpy(&header, data.data(), sizeof(header));
+  TEST_ASSERT_EQUAL_MEMORY("RDS", header.magic, 3);
+  TEST_ASSERT_EQUAL(RDS_CAPTURE_VERSION, header.version);
+  TEST_ASSERT_EQUAL(sizeof(RdsCaptureRecord), header.recordSize);
+  TEST_ASSERT_EQUAL(sizeof(header) + (size_t)header.records * sizeof(RdsCaptureRecord), data.size());
+
+  retune();
+  uint64_t tuned = simMicros();
+  std::string lastPs, lastRt;
+  uint64_t due = tuned + header.first * 1000ULL;
+  for (uint16_t i = 0; i <= header.records; i++) {
+    RdsCaptureRecord rec;
+    if (i < header.records) {
+      memcpy(&rec, data.data() + sizeof(header) + i * sizeof(rec), sizeof(rec));
+      due += rec.delta * 1000ULL;
+    } else {
+      // The last group stays on the air for a group time
+      due += GROUP_US;
+    }
+    // Run up to the group in loop periods, watching the firmware; the
+    // schedule is absolute, so loop passes do not stretch it
+    while (simMicros() < due) {
+      simRun(10);
+      long ms = (simMicros() - tuned) / 1000;
+      watch(result.psMs, lastPs, rdsProgramService, ps, ms);
+      watch(result.rtMs, lastRt, rdsRadioText, rt, ms);
+    }
+    if (i == header.records) break;
+    uint16_t blocks[4];
+    memcpy(blocks, rec.blocks, sizeof(blocks));
+    simTunerRdsGroup(blocks, rec.errors >> 6, (rec.errors >> 4) & 3);
+  }
+  result.records = header.records;
+  result.ms = (simMicros() - tuned) / 1000;
+  return result;
+}
+
+/**
+ * @brief Print one JSON line per replay, as tools/rdsreplay.py does
+ */
+void report(const char *file, const ReplayResult &r) {
+  printf("{\"file\":\"%s\",\"records\":%u,\"seconds\":%.1f,\"groupsPerSecond\":%.1f,",
+         file, r.records, r.ms / 1000.0, r.ms ? r.records * 1000.0 / r.ms : 0.0);
+  printf("\"psMs\":%ld,\"rtMs\":%ld,\"ps\":\"%s\",\"rt\":\"%s\"}\n",
+         r.psMs, r.rtMs, rdsProgramService, rdsRadioText);
+}
+
+void test_live_capture() {
+  retune();
+  simRequest("/api/rdscapture?start=1");
+  simRun(20);
+  uint16_t blocks[4];
+  uint64_t onAir = simMicros();
+  for (uint16_t n = 0; n < GROUPS; n++) {
+    stationGroup(n, blocks);
+    simTunerRdsGroup(blocks, 0, 0);
+    onAir += GROUP_US;
+    simRun((onAir - simMicros() + 999) / 1000);
+  }
+  // The firmware decoded the station live
+  TEST_ASSERT_EQUAL_STRING(STATION_PS, rdsProgramService);
+  TEST_ASSERT_EQUAL_UINT16(STATION_PI, rdsPI);
+
+  simRequest("/api/rdscapture?stop=1");
+  simRun(20);
+  simRequest("/api/rdscapture?format=raw");
+  simRun(20);
+  TEST_ASSERT_EQUAL(200, simLastResponse().code);
+  capture = simLastResponse().body;
+
+  RdsCaptureHeader header;
+  memcpy(&header, capture.data(), sizeof(header));
+  TEST_ASSERT_EQUAL_UINT16(STATION, header.frequency);
+  TEST_ASSERT_EQUAL_UINT16(GROUPS, header.records);
+  TEST_ASSERT_EQUAL_UINT16(0, header.dropped);
+}
+
+void test_wrapped_capture() {
+  retune();
+  simRequest("/api/rdscapture?start=1");
+  simRun(20);
+  uint64_t start = simMicros();
+  uint64_t onAir = start;
+  uint16_t overrun = 40;
+  uint16_t blocks[4];
+  for (uint16_t n = 0; n < RDS_CAPTURE_RECORDS + overrun; n++) {
+    stationGroup(n, blocks);
+    simTunerRdsGroup(blocks, 0, 0);
+    onAir += GROUP_US;
+    simRun((onAir - simMicros() + 999) / 1000);
+  }
+  simRequest("/api/rdscapture?stop=1");
+  simRun(20);
+  simRequest("/api/rdscapture?format=raw");
+  simRun(20);
+  std::string data = simLastResponse().body;
+
+  RdsCaptureHeader header;
+  memcpy(&header, data.data(), sizeof(header));
+  TEST_ASSERT_EQUAL_UINT16(RDS_CAPTURE_RECORDS, header.records);
+  TEST_ASSERT_EQUAL_UINT16(overrun, header.dropped);
+  // The delay of the oldest record kept is in the header, not in it
+  RdsCaptureRecord rec;
+  memcpy(&rec, data.data() + sizeof(header), sizeof(rec));
+  TEST_ASSERT_EQUAL_UINT16(0, rec.delta);
+  unsigned long group = GROUP_US / 1000;
+  TEST_ASSERT_GREATER_OR_EQUAL(overrun * group, header.first);
+  TEST_ASSERT_LESS_OR_EQUAL((overrun + 2) * group, header.first);
+}
+
+void test_replay_firmware() {
+  TEST_ASSERT_FALSE(capture.empty());
+  std::string rt(STATION_RT, sizeof(STATION_RT) - 2);
+  ReplayResult r = replay(capture, STATION_PS, rt.c_str());
+  report("live", r);
+  TEST_ASSERT_EQUAL_STRING(STATION_PS, rdsProgramService);
+  TEST_ASSERT_EQUAL_STRING(rt.c_str(), rdsRadioText);
+  // No group lost: the PS is complete within a group time of its last
+  // segment going on the air (group 3), the RT of its own (group 49)
+  unsigned long group = GROUP_US / 1000;
+  unsigned long psLast = 3;
+  unsigned long rtLast = 5 * (RT_SEGMENTS - 1) + 4;
+  TEST_ASSERT_GREATER_OR_EQUAL(psLast * group, r.psMs);
+  TEST_ASSERT_LESS_OR_EQUAL((psLast + 1) * group, r.psMs);
+  TEST_ASSERT_GREATER_OR_EQUAL(rtLast * group, r.rtMs);
+  TEST_ASSERT_LESS_OR_EQUAL((rtLast + 1) * group, r.rtMs);
+}
+
+/**
+ * @brief PS of the station on a frequency, empty if it has no RDS
+ */
+const char *stationPs(uint16_t frequency) {
+  if (frequency == STATION) return STATION_PS;
+  if (frequency == OTHER) return OTHER_PS;
+  return "";
+}
+
+/**
+ * @brief Run the firmware with both RDS stations on the air, a group
+ * every group time on whichever of them is tuned
+ *
+ * @param watch Called after each loop period, NULL for none
+ */
+void runOnAir(unsigned long ms, void (*watch)() = NULL) {
+  uint64_t end = simMicros() + ms * 1000ULL;
+  uint64_t next = simMicros();
+  uint16_t n = 0;
+  while (simMicros() < end) {
+    if (simMicros() >= next) {
+      uint16_t blocks[4];
+      uint16_t tuned = simTunerFrequency();
+      if (tuned == STATION) {
+        stationGroup(n, blocks);
+        simTunerRdsGroup(blocks, 0, 0);
+      } else if (tuned == OTHER) {
+        uint8_t seg = n % 4;
+        blocks[0] = OTHER_PI;
+        blocks[1] = 0x0000 | seg;
+        blocks[2] = 0xE0CD;
+        blocks[3] = (uint8_t)OTHER_PS[seg * 2] << 8 | (uint8_t)OTHER_PS[seg * 2 + 1];
+        simTunerRdsGroup(blocks, 0, 0);
+      }
+      n++;
+      next += GROUP_US;
+    }
+    simRun(10);
+    if (watch) watch();
+  }
+}
+
+// Loop periods in which the firmware showed a PS not of the tuned station
+uint16_t foreignPs = 0;
+// Stations whose own PS was shown
+uint8_t psShown = 0;
+
+void watchPs() {
+  // A scan pass tunes away for a moment, the station stays current
+  if (tunerBusy()) return;
+  if (!rdsProgramService[0]) return;
+  if (strcmp(rdsProgramService, stationPs(currentFrequency)) != 0) foreignPs++;
+  else psShown |= currentFrequency == STATION ? 1 : 2;
+}
+
+void test_preview_hop() {
+  retune();
+  runOnAir(2000);
+  TEST_ASSERT_EQUAL_STRING(STATION_PS, rdsProgramService);
+  // Hop over the station list: each station shows its own PS or none
+  foreignPs = 0;
+  psShown = 0;
+  simRequest("/preview?dwell=2");
+  runOnAir(20000, watchPs);
+  simRequest("/preview?stop=1");
+  runOnAir(20);
+  TEST_ASSERT_EQUAL_UINT16(0, foreignPs);
+  TEST_ASSERT_EQUAL_UINT8(3, psShown);
+}
+
+void test_survey_probe() {
+  retune();
+  runOnAir(2000);
+  TEST_ASSERT_EQUAL_STRING(STATION_PS, rdsProgramService);
+  // One sweep, then the probe of the occupied channels
+  simRequest("/api/survey?start=1&interval=3600");
+  runOnAir(30000);
+  simRequest("/api/survey?stop=1");
+  runOnAir(20);
+  std::string body = simLastResponse().body;
+  // Each PS under its own channel, none on the channel without RDS
+  TEST_ASSERT_TRUE(body.find("{\"f\":94.5,") != std::string::npos);
+  std::string other = body.substr(body.find("{\"f\":94.5,"));
+  other = other.substr(0, other.find('}'));
+  TEST_ASSERT_TRUE_MESSAGE(other.find("\"ps\":\"OTHER FM\"") != std::string::npos, other.c_str());
+  std::string station = body.substr(body.find("{\"f\":101.1,"));
+  station = station.substr(0, station.find('}'));
+  TEST_ASSERT_TRUE_MESSAGE(station.find("\"ps\":\"SIM FM  \"") != std::string::npos, station.c_str());
+  std::string silent = body.substr(body.find("{\"f\":89.3,"));
+  silent = silent.substr(0, silent.find('}'));
+  TEST_ASSERT_TRUE_MESSAGE(silent.find("\"ps\"") == std::string::npos, silent.c_str());
+  // Back on the station, with its own PS
+  TEST_ASSERT_EQUAL_UINT16(STATION, simTunerFrequency());
+  TEST_ASSERT_EQUAL_STRING(STATION_PS, rdsProgramService);
+}
+
+void test_replay_files() {
+  const char *list = getenv("RDS_REPLAY");
+  if (!list) TEST_IGNORE_MESSAGE("RDS_REPLAY not set");
+  std::istringstream paths(list);
+  std::string path;
+  while (paths >> path) {
+    std::ifstream in(path, std::ios::binary);
+    TEST_ASSERT_TRUE_MESSAGE(in.good(), path.c_str());
+    std::stringstream data;
+    data << in.rdbuf();
+    report(path.c_str(), replay(data.str(), NULL, NULL));
+  }
+}
+
+int main() {
+  simSerialEcho(false);
+  setup();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_live_capture);
+  RUN_TEST(test_replay_firmware);
+  RUN_TEST(test_wrapped_capture);
+  RUN_TEST(test_preview_hop);
+  RUN_TEST(test_survey_probe);
+  RUN_TEST(test_replay_files);
+  return UNITY_END();
+}
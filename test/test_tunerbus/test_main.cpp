@@ -0,0 +1,193 @@
+/*
+ * FMWebRadio - FM Radio with Web Interface
+ * Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Tuner bus retry and recovery test (env:native)
+ *
+ * The simulated I2C bus NACKs transfers or has the tuner hold SDA low
+ * (lib/sim/sim.h); the tests check that tunerBusRun() retries the
+ * write, that a held bus gets the nine clock recovery and a STOP, and
+ * that the counters of src/tunerbus.h account for all of it.
+ *
+ *   pio test -e native -f test_tunerbus
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "sim.h"
+#include "simtuner.h"
+#include "tunerbus.h"
+
+// Firmware under test (src/main.cpp)
+extern uint16_t currentFrequency;
+void tunerSetFrequency(uint16_t frequency);
+
+// Wire.endTransmission() codes
+const uint8_t WIRE_NACK = 2;
+const uint8_t WIRE_TIMEOUT = 5;
+// Time of one recovery: 22 half periods of 5 us (tunerbus.cpp)
+const unsigned long RECOVERY_US = 22 * 5;
+
+TunerBusStats before;
+SimI2cStats busBefore;
+unsigned long attempts;
+
+void setUp() {
+  simI2cNack(0);
+  simI2cHoldSda(0);
+  simRun(100);
+  before = tunerBusStats();
+  busBefore = simI2cStats();
+  attempts = 0;
+}
+
+void tearDown() {
+  simI2cNack(0);
+  simI2cHoldSda(0);
+}
+
+/**
+ * @brief A tuner write that does no transfer of its own, so the faults
+ * only hit the bus checks
+ */
+void countAttempt() {
+  attempts++;
+}
+
+void test_nack_retried() {
+  simI2cNack(2);
+  TEST_ASSERT_TRUE(tunerBusRun(countAttempt));
+  TEST_ASSERT_EQUAL(3, attempts);
+
+  const TunerBusStats &bus = tunerBusStats();
+  TEST_ASSERT_EQUAL(before.errors + 2, bus.errors);
+  TEST_ASSERT_EQUAL(before.retries + 2, bus.retries);
+  TEST_ASSERT_EQUAL(before.failures, bus.failures);
+  TEST_ASSERT_EQUAL(before.recoveries, bus.recoveries);
+  TEST_ASSERT_EQUAL(WIRE_NACK, bus.lastError);
+  // A NACK on a free bus needs no recovery
+  TEST_ASSERT_EQUAL(busBefore.sclPulses, simI2cStats().sclPulses);
+  TEST_ASSERT_EQUAL(busBefore.begins, simI2cStats().begins);
+}
+
+void test_nack_gives_up() {
+  simSerialClear();
+  simI2cNack(TUNER_BUS_RETRIES + 1);
+  TEST_ASSERT_FALSE(tunerBusRun(countAttempt));
+  TEST_ASSERT_EQUAL(TUNER_BUS_RETRIES + 1, attempts);
+
+  const TunerBusStats &bus = tunerBusStats();
+  TEST_ASSERT_EQUAL(before.errors + TUNER_BUS_RETRIES + 1, bus.errors);
+  TEST_ASSERT_EQUAL(before.retries + TUNER_BUS_RETRIES, bus.retries);
+  TEST_ASSERT_EQUAL(before.failures + 1, bus.failures);
+  std::string out(simSerialOutput().begin(), simSerialOutput().end());
+  TEST_ASSERT_TRUE(out.find("Tuner I2C write failed, error 2") != std::string::npos);
+}
+
+void test_lost_write_repeated() {
+  // The write itself is NACKed, then the check: the retry writes again
+  uint16_t target = currentFrequency + 50;
+  simI2cNack(2);
+  tunerSetFrequency(target);
+  TEST_ASSERT_EQUAL_UINT16(target, simTunerFrequency());
+  TEST_ASSERT_EQUAL(before.errors + 1, tunerBusStats().errors);
+  TEST_ASSERT_EQUAL(before.retries + 1, tunerBusStats().retries);
+  tunerSetFrequency(currentFrequency);
+}
+
+void test_held_sda_recovered() {
+  // The tuner lets go after nine clocks: one recovery, then the write
+  // goes through
+  simI2cHoldSda(9);
+  TEST_ASSERT_TRUE(tunerBusRun(countAttempt));
+  TEST_ASSERT_EQUAL(2, attempts);
+  TEST_ASSERT_FALSE(simSdaHeld());
+
+  const SimI2cStats &sim = simI2cStats();
+  // Nine recovery clocks, and the STOP has SCL rise once more
+  TEST_ASSERT_EQUAL(busBefore.sclPulses + 9 + 1, sim.sclPulses);
+  TEST_ASSERT_EQUAL(busBefore.stops + 1, sim.stops);
+  TEST_ASSERT_EQUAL(busBefore.stuck + 1, sim.stuck);
+  TEST_ASSERT_EQUAL(busBefore.begins + 1, sim.begins);
+
+  const TunerBusStats &bus = tunerBusStats();
+  TEST_ASSERT_EQUAL(before.errors + 1, bus.errors);
+  TEST_ASSERT_EQUAL(before.retries + 1, bus.retries);
+  TEST_ASSERT_EQUAL(before.recoveries + 1, bus.recoveries);
+  TEST_ASSERT_EQUAL(WIRE_TIMEOUT, bus.lastError);
+  TEST_ASSERT_EQUAL(before.recoveryMicros + RECOVERY_US, bus.recoveryMicros);
+  TEST_ASSERT_GREATER_OR_EQUAL(RECOVERY_US, bus.recoveryMaxMicros);
+}
+
+void test_short_hold_fewer_clocks() {
+  // Clocking stops as soon as SDA is released
+  simI2cHoldSda(3);
+  TEST_ASSERT_TRUE(tunerBusRun(countAttempt));
+  TEST_ASSERT_EQUAL(busBefore.sclPulses + 3 + 1, simI2cStats().sclPulses);
+  TEST_ASSERT_EQUAL(busBefore.stops + 1, simI2cStats().stops);
+  TEST_ASSERT_EQUAL(before.recoveries + 1, tunerBusStats().recoveries);
+}
+
+void test_stuck_bus_gives_up() {
+  // A slave that never lets go: every retry recovers, nine clocks each,
+  // then the write is given up
+  simI2cHoldSda(255);
+  TEST_ASSERT_FALSE(tunerBusRun(countAttempt));
+  TEST_ASSERT_EQUAL(TUNER_BUS_RETRIES + 1, attempts);
+  TEST_ASSERT_EQUAL(busBefore.sclPulses + TUNER_BUS_RETRIES * (9 + 1), simI2cStats().sclPulses);
+  // SDA never rises, so no STOP gets through
+  TEST_ASSERT_EQUAL(busBefore.stops, simI2cStats().stops);
+
+  const TunerBusStats &bus = tunerBusStats();
+  TEST_ASSERT_EQUAL(before.recoveries + TUNER_BUS_RETRIES, bus.recoveries);
+  TEST_ASSERT_EQUAL(before.failures + 1, bus.failures);
+  TEST_ASSERT_EQUAL(WIRE_TIMEOUT, bus.lastError);
+}
+
+void test_service_recovers_idle_bus() {
+  // Held while nothing writes: the background check finds it
+  simI2cHoldSda(4);
+  simRun(TUNER_BUS_CHECK_INTERVAL + 20);
+  TEST_ASSERT_FALSE(simSdaHeld());
+  TEST_ASSERT_EQUAL(before.recoveries + 1, tunerBusStats().recoveries);
+  TEST_ASSERT_EQUAL(busBefore.stops + 1, simI2cStats().stops);
+
+  // The counters reach /api/diag
+  simRequest("/api/diag");
+  simRun(20);
+  const std::string &body = simLastResponse().body;
+  char recoveries[48];
+  snprintf(recoveries, sizeof(recoveries), "\"recoveries\":%lu,", tunerBusStats().recoveries);
+  TEST_ASSERT_TRUE(body.find(recoveries) != std::string::npos);
+}
+
+int main() {
+  simSerialEcho(false);
+  setup();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_nack_retried);
+  RUN_TEST(test_nack_gives_up);
+  RUN_TEST(test_lost_write_repeated);
+  RUN_TEST(test_held_sda_recovered);
+  RUN_TEST(test_short_hold_fewer_clocks);
+  RUN_TEST(test_stuck_bus_gives_up);
+  RUN_TEST(test_service_recovers_idle_bus);
+  return UNITY_END();
+}
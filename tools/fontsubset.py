@@ -0,0 +1,279 @@
+#
+# FMWebRadio - FM Radio with Web Interface
+# Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#
+
+"""
+Display font subsets
+
+Extracts the U8g2 fonts the firmware draws with from u8g2_fonts.c and
+keeps only the glyphs it actually uses, so the unused ones do not take
+flash. The subsets are written as fontsubset.h, which main.cpp includes
+when FONT_SUBSETS is defined.
+
+As a PlatformIO pre-build script (platformio.ini, extra_scripts) it reads
+the U8g2 library installed for the environment, writes the header to the
+build directory and defines FONT_SUBSETS. If the library sources cannot
+be found, it does nothing and the stock fonts are used.
+
+Each subset is tied to the FONT_* constant main.cpp selects it with.
+Before anything is generated, the text main.cpp draws in those fonts is
+checked against the subsets, and a glyph a subset would drop fails the
+build: the script follows the u8g2.setFont(FONT_*) calls of each function
+in source order and checks the string and character literals drawn
+(u8g2.drawStr(), u8g2.print(), drawFlashStr()), and the digits of printed numbers. Text
+built at run time, such as the frequency, is not seen; the subsets below
+say what they assume about it.
+
+It can also be run by hand, the check alone or with the generation:
+
+    python tools/fontsubset.py --check src/main.cpp
+    python tools/fontsubset.py path/to/u8g2_fonts.c fontsubset.h
+
+U8g2 font layout: a 23 byte header, then the glyphs of encodings 0-255
+in ascending order, each one starting with its encoding and the size of
+the whole glyph record, closed by a record of size 0; the unicode
+glyphs, if any, follow. The header holds the glyph count (byte 0) and
+three big endian offsets, from the end of the header: the first glyph
+at or above 'A' (17), at or above 'a' (19) and the unicode part (21).
+"""
+
+import os
+import re
+import sys
+
+# (FONT_* constant in main.cpp, U8g2 font, subset name, characters to
+# keep); check_source() holds the constants to the text drawn in them
+SUBSETS = [
+    # Status line and signal page: "ON", "OFF", "PRV", "Vol:", "dBuV",
+    # "ST", "FM" and numbers
+    ("FONT_STATUS", "u8g2_font_6x10_tf", "fmradio_font_6x10_status",
+     " 0123456789:BFMNOPRSTVdlou"),
+    # Frequency, as formatted by formatFrequency()
+    ("FONT_FREQUENCY", "u8g2_font_10x20_tn", "fmradio_font_10x20_freq", " .0123456789"),
+]
+
+HEADER_SIZE = 23
+
+
+def c_string_bytes(literals):
+    """Decode a sequence of C string literal bodies to bytes."""
+    out = bytearray()
+    for lit in literals:
+        i = 0
+        while i < len(lit):
+            c = lit[i]
+            if c != "\\":
+                out.append(ord(c))
+                i += 1
+                continue
+            i += 1
+            c = lit[i]
+            if c in "01234567":
+                j = i
+                while j < len(lit) and j < i + 3 and lit[j] in "01234567":
+                    j += 1
+                out.append(int(lit[i:j], 8))
+                i = j
+            elif c == "x":
+                j = i + 1
+                while j < len(lit) and lit[j] in "0123456789abcdefABCDEF":
+                    j += 1
+                out.append(int(lit[i + 1:j], 16) & 0xFF)
+                i = j
+            else:
+                out.append(ord({"n": "\n", "t": "\t", "r": "\r"}.get(c, c)))
+                i += 1
+    return bytes(out)
+
+
+def read_font(source, name):
+    """Get the data of a font from u8g2_fonts.c."""
+    match = re.search(r"const\s+uint8_t\s+" + re.escape(name) +
+                      r"\s*\[\s*(\d+)\s*\][^=]*=(.*?);", source, re.S)
+    if not match:
+        raise ValueError("font %s not found" % name)
+    literals = re.findall(r'"((?:[^"\\]|\\.)*)"', match.group(2), re.S)
+    data = c_string_bytes(literals)
+    if len(data) + 1 != int(match.group(1)):
+        raise ValueError("font %s: %d bytes decoded, %s declared" %
+                         (name, len(data), match.group(1)))
+    return data
+
+
+def subset_font(data, keep):
+    """Keep the 8 bit glyphs listed in keep, return the new font data."""
+    header = bytearray(data[:HEADER_SIZE])
+    pos = HEADER_SIZE
+    glyphs = bytearray()
+    count = 0
+    upper_a = lower_a = None
+    while data[pos + 1] != 0:
+        encoding, size = data[pos], data[pos + 1]
+        if encoding in keep:
+            if upper_a is None and encoding >= ord("A"):
+                upper_a = len(glyphs)
+            if lower_a is None and encoding >= ord("a"):
+                lower_a = len(glyphs)
+            glyphs += data[pos:pos + size]
+            count += 1
+        pos += size
+    removed = (pos - HEADER_SIZE) - len(glyphs)
+    end = len(glyphs)
+
+    def word(offset, value):
+        header[offset] = (value >> 8) & 0xFF
+        header[offset + 1] = value & 0xFF
+
+    unicode = (data[21] << 8) | data[22]
+    header[0] = count
+    # No glyph at or above 'A' or 'a': point at the closing record
+    word(17, end if upper_a is None else upper_a)
+    word(19, end if lower_a is None else lower_a)
+    # The unicode part moves down with the closing record
+    if unicode >= pos - HEADER_SIZE:
+        word(21, unicode - removed)
+    return bytes(header + glyphs + data[pos:])
+
+
+def literal_chars(text):
+    """Characters of the string and character literals in a line of C."""
+    chars = set()
+    for lit in re.findall(r'"((?:[^"\\]|\\.)*)"', text):
+        chars.update(c_string_bytes([lit]).decode("latin-1"))
+    for lit in re.findall(r"'((?:[^'\\]|\\.))'", text):
+        chars.update(c_string_bytes([lit]).decode("latin-1"))
+    return chars
+
+
+def check_source(path):
+    """List the glyphs main.cpp draws in a subset font but the subset drops."""
+    with open(path, encoding="latin-1") as f:
+        lines = f.read().splitlines()
+    source = "\n".join(lines)
+    errors = []
+    subsets = {}
+    for const, _, name, chars in SUBSETS:
+        # The constant must select the subset when FONT_SUBSETS is defined
+        if not re.search(r"\b%s\s*=\s*%s\s*;" % (const, name), source):
+            errors.append("%s: %s is not set to %s" % (path, const, name))
+        subsets[const] = set(chars)
+
+    font = None
+    for number, line in enumerate(lines, 1):
+        # A function definition starts with the default font unknown
+        if re.match(r"[A-Za-z].*\)\s*\{\s*$", line):
+            font = None
+        match = re.search(r"\.setFont\(\s*(FONT_\w+)\s*\)", line)
+        if match:
+            font = match.group(1)
+            continue
+        if font not in subsets:
+            continue
+        match = re.search(r"(?:\bu8g2\.|\b(?=drawFlashStr))"
+                          r"(drawStr|drawUTF8|drawFlashStr|print|println)\s*\((.*)\)\s*;", line)
+        if not match:
+            continue
+        drawn = literal_chars(match.group(2))
+        # A number printed as such
+        if match.group(1).startswith("print") and not re.match(r"\s*(F\(|\"|')", match.group(2)):
+            drawn.update("0123456789")
+        missing = sorted(drawn - subsets[font])
+        if missing:
+            errors.append("%s:%d: %s drops %r" % (path, number, font, "".join(missing)))
+    return errors
+
+
+def generate(fonts_c):
+    """Build the text of fontsubset.h from u8g2_fonts.c."""
+    with open(fonts_c, encoding="latin-1") as f:
+        source = f.read()
+    lines = [
+        "// Generated by tools/fontsubset.py, do not edit",
+        "",
+        "#ifndef FONTSUBSET_H",
+        "#define FONTSUBSET_H",
+        "",
+    ]
+    for _, font, name, chars in SUBSETS:
+        data = read_font(source, font)
+        sub = subset_font(data, set(ord(c) for c in chars))
+        lines.append("// %s: %r, %d of %d bytes" % (font, chars, len(sub) + 1, len(data) + 1))
+        lines.append('const uint8_t %s[%d] U8G2_FONT_SECTION("%s") = {' % (name, len(sub) + 1, name))
+        values = ["0x%02x" % b for b in sub + b"\0"]
+        for i in range(0, len(values), 16):
+            lines.append("  " + ", ".join(values[i:i + 16]) + ",")
+        lines.append("};")
+        lines.append("")
+    lines.append("#endif // FONTSUBSET_H")
+    return "\n".join(lines) + "\n"
+
+
+def write_if_changed(path, text):
+    """Write the file only if it changed, so it does not force a rebuild."""
+    if os.path.exists(path):
+        with open(path) as f:
+            if f.read() == text:
+                return
+    with open(path, "w") as f:
+        f.write(text)
+
+
+def find_fonts_c(libdeps):
+    """Find u8g2_fonts.c among the installed libraries."""
+    for root, _, files in os.walk(libdeps):
+        if "u8g2_fonts.c" in files:
+            return os.path.join(root, "u8g2_fonts.c")
+    return None
+
+
+def pio_pre_build(env):
+    """PlatformIO hook: check the text, generate the subsets for this
+    environment."""
+    errors = check_source(os.path.join(env.subst("$PROJECT_SRC_DIR"), "main.cpp"))
+    if errors:
+        for error in errors:
+            print("fontsubset: %s" % error)
+        print("fontsubset: add the glyphs to SUBSETS in tools/fontsubset.py")
+        env.Exit(1)
+    libdeps = os.path.join(env.subst("$PROJECT_LIBDEPS_DIR"), env.subst("$PIOENV"))
+    fonts_c = find_fonts_c(libdeps)
+    if not fonts_c:
+        print("fontsubset: u8g2_fonts.c not found, using the stock fonts")
+        return
+    out_dir = os.path.join(env.subst("$BUILD_DIR"), "fontsubset")
+    os.makedirs(out_dir, exist_ok=True)
+    try:
+        text = generate(fonts_c)
+    except ValueError as e:
+        print("fontsubset: %s, using the stock fonts" % e)
+        return
+    write_if_changed(os.path.join(out_dir, "fontsubset.h"), text)
+    env.Append(CPPPATH=[out_dir], CPPDEFINES=["FONT_SUBSETS"])
+
+
+if __name__ == "__main__":
+    if len(sys.argv) == 3 and sys.argv[1] == "--check":
+        errors = check_source(sys.argv[2])
+        for error in errors:
+            print(error)
+        sys.exit(1 if errors else 0)
+    if len(sys.argv) != 3:
+        sys.exit("usage: fontsubset.py --check main.cpp | u8g2_fonts.c fontsubset.h")
+    write_if_changed(sys.argv[2], generate(sys.argv[1]))
+else:
+    Import("env")  # noqa: F821 (provided by SCons)
+    pio_pre_build(env)  # noqa: F821
@@ -0,0 +1,215 @@
+#
+# FMWebRadio - FM Radio with Web Interface
+# Copyright (C) 2025 Costin Stroie <costinstroie@eridu.eu.org>
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#
+
+"""
+RDS capture replay
+
+Feeds RDS captures, as downloaded from /api/rdscapture?format=raw (the
+format is described in src/rdscapture.h), group by group into a
+reference decoder of the station name (PS, groups 0A/0B) and radio text
+(RT, groups 2A/2B), and prints one JSON line per capture:
+
+    python tools/rdsreplay.py [--real-time] [--max-errors N] capture.bin ...
+
+    {"file":"capture.bin","frequency":101.1,"records":812,"dropped":0,
+     "seconds":71.2,"groups":790,"groupsPerSecond":11.1,
+     "replayGroupsPerSecond":52000,"psMs":480,"rtMs":4650,
+     "ps":"RADIO 1 ","rt":"..."}
+
+- groupsPerSecond: groups the decoder accepted per second of capture
+- replayGroupsPerSecond: groups decoded per second of wall time; with
+  --real-time the records are fed at their captured pace instead
+- psMs, rtMs: ms from the start of the capture (the tuning) until the
+  PS, or the RT up to its end marker, had all its segments; null if it
+  never completed, or if the capture overwrote its first records
+
+A block is used only if its error level is at most --max-errors (0 to
+3, default 2: up to 5 bit errors corrected). The RDA5807M reports no
+error levels for blocks C and D, those count as clean.
+"""
+
+import argparse
+import json
+import struct
+import sys
+import time
+
+HEADER = struct.Struct("<3sBHBBIHH")
+RECORD = struct.Struct("<H4HBB")
+VERSION = 1
+
+PS_SEGMENTS = 4
+RT_END = 0x0D
+
+
+def read_capture(path):
+    """Read a capture file, return the header fields and the records."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if len(data) < HEADER.size:
+        raise ValueError("%s: too short" % path)
+    magic, version, frequency, size, flags, first, count, dropped = HEADER.unpack_from(data)
+    if magic != b"RDS" or version != VERSION or size != RECORD.size:
+        raise ValueError("%s: not a version %d RDS capture" % (path, VERSION))
+    if len(data) < HEADER.size + count * size:
+        raise ValueError("%s: %d records declared, file truncated" % (path, count))
+    records = []
+    at = first
+    for i in range(count):
+        delta, a, b, c, d, errors, status = RECORD.unpack_from(data, HEADER.size + i * size)
+        if i:
+            at += delta
+        levels = ((errors >> 6) & 3, (errors >> 4) & 3, (errors >> 2) & 3, errors & 3)
+        records.append((at, (a, b, c, d), levels, status))
+    header = {"frequency": frequency, "flags": flags, "first": first,
+              "records": count, "dropped": dropped}
+    return header, records
+
+
+class Decoder:
+    """Reference PS and RT decoder."""
+
+    def __init__(self, max_errors):
+        self.max_errors = max_errors
+        self.ps = [" "] * 8
+        self.ps_seen = set()
+        self.rt = [" "] * 64
+        self.rt_seen = set()
+        self.rt_ab = None
+        self.rt_b = False
+        self.rt_end = None
+        self.groups = 0
+
+    def usable(self, levels, block):
+        return levels[block] <= self.max_errors
+
+    def feed(self, blocks, levels):
+        """Decode one group; False if it was dropped."""
+        if not self.usable(levels, 1):
+            return False
+        b = blocks[1]
+        group, version_b = b >> 12, (b >> 11) & 1
+        self.groups += 1
+        if group == 0 and self.usable(levels, 3):
+            seg = b & 3
+            self.ps[2 * seg:2 * seg + 2] = [chr(blocks[3] >> 8), chr(blocks[3] & 0xFF)]
+            self.ps_seen.add(seg)
+        elif group == 2:
+            ab = (b >> 4) & 1
+            if self.rt_ab is not None and (ab != self.rt_ab or version_b != self.rt_b):
+                # Text A/B flag toggled: a new text starts
+                self.rt = [" "] * 64
+                self.rt_seen.clear()
+                self.rt_end = None
+            self.rt_ab = ab
+            self.rt_b = version_b
+            seg = b & 0xF
+            if version_b:
+                if not self.usable(levels, 3):
+                    return True
+                chars = [blocks[3] >> 8, blocks[3] & 0xFF]
+                pos = 2 * seg
+            else:
+                if not (self.usable(levels, 2) and self.usable(levels, 3)):
+                    return True
+                chars = [blocks[2] >> 8, blocks[2] & 0xFF, blocks[3] >> 8, blocks[3] & 0xFF]
+                pos = 4 * seg
+            for i, ch in enumerate(chars):
+                if ch == RT_END and (self.rt_end is None or pos + i < self.rt_end):
+                    self.rt_end = pos + i
+                self.rt[pos + i] = chr(ch)
+            self.rt_seen.add(seg)
+        return True
+
+    def ps_complete(self):
+        return len(self.ps_seen) == PS_SEGMENTS
+
+    def rt_complete(self):
+        if self.rt_ab is None:
+            return False
+        # 2A segments carry 4 characters of up to 64, 2B 2 of up to 32
+        per_segment = 2 if self.rt_b else 4
+        if self.rt_end is None:
+            needed = 16
+        else:
+            needed = self.rt_end // per_segment + 1
+        return all(s in self.rt_seen for s in range(needed))
+
+    def text(self):
+        end = self.rt_end if self.rt_end is not None else (32 if self.rt_b else 64)
+        rt = "".join(self.rt[:end])
+        return "".join(self.ps), rt.rstrip()
+
+
+def replay(path, max_errors, real_time):
+    """Replay one capture, return its report."""
+    header, records = read_capture(path)
+    decoder = Decoder(max_errors)
+    ps_ms = rt_ms = None
+    start = time.perf_counter()
+    previous = records[0][0] if records else 0
+    for at, blocks, levels, status in records:
+        if real_time:
+            time.sleep((at - previous) / 1000.0)
+            previous = at
+        decoder.feed(blocks, levels)
+        if ps_ms is None and decoder.ps_complete():
+            ps_ms = at
+        if rt_ms is None and decoder.rt_complete():
+            rt_ms = at
+    elapsed = time.perf_counter() - start
+
+    seconds = records[-1][0] / 1000.0 if records else 0.0
+    if header["dropped"]:
+        # The start of the capture is gone, times from tuning are unknown
+        ps_ms = rt_ms = None
+        seconds -= header["first"] / 1000.0
+    ps, rt = decoder.text()
+    return {
+        "file": path,
+        "frequency": header["frequency"] / 100.0,
+        "records": header["records"],
+        "dropped": header["dropped"],
+        "seconds": round(seconds, 1),
+        "groups": decoder.groups,
+        "groupsPerSecond": round(decoder.groups / seconds, 1) if seconds else None,
+        "replayGroupsPerSecond": round(decoder.groups / elapsed) if elapsed else None,
+        "psMs": ps_ms,
+        "rtMs": rt_ms,
+        "ps": ps,
+        "rt": rt,
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Replay RDS captures through a reference decoder")
+    parser.add_argument("captures", nargs="+", help="files from /api/rdscapture?format=raw")
+    parser.add_argument("--real-time", action="store_true", help="feed groups at their captured pace")
+    parser.add_argument("--max-errors", type=int, default=2, choices=range(4),
+                        help="highest block error level used (default 2)")
+    args = parser.parse_args()
+    for path in args.captures:
+        try:
+            report = replay(path, args.max_errors, args.real_time)
+        except (OSError, ValueError) as e:
+            sys.exit("rdsreplay: %s" % e)
+        print(json.dumps(report, separators=(",", ":")))
+
+
+if __name__ == "__main__":
+    main()